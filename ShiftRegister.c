@@ -4,20 +4,56 @@
   SIPO (Serial-In-Parallel-Out; SHIFTREGISTER_OUTPUT-type), PISO (Parallel-In-Serial-Out; SHIFTREGISTER_INPUT-type) and hybrid
   (both SIPO and PISO). In a hybrid configuration both SIPO and PISO registers share the clock and latch lines. 
 
-  As the RP2040 processor is 32 bits the size of the buffers is limited to 4 octets (32 bits). This limits the amount of cascaded
-  shiftregisters to 4. To change to 64 bits:
-  - Change MAX_SIZEINOCTETS to 8
-  - Change "uin32_t" in the code below to "uint64_t".
-
-  A buffersize of 64 bits will work on the RP2040, but will require an additional CPU cycle per request. 
+  As the RP2040 processor is 32 bits, chains of upto 4 octets (32 bits, MAX_SIZEINOCTETS) use the integers InputBuffer and
+  OutputBuffer. Longer chains (e.g. 24 cascaded shiftregisters) are created with ShiftRegisterCreateChain() and use the octet
+  arrays InputOctets and OutputOctets instead; octet 0 is the first octet shifted out/in (MSB first). These arrays can be
+  provided by the caller or are allocated by the library.
 
   Delays for clock and latches can be adjusted by modifying ClockDelayUS and LatchDelayUS to meet the speed of devices;
   for instance gamecontrollers use fast shiftregisters (values can be set to '1') while display controllers like the 
-  HD44780 require a value of 50 usec.
+  HD44780 require a value of 50 usec. For delays shorter than a microsecond use ShiftRegisterSetDelayNS(); the delays are then
+  converted to CPU cycles for the current clk_sys frequency (rounded up, so a delay is never shorter than requested) and
+  implemented with busy-wait loops. Call it again after changing clk_sys.
 
   Output can be inverted by setting InvertOutput to 'true'. This can be useful for controlling relaisboards like the HW-316
   that require the output to be inverted.
 
+  To avoid torn frames when the output is updated from an interrupt or the other core, call ShiftRegisterEnableDoubleBuffer().
+  Applications then write the frame into the back buffer (ShiftRegisterBackBuffer(), SizeInOctets octets) and commit it with
+  ShiftRegisterCommit(), or commit a complete frame with ShiftRegisterCommitFrame(). The committed frame is copied into the
+  output buffer under a lock just before the next transfer starts, so a transfer always shifts a complete frame. Do not write
+  OutputBuffer/OutputOctets directly when double buffering is enabled.
+
+  Set SkipUnchanged to 'true' to skip writing to output registers when the output (and InvertOutput) has not changed since
+  the last value latched. Set ForceUpdate to force the next write anyway (e.g. after a power cycle of the registers); it is
+  cleared after the write. TransfersPerformed and TransfersSkipped count the writes done and skipped. ShiftRegisterReadWrite()
+  always performs the write, as the input has to be read; the output it latches is remembered for the next write.
+
+  Sequences of frames (e.g. animations) are written with ShiftRegisterWriteFrames(): the frames are shifted back-to-back and
+  latched at a fixed interval, without the setup of a separate ShiftRegisterWrite() call per frame.
+
+  The protocol (what to shift and when to latch) is separated from the way the pins are driven: Write, Read, ReadWrite and
+  Fill only call the primitives of a transport (ShiftRegisterTransport: shift bits out, shift bits in, set the latch line).
+  Backend selects one of the built-in transports. Setting Backend to SHIFTREGISTER_BACKEND_SIO makes the library access the
+  SIO registers directly (gpio_set_mask(), gpio_clr_mask(), gpio_xor_mask() and gpio_get_all(); single stores and loads), using
+  the pin masks precomputed by ShiftRegisterCreate(), instead of calling gpio_put/gpio_get per bit; the falling edge of the
+  clock and the next data bit are set with a single store. Other transports (e.g. the simulator
+  in ShiftRegisterSimulator.c) are selected with ShiftRegisterSetTransport().
+
+  The clock and data lines can also be driven by one of the SPI peripherals; define SHIFTREGISTER_ENABLE_SPI before including
+  this file and call ShiftRegisterEnableSPI() after creating the register; see ShiftRegisterSPI.c.
+
+  Define SHIFTREGISTER_ENABLE_COUNTERS before including this file to collect counters per register (ShiftRegisterCounters):
+  transfers per type, bits shifted, time spent in transfers and in delays and the longest transfer. Read them with
+  ShiftRegisterGetCounters() and clear them with ShiftRegisterResetCounters(). Without the define the counters and the code
+  updating them are left out completely. Times are measured with time_us_64(), so with a resolution of 1 usec.
+
+  Define SHIFTREGISTER_ENABLE_TRACE before including this file to record the port changes of the GPIO transport with cycle
+  timestamps and export them as a VCD waveform; see ShiftRegisterTrace.c.
+
+  Optionally, a PIO state machine can be used instead of bit-banging the GPIO ports. Define SHIFTREGISTER_ENABLE_PIO before
+  including this file and call ShiftRegisterEnablePIO() after creating the register; see ShiftRegisterPIO.c.
+
   Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
   Distributed under the GPLv3 license
 
@@ -28,7 +64,17 @@
 #define MyHardwareShiftRegister
 
 #include <stdlib.h>
+#include <string.h>
 #include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "hardware/structs/sio.h"
+#include "hardware/clocks.h"
+#ifdef SHIFTREGISTER_ENABLE_PIO
+#include "hardware/pio.h"
+#endif
+#ifdef SHIFTREGISTER_ENABLE_SPI
+#include "hardware/spi.h"
+#endif
 
 
 #define SHIFTREGISTER_CLOCKDELAY_US        5    // Default value; can be overwritten for slower devices.
@@ -37,125 +83,716 @@
 #define SHIFTREGISTER_OUTPUT               1
 #define SHIFTREGISTER_HYBRID               2
 #define MAX_SIZEINOCTETS                   4    // 4 octets equals 32 bits; the Raspberry Pico RP2040 is 32 bits.
+#define SHIFTREGISTER_BACKEND_GPIO         0    // Bit-banged GPIO ports (default).
+#define SHIFTREGISTER_BACKEND_PIO          1    // PIO state machine; requires SHIFTREGISTER_ENABLE_PIO.
+#define SHIFTREGISTER_BACKEND_SIO          2    // Direct SIO register access with precomputed pin masks.
+#define SHIFTREGISTER_BACKEND_SPI          3    // SPI peripheral; requires SHIFTREGISTER_ENABLE_SPI.
+#define SHIFTREGISTER_BACKEND_CUSTOM       4    // Transport set with ShiftRegisterSetTransport().
+
 
+typedef struct ShiftRegister ShiftRegister;
 
-typedef struct 
+// Instrumentation counters; available when SHIFTREGISTER_ENABLE_COUNTERS is defined.
+typedef struct
+{
+  uint32_t Writes, Reads, ReadWrites, Fills;  // Transfers performed, per type.
+  uint64_t BitsOut, BitsIn;                   // Bits shifted out and in.
+  uint64_t TransferNS, DelayNS;               // Time spent in transfers, and the part of it spent in clock and latch delays.
+  uint32_t MaxLatencyNS;                      // Longest single transfer.
+} ShiftRegisterCounters;
+
+// The primitives used to talk to the register. ShiftOut writes the lowest Bits bits (upto 32) of Value, ShiftIn reads Bits
+// bits; both start with MSB and leave the clock low. Latch sets the latch line. Transports that perform complete transfers
+// themselves (like the PIO backend) set Transfer instead; it is then called for every transfer performed, with Fill set by
+// ShiftRegisterFill(). Committed frames are taken over and unchanged writes are skipped before Transfer is called.
+typedef struct
+{
+  void (*ShiftOut)(ShiftRegister *Register, uint32_t Value, uint8_t Bits);
+  uint32_t (*ShiftIn)(ShiftRegister *Register, uint8_t Bits);
+  void (*Latch)(ShiftRegister *Register, bool High);
+  void (*Transfer)(ShiftRegister *Register, bool Fill, uint8_t FillOctet);
+} ShiftRegisterTransport;
+
+struct ShiftRegister
 {
   // Port numbers used to access the shift register, delays used when talking to the register and the length of the buffer (multiple of 8, max. 64 bits).
-  uint8_t Type, ClockGPIO, DataInGPIO, DataOutGPIO, LatchGPIO, SizeInOctets;  // SizeInOctets max 4 (=32 bits).
+  uint8_t Type, ClockGPIO, DataInGPIO, DataOutGPIO, LatchGPIO;
+  uint16_t SizeInOctets;  // Upto MAX_SIZEINOCTETS (=32 bits) the integer buffers are used, above that the octet arrays.
   uint16_t ClockDelayUS, LatchDelayUS;
 
+  // Sub-microsecond delays, used when ClockDelayUS/LatchDelayUS are 0. Set through ShiftRegisterSetDelayNS().
+  uint32_t ClockDelayNS, LatchDelayNS, ClockDelayCycles, LatchDelayCycles;
+
   // The buffer of the register - max 32 bits (4 cascaded shift registers). 
   uint32_t InputBuffer, OutputBuffer;
 
+  // The buffer of longer chains - SizeInOctets octets each, octet 0 is shifted first. NULL when the integer buffers are used.
+  uint8_t *InputOctets, *OutputOctets;
+  bool OwnsInputOctets, OwnsOutputOctets;  // The octet arrays were allocated by the library.
+
+  // Double buffering; the back buffer is written by the application, the pending buffer holds the last committed frame.
+  uint8_t *BackOctets, *PendingOctets;
+  volatile bool CommitPending;
+  critical_section_t FrameLock;
+
+  // Dirty tracking; the last value latched into output registers and the number of writes performed and skipped.
+  bool SkipUnchanged, ForceUpdate, LastOutputValid, LastInvertOutput;
+  uint32_t LastOutputBuffer;
+  uint8_t *LastOutputOctets;
+  uint32_t TransfersPerformed, TransfersSkipped;
+
   // Option to invert output
   bool InvertOutput;
-} ShiftRegister;
 
+  // Backend used to talk to the register (bit-banged GPIO, SIO, PIO, SPI or a custom transport).
+  uint8_t Backend;
+  const ShiftRegisterTransport *Transport;  // Used with SHIFTREGISTER_BACKEND_CUSTOM.
+  void *TransportData;                      // Data of the custom transport.
 
-void ShiftRegisterPulseLatch(ShiftRegister *Register)
+  // Pin masks for direct SIO access, precomputed when the register is created.
+  uint32_t ClockMask, DataInMask, DataOutMask, LatchMask;
+#ifdef SHIFTREGISTER_ENABLE_PIO
+  PIO PIOInstance;
+  uint8_t PIOStateMachine, PIOProgramOffset, PIOProgramLength;
+#endif
+#ifdef SHIFTREGISTER_ENABLE_SPI
+  spi_inst_t *SPIInstance;
+#endif
+#ifdef SHIFTREGISTER_ENABLE_COUNTERS
+  ShiftRegisterCounters Counters;
+  uint64_t CountersStartUS;
+#endif
+};
+
+
+#ifdef SHIFTREGISTER_ENABLE_COUNTERS
+#define SHIFTREGISTER_COUNT(Register, Field, Value)                   ((Register)->Counters.Field+=(Value))
+#define SHIFTREGISTER_COUNT_BEGIN(Register)                           ((Register)->CountersStartUS=time_us_64())
+#define SHIFTREGISTER_COUNT_END(Register, Transfers, BitsOut, BitsIn)  ShiftRegisterCountTransfer(Register, &(Register)->Counters.Transfers, BitsOut, BitsIn)
+
+// Count a completed transfer and its duration.
+void ShiftRegisterCountTransfer(ShiftRegister *Register, uint32_t *Transfers, uint32_t BitsOut, uint32_t BitsIn)
 {
-  gpio_put(Register->LatchGPIO, 1);
-  sleep_us(Register->LatchDelayUS);
-  gpio_put(Register->LatchGPIO, 0);
+  uint32_t LatencyNS=(uint32_t)((time_us_64()-Register->CountersStartUS)*1000);
+
+  (*Transfers)++;
+  Register->Counters.BitsOut+=BitsOut;
+  Register->Counters.BitsIn+=BitsIn;
+  Register->Counters.TransferNS+=LatencyNS;
+  if(LatencyNS>Register->Counters.MaxLatencyNS)
+    Register->Counters.MaxLatencyNS=LatencyNS;
 }
 
 
-void ShiftRegisterPulseClock(ShiftRegister *Register)
+// Take a snapshot of the counters. Counters of a register used by the other core or an interrupt may be updated halfway.
+void ShiftRegisterGetCounters(ShiftRegister *Register, ShiftRegisterCounters *Snapshot)
 {
-  gpio_put(Register->ClockGPIO, 1);
-  sleep_us(Register->ClockDelayUS);
-  gpio_put(Register->ClockGPIO, 0);
-  sleep_us(Register->ClockDelayUS);
+  memcpy(Snapshot, &Register->Counters, sizeof(ShiftRegisterCounters));
 }
 
 
-void ShiftRegisterWrite(ShiftRegister *Register)
+void ShiftRegisterResetCounters(ShiftRegister *Register)
 {
-  // Write the individual bits from the buffer (integer) to the shift register; starting with MSB
+  memset(&Register->Counters, 0, sizeof(ShiftRegisterCounters));
+}
+#else
+#define SHIFTREGISTER_COUNT(Register, Field, Value)                   ((void)0)
+#define SHIFTREGISTER_COUNT_BEGIN(Register)                           ((void)0)
+#define SHIFTREGISTER_COUNT_END(Register, Transfers, BitsOut, BitsIn)  ((void)0)
+#endif
 
-  uint32_t WriteMask=(1 << ((Register->SizeInOctets*8)-1));
-  for(uint8_t counter=0; counter<(Register->SizeInOctets*8); counter++)
+
+#ifdef SHIFTREGISTER_ENABLE_TRACE
+#include "ShiftRegisterTrace.c"
+#define SHIFTREGISTER_PUT(GPIO, Level)                                ShiftRegisterTracePut(GPIO, Level)
+#define SHIFTREGISTER_GET(GPIO)                                       ShiftRegisterTraceGet(GPIO)
+#else
+#define SHIFTREGISTER_PUT(GPIO, Level)                                gpio_put(GPIO, Level)
+#define SHIFTREGISTER_GET(GPIO)                                       gpio_get(GPIO)
+#endif
+
+
+// Convert a delay in nanoseconds to CPU cycles at the specified clock frequency. Rounded up, so the delay is never shorter
+// than requested; only a delay of 0 returns 0 cycles.
+uint32_t ShiftRegisterNSToCycles(uint32_t DelayNS, uint32_t ClockHz)
+{
+  return((uint32_t)(((uint64_t)DelayNS*ClockHz+999999999u)/1000000000u));
+}
+
+
+// Set the clock and latch delays in nanoseconds; this replaces the delays in microseconds.
+void ShiftRegisterSetDelayNS(ShiftRegister *Register, uint32_t ClockDelayNS, uint32_t LatchDelayNS)
+{
+  uint32_t ClockHz=clock_get_hz(clk_sys);
+
+  Register->ClockDelayUS=0;
+  Register->LatchDelayUS=0;
+  Register->ClockDelayNS=ClockDelayNS;
+  Register->LatchDelayNS=LatchDelayNS;
+  Register->ClockDelayCycles=ShiftRegisterNSToCycles(ClockDelayNS, ClockHz);
+  Register->LatchDelayCycles=ShiftRegisterNSToCycles(LatchDelayNS, ClockHz);
+}
+
+
+// Wait for the delay in microseconds, or the delay in cycles if no delay in microseconds is set.
+void ShiftRegisterDelay(uint16_t DelayUS, uint32_t DelayCycles)
+{
+  if(DelayUS>0)
+    sleep_us(DelayUS);
+  else if(DelayCycles>0)
+    busy_wait_at_least_cycles(DelayCycles);
+}
+
+
+// Wait for the clock delay (half a clock period) of the register.
+void ShiftRegisterClockDelay(ShiftRegister *Register)
+{
+  ShiftRegisterDelay(Register->ClockDelayUS, Register->ClockDelayCycles);
+  SHIFTREGISTER_COUNT(Register, DelayNS, (Register->ClockDelayUS>0?Register->ClockDelayUS*1000u:(Register->ClockDelayCycles>0?Register->ClockDelayNS:0)));
+}
+
+
+// Wait for the latch delay of the register.
+void ShiftRegisterLatchDelay(ShiftRegister *Register)
+{
+  ShiftRegisterDelay(Register->LatchDelayUS, Register->LatchDelayCycles);
+  SHIFTREGISTER_COUNT(Register, DelayNS, (Register->LatchDelayUS>0?Register->LatchDelayUS*1000u:(Register->LatchDelayCycles>0?Register->LatchDelayNS:0)));
+}
+
+
+// Pulse the clock; the first half period gives the data line time to settle before the rising edge (setup time).
+void ShiftRegisterPulseClock(ShiftRegister *Register)
+{
+  ShiftRegisterClockDelay(Register);
+  SHIFTREGISTER_PUT(Register->ClockGPIO, 1);
+  ShiftRegisterClockDelay(Register);
+  SHIFTREGISTER_PUT(Register->ClockGPIO, 0);
+}
+
+
+// GPIO transport; write the lowest Bits bits of Value to the shift register, starting with MSB.
+void ShiftRegisterGPIOShiftOut(ShiftRegister *Register, uint32_t Value, uint8_t Bits)
+{
+  for(uint32_t WriteMask=(1u << (Bits-1)); WriteMask>0; WriteMask>>=1)
   {
-    if(Register->InvertOutput==false)  // Do we need to invert the output?
-      gpio_put(Register->DataOutGPIO, ((WriteMask & Register->OutputBuffer)>0?1:0));
-    else
-      gpio_put(Register->DataOutGPIO, ((WriteMask & Register->OutputBuffer)>0?0:1));
+    SHIFTREGISTER_PUT(Register->DataOutGPIO, ((WriteMask & Value)>0?1:0));
     ShiftRegisterPulseClock(Register);
-    WriteMask=(WriteMask>>1);
   }
-  ShiftRegisterPulseLatch(Register);
 }
 
 
-void ShiftRegisterRead(ShiftRegister *Register)
+// GPIO transport; read Bits bits from the shift register, starting with MSB.
+uint32_t ShiftRegisterGPIOShiftIn(ShiftRegister *Register, uint8_t Bits)
 {
-  // Read the bits into the buffer from the shift register; starting with MSB
-  Register->InputBuffer=0;
+  uint32_t Value=0;
+
+  // The first half period gives the data line time to change after the latch or the previous clock (propagation delay).
+  for(uint8_t counter=0; counter<Bits; counter++)
+  {
+    ShiftRegisterClockDelay(Register);
+    Value<<=1;
+    Value+=(SHIFTREGISTER_GET(Register->DataInGPIO)?1:0);
+    SHIFTREGISTER_PUT(Register->ClockGPIO, 1);
+    ShiftRegisterClockDelay(Register);
+    SHIFTREGISTER_PUT(Register->ClockGPIO, 0);
+  }
+  return(Value);
+}
+
+
+void ShiftRegisterGPIOLatch(ShiftRegister *Register, bool High)
+{
+  SHIFTREGISTER_PUT(Register->LatchGPIO, High);
+}
 
-  // Set the latch port to high
-  gpio_put(Register->LatchGPIO, 1);
 
-  for(uint8_t counter=0; counter<(Register->SizeInOctets*8); counter++)
+// Return an octet of the output buffer, regardless of the size of the chain. Octet 0 is shifted first.
+uint8_t ShiftRegisterGetOutputOctet(ShiftRegister *Register, uint16_t Index)
+{
+  if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+    return(Register->OutputOctets[Index]);
+  return((uint8_t)(Register->OutputBuffer>>((Register->SizeInOctets-1-Index)*8)));
+}
+
+
+// Store an octet in the input buffer, regardless of the size of the chain. Octet 0 is shifted first.
+void ShiftRegisterSetInputOctet(ShiftRegister *Register, uint16_t Index, uint8_t Octet)
+{
+  uint8_t Shift;
+
+  if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+    Register->InputOctets[Index]=Octet;
+  else
   {
-    Register->InputBuffer<<=1;
-    Register->InputBuffer+=(gpio_get(Register->DataInGPIO)?1:0);
-    ShiftRegisterPulseClock(Register);
+    Shift=(Register->SizeInOctets-1-Index)*8;
+    Register->InputBuffer=(Register->InputBuffer & ~(0xffu << Shift)) | ((uint32_t)Octet << Shift);
   }
+}
 
-  // All read; set the latch to low
-  gpio_put(Register->LatchGPIO, 0);
+
+// Modules that process the input 32 inputs at a time (ShiftRegisterDebounce.c, ShiftRegisterEvents.c) divide it in words of
+// upto 4 octets: word w holds octets 4w..4w+3, the first octet in the highest bits. The last word of a chain that is not a
+// multiple of 4 octets holds fewer octets, in the lowest bits; for chains upto MAX_SIZEINOCTETS word 0 has the layout of
+// InputBuffer. Pin n is bit (ShiftRegisterInputWordBits(Register, n / 32) - 1 - n % 32) of word n / 32.
+
+// Number of bits in word Word of the input.
+uint8_t ShiftRegisterInputWordBits(ShiftRegister *Register, uint16_t Word)
+{
+  uint16_t Octets=Register->SizeInOctets-Word*MAX_SIZEINOCTETS;
+
+  return((uint8_t)((Octets>MAX_SIZEINOCTETS?MAX_SIZEINOCTETS:Octets)*8));
 }
 
 
-void ShiftRegisterReadWrite(ShiftRegister *Register)
+// Return word Word of the input, in the lowest ShiftRegisterInputWordBits() bits.
+uint32_t ShiftRegisterGetInputWord(ShiftRegister *Register, uint16_t Word)
 {
-  // Hybrid configuration; first write to the outgoing shift register.
-  uint32_t WriteMask=(1 << ((Register->SizeInOctets*8)-1));
-  for(uint8_t counter=0;counter<(Register->SizeInOctets*8);counter++)
+  uint32_t Value=0;
+  uint16_t Index=Word*MAX_SIZEINOCTETS, Octets=ShiftRegisterInputWordBits(Register, Word)/8;
+
+  if(Register->SizeInOctets<=MAX_SIZEINOCTETS)
+    return(Register->InputBuffer);
+  for(uint16_t counter=0; counter<Octets; counter++)
+    Value=(Value<<8) | Register->InputOctets[Index+counter];
+  return(Value);
+}
+
+
+// Write the lowest Bits bits of Value to the shift register through the SIO registers; starting with MSB. The clock goes
+// low and the next bit is put on the data line in a single store to gpio_togl.
+void ShiftRegisterSIOShiftOut(ShiftRegister *Register, uint32_t Value, uint8_t Bits)
+{
+  uint32_t ClockMask=Register->ClockMask, DataOutMask=Register->DataOutMask, Toggle;
+  uint32_t WriteMask=(1u << (Bits-1)), Current=((sio_hw->gpio_out & DataOutMask)>0?WriteMask:0);
+
+  // Put the first bit on the data line and give it the setup time before the first rising edge.
+  if(((Value ^ Current) & WriteMask)>0)
+  {
+    gpio_xor_mask(DataOutMask);
+    ShiftRegisterClockDelay(Register);
+  }
+  for(; WriteMask>0; WriteMask>>=1)
+  {
+    gpio_set_mask(ClockMask);
+    ShiftRegisterClockDelay(Register);
+
+    // Clock low; toggle the data line at the same time if the next bit differs.
+    Toggle=ClockMask;
+    if(((WriteMask>>1)>0) && ((((Value<<1) ^ Value) & WriteMask)>0))
+      Toggle|=DataOutMask;
+    gpio_xor_mask(Toggle);
+    ShiftRegisterClockDelay(Register);
+  }
+}
+
+
+// Read Bits bits from the shift register through the SIO registers; starting with MSB.
+uint32_t ShiftRegisterSIOShiftIn(ShiftRegister *Register, uint8_t Bits)
+{
+  uint32_t ClockMask=Register->ClockMask, DataInMask=Register->DataInMask, Value=0;
+
+  for(uint8_t counter=0; counter<Bits; counter++)
+  {
+    Value=(Value<<1) | ((gpio_get_all() & DataInMask)>0?1:0);
+    gpio_set_mask(ClockMask);
+    ShiftRegisterClockDelay(Register);
+    gpio_clr_mask(ClockMask);
+    ShiftRegisterClockDelay(Register);
+  }
+  return(Value);
+}
+
+
+void ShiftRegisterSIOLatch(ShiftRegister *Register, bool High)
+{
+  if(High)
+    gpio_set_mask(Register->LatchMask);
+  else
+    gpio_clr_mask(Register->LatchMask);
+}
+
+
+// Enable double buffering; allocates the back and pending buffers, initialized with the current output. Returns false if
+// no memory is available.
+bool ShiftRegisterEnableDoubleBuffer(ShiftRegister *Register)
+{
+  if(Register->BackOctets!=NULL)
+    return(true);
+  Register->BackOctets=(uint8_t *)malloc(Register->SizeInOctets*2);
+  if(Register->BackOctets==NULL)
+    return(false);
+  Register->PendingOctets=Register->BackOctets+Register->SizeInOctets;
+  for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+    Register->BackOctets[counter]=ShiftRegisterGetOutputOctet(Register, counter);
+  critical_section_init(&Register->FrameLock);
+  return(true);
+}
+
+
+// The back buffer of a double buffered register; SizeInOctets octets, octet 0 is shifted first.
+uint8_t *ShiftRegisterBackBuffer(ShiftRegister *Register)
+{
+  return(Register->BackOctets);
+}
+
+
+// Commit a complete frame (SizeInOctets octets); it is written by the next transfer. Safe to call from interrupts and both
+// cores. Later commits before the next transfer replace earlier ones.
+void ShiftRegisterCommitFrame(ShiftRegister *Register, const uint8_t *Frame)
+{
+  critical_section_enter_blocking(&Register->FrameLock);
+  memcpy(Register->PendingOctets, Frame, Register->SizeInOctets);
+  Register->CommitPending=true;
+  critical_section_exit(&Register->FrameLock);
+}
+
+
+// Commit the back buffer; it is written by the next transfer.
+void ShiftRegisterCommit(ShiftRegister *Register)
+{
+  ShiftRegisterCommitFrame(Register, Register->BackOctets);
+}
+
+
+// Copy a frame (SizeInOctets octets, octet 0 is shifted first) into the output buffer.
+void ShiftRegisterLoadFrame(ShiftRegister *Register, const uint8_t *Frame)
+{
+  uint32_t OutputBuffer=0;
+
+  if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+    memcpy(Register->OutputOctets, Frame, Register->SizeInOctets);
+  else
+  {
+    for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+      OutputBuffer=(OutputBuffer<<8) | Frame[counter];
+    Register->OutputBuffer=OutputBuffer;
+  }
+}
+
+
+// Copy the last committed frame (if any) into the output buffer. Called at the start of every transfer.
+void ShiftRegisterSwapFrame(ShiftRegister *Register)
+{
+  if(!Register->CommitPending)
+    return;
+  critical_section_enter_blocking(&Register->FrameLock);
+  ShiftRegisterLoadFrame(Register, Register->PendingOctets);
+  Register->CommitPending=false;
+  critical_section_exit(&Register->FrameLock);
+}
+
+
+// Check if the output has to be written (counting the write as performed or skipped), and remember the value written.
+// Without SkipUnchanged every write is performed and the output is not compared or copied; the last value is then unknown.
+bool ShiftRegisterOutputChanged(ShiftRegister *Register)
+{
+  bool Changed;
+
+  if(!Register->SkipUnchanged)
+  {
+    Register->LastOutputValid=false;
+    Register->ForceUpdate=false;
+    Register->TransfersPerformed++;
+    return(true);
+  }
+  if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+  {
+    Changed=(memcmp(Register->LastOutputOctets, Register->OutputOctets, Register->SizeInOctets)!=0);
+    if(Changed)
+      memcpy(Register->LastOutputOctets, Register->OutputOctets, Register->SizeInOctets);
+  }
+  else
   {
-    // Write the next bit
-    if(Register->InvertOutput==false)  // Do we need to invert the output?
-      gpio_put(Register->DataOutGPIO, ((WriteMask & Register->OutputBuffer)>0?1:0));
+    Changed=(Register->LastOutputBuffer!=Register->OutputBuffer);
+    Register->LastOutputBuffer=Register->OutputBuffer;
+  }
+  Changed|=(!Register->LastOutputValid) || (Register->LastInvertOutput!=Register->InvertOutput) || Register->ForceUpdate;
+  Register->LastInvertOutput=Register->InvertOutput;
+  Register->LastOutputValid=true;
+  Register->ForceUpdate=false;
+  if(Changed)
+    Register->TransfersPerformed++;
+  else
+    Register->TransfersSkipped++;
+  return(Changed);
+}
+
+
+// Count a write that is always performed (ShiftRegisterReadWrite()) and remember the value written, so the next write is
+// compared with the output actually latched.
+void ShiftRegisterOutputWritten(ShiftRegister *Register)
+{
+  if(Register->SkipUnchanged)
+  {
+    if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+      memcpy(Register->LastOutputOctets, Register->OutputOctets, Register->SizeInOctets);
     else
-      gpio_put(Register->DataOutGPIO, ((WriteMask & Register->OutputBuffer)>0?0:1));
-    WriteMask=(WriteMask>>1);
+      Register->LastOutputBuffer=Register->OutputBuffer;
+    Register->LastInvertOutput=Register->InvertOutput;
+  }
+  Register->LastOutputValid=Register->SkipUnchanged;
+  Register->ForceUpdate=false;
+  Register->TransfersPerformed++;
+}
 
-    // Move to the next bit - pulse the clock
-    ShiftRegisterPulseClock(Register);
+
+// The built-in transports.
+const ShiftRegisterTransport ShiftRegisterGPIOTransport={ShiftRegisterGPIOShiftOut, ShiftRegisterGPIOShiftIn, ShiftRegisterGPIOLatch, NULL};
+const ShiftRegisterTransport ShiftRegisterSIOTransport={ShiftRegisterSIOShiftOut, ShiftRegisterSIOShiftIn, ShiftRegisterSIOLatch, NULL};
+
+#ifdef SHIFTREGISTER_ENABLE_PIO
+#include "ShiftRegisterPIO.c"
+#endif
+#ifdef SHIFTREGISTER_ENABLE_SPI
+#include "ShiftRegisterSPI.c"
+#endif
+
+// Transports of the backends, indexed by Backend. Backends that are not enabled fall back to bit-banging.
+const ShiftRegisterTransport *ShiftRegisterTransports[SHIFTREGISTER_BACKEND_CUSTOM]=
+{
+  &ShiftRegisterGPIOTransport,
+#ifdef SHIFTREGISTER_ENABLE_PIO
+  &ShiftRegisterPIOTransport,
+#else
+  &ShiftRegisterGPIOTransport,
+#endif
+  &ShiftRegisterSIOTransport,
+#ifdef SHIFTREGISTER_ENABLE_SPI
+  &ShiftRegisterSPITransport
+#else
+  &ShiftRegisterGPIOTransport
+#endif
+};
+
+
+// Return the transport used by the register.
+const ShiftRegisterTransport *ShiftRegisterGetTransport(ShiftRegister *Register)
+{
+  if(Register->Backend<SHIFTREGISTER_BACKEND_CUSTOM)
+    return(ShiftRegisterTransports[Register->Backend]);
+  return(Register->Transport!=NULL?Register->Transport:&ShiftRegisterGPIOTransport);
+}
+
+
+// Use a custom transport for the register (e.g. a simulator). TransportData is available to the transport as
+// Register->TransportData.
+void ShiftRegisterSetTransport(ShiftRegister *Register, const ShiftRegisterTransport *Transport, void *TransportData)
+{
+  Register->Transport=Transport;
+  Register->TransportData=TransportData;
+  Register->Backend=SHIFTREGISTER_BACKEND_CUSTOM;
+}
+
+
+// Pulse the latch line through the transport specified; used by the transfers that already looked up the transport.
+void ShiftRegisterPulseLatchTransport(ShiftRegister *Register, const ShiftRegisterTransport *Transport)
+{
+  Transport->Latch(Register, true);
+  ShiftRegisterLatchDelay(Register);
+  Transport->Latch(Register, false);
+}
+
+
+void ShiftRegisterPulseLatch(ShiftRegister *Register)
+{
+  ShiftRegisterPulseLatchTransport(Register, ShiftRegisterGetTransport(Register));
+}
+
+
+// Shift a frame of SizeInOctets octets out upto 4 octets at a time, applying InvertOutput. Octet 0 is shifted first.
+void ShiftRegisterShiftOutOctets(ShiftRegister *Register, const ShiftRegisterTransport *Transport, const uint8_t *Frame)
+{
+  uint32_t Value, Invert=(Register->InvertOutput?0xffffffff:0);
+  uint16_t Octets;
+
+  for(uint16_t Index=0; Index<Register->SizeInOctets; Index+=Octets)
+  {
+    Octets=Register->SizeInOctets-Index;
+    if(Octets>MAX_SIZEINOCTETS)
+      Octets=MAX_SIZEINOCTETS;
+    Value=0;
+    for(uint16_t counter=0; counter<Octets; counter++)
+      Value=(Value<<8) | Frame[Index+counter];
+    Transport->ShiftOut(Register, Value ^ Invert, Octets*8);
   }
+}
 
-  // Ready with writing. Set the latch port to high; this also enables reading from the incoming shift register.
-  // Read bits into the buffer starting with MSB
-  gpio_put(Register->LatchGPIO, 1);
-  Register->InputBuffer=0;
 
-  WriteMask=(1 << ((Register->SizeInOctets*8)-1));
-  for(uint8_t counter=0;counter<(Register->SizeInOctets*8);counter++)
+// Shift the complete output buffer out, applying InvertOutput.
+void ShiftRegisterShiftOutBuffer(ShiftRegister *Register, const ShiftRegisterTransport *Transport)
+{
+  uint32_t Value;
+
+  if(Register->SizeInOctets<=MAX_SIZEINOCTETS)
   {
-    // Read the next bit
-    Register->InputBuffer<<=1;
-    Register->InputBuffer+=(gpio_get(Register->DataInGPIO)?1:0);
+    Value=(Register->InvertOutput?~Register->OutputBuffer:Register->OutputBuffer);  // Do we need to invert the output?
+    Transport->ShiftOut(Register, Value, Register->SizeInOctets*8);
+    return;
+  }
+  ShiftRegisterShiftOutOctets(Register, Transport, Register->OutputOctets);
+}
 
-    // Move to the next bit - pulse the clock
-    ShiftRegisterPulseClock(Register);
+
+// Shift the complete input buffer in. Long chains are shifted upto 4 octets at a time.
+void ShiftRegisterShiftInBuffer(ShiftRegister *Register, const ShiftRegisterTransport *Transport)
+{
+  uint32_t Value;
+  uint16_t Octets;
+
+  if(Register->SizeInOctets<=MAX_SIZEINOCTETS)
+  {
+    Register->InputBuffer=Transport->ShiftIn(Register, Register->SizeInOctets*8);
+    return;
+  }
+  for(uint16_t Index=0; Index<Register->SizeInOctets; Index+=Octets)
+  {
+    Octets=Register->SizeInOctets-Index;
+    if(Octets>MAX_SIZEINOCTETS)
+      Octets=MAX_SIZEINOCTETS;
+    Value=Transport->ShiftIn(Register, Octets*8);
+    for(uint16_t counter=Octets; counter>0; counter--)
+    {
+      Register->InputOctets[Index+counter-1]=(uint8_t)Value;
+      Value>>=8;
+    }
   }
+}
+
+
+void ShiftRegisterWrite(ShiftRegister *Register)
+{
+  const ShiftRegisterTransport *Transport=ShiftRegisterGetTransport(Register);
+
+  // Take over the last committed frame; skipped writes are not counted as transfers.
+  ShiftRegisterSwapFrame(Register);
+  if(!ShiftRegisterOutputChanged(Register))
+    return;
+  SHIFTREGISTER_COUNT_BEGIN(Register);
+  if(Transport->Transfer!=NULL)
+    Transport->Transfer(Register, false, 0);
+  else
+  {
+    // Write the bits from the buffer to the shift register, starting with MSB, and latch them.
+    ShiftRegisterShiftOutBuffer(Register, Transport);
+    ShiftRegisterPulseLatchTransport(Register, Transport);
+  }
+  SHIFTREGISTER_COUNT_END(Register, Writes, Register->SizeInOctets*8u, 0);
+}
+
+
+void ShiftRegisterRead(ShiftRegister *Register)
+{
+  const ShiftRegisterTransport *Transport=ShiftRegisterGetTransport(Register);
+
+  SHIFTREGISTER_COUNT_BEGIN(Register);
+  if(Transport->Transfer!=NULL)
+  {
+    Transport->Transfer(Register, false, 0);
+    SHIFTREGISTER_COUNT_END(Register, Reads, 0, Register->SizeInOctets*8u);
+    return;
+  }
+
+  // Set the latch port to high and read the bits into the buffer from the shift register, starting with MSB.
+  Transport->Latch(Register, true);
+  ShiftRegisterShiftInBuffer(Register, Transport);
+
+  // All read; set the latch to low
+  Transport->Latch(Register, false);
+  SHIFTREGISTER_COUNT_END(Register, Reads, 0, Register->SizeInOctets*8u);
+}
+
+
+void ShiftRegisterReadWrite(ShiftRegister *Register)
+{
+  const ShiftRegisterTransport *Transport=ShiftRegisterGetTransport(Register);
+
+  // The input is always read, so the write is never skipped.
+  ShiftRegisterSwapFrame(Register);
+  ShiftRegisterOutputWritten(Register);
+  SHIFTREGISTER_COUNT_BEGIN(Register);
+  if(Transport->Transfer!=NULL)
+  {
+    Transport->Transfer(Register, false, 0);
+    SHIFTREGISTER_COUNT_END(Register, ReadWrites, Register->SizeInOctets*8u, Register->SizeInOctets*8u);
+    return;
+  }
+
+  // Hybrid configuration; first write to the outgoing shift register.
+  ShiftRegisterShiftOutBuffer(Register, Transport);
+
+  // Ready with writing. Set the latch port to high; this also enables reading from the incoming shift register.
+  Transport->Latch(Register, true);
+  ShiftRegisterShiftInBuffer(Register, Transport);
 
   // All read and written; set the latch to low
-  gpio_put(Register->LatchGPIO, 0);
+  Transport->Latch(Register, false);
+  SHIFTREGISTER_COUNT_END(Register, ReadWrites, Register->SizeInOctets*8u, Register->SizeInOctets*8u);
 }
 
 
 // "Fill" the register with either zeroes or ones.
 void ShiftRegisterFill(ShiftRegister *Register, uint8_t FillValue)
 {
-  // Write all zeroes or all ones to the register.
-  for (uint8_t counter=0; counter<(Register->SizeInOctets*8); counter++)
+  const ShiftRegisterTransport *Transport=ShiftRegisterGetTransport(Register);
+  uint32_t Bits=Register->SizeInOctets*8u;
+
+  Register->LastOutputValid=false;  // The next write can not be skipped.
+  SHIFTREGISTER_COUNT_BEGIN(Register);
+  if(Transport->Transfer!=NULL)
   {
-    gpio_put(Register->DataOutGPIO,(FillValue==0?0:1));
-    ShiftRegisterPulseClock(Register);
+    Transport->Transfer(Register, true, (FillValue==0?0x00:0xff));
+    SHIFTREGISTER_COUNT_END(Register, Fills, Register->SizeInOctets*8u, 0);
+    return;
   }
-  ShiftRegisterPulseLatch(Register);
+
+  // Write all zeroes or all ones to the register, 32 bits at a time.
+  for(; Bits>32; Bits-=32)
+    Transport->ShiftOut(Register, (FillValue==0?0:0xffffffff), 32);
+  Transport->ShiftOut(Register, (FillValue==0?0:0xffffffff), (uint8_t)Bits);
+  ShiftRegisterPulseLatchTransport(Register, Transport);
+  SHIFTREGISTER_COUNT_END(Register, Fills, Register->SizeInOctets*8u, 0);
+}
+
+
+// Write FrameCount frames back-to-back, e.g. the steps of an animation. Frames holds the frames one after the other, each
+// SizeInOctets octets with octet 0 shifted first. The frames are latched IntervalUS microseconds apart (0: as fast as
+// possible); the first one right away. The transport and the layout of the chain are resolved once for the sequence, and
+// every frame is shifted in before its latch time, so only the latch pulse waits for the interval. Returns when the last
+// frame is latched; the output buffer then holds the last frame. Unchanged frames are never skipped.
+void ShiftRegisterWriteFrames(ShiftRegister *Register, const uint8_t *Frames, uint32_t FrameCount, uint32_t IntervalUS)
+{
+  const ShiftRegisterTransport *Transport=ShiftRegisterGetTransport(Register);
+  const uint8_t *Frame=Frames;
+  uint64_t LatchUS=0;
+
+  if(FrameCount==0)
+    return;
+  for(uint32_t counter=0; counter<FrameCount; counter++, Frame+=Register->SizeInOctets)
+  {
+    // Transports performing complete transfers (PIO) take the frame from the output buffer.
+    if(Transport->Transfer!=NULL)
+      ShiftRegisterLoadFrame(Register, Frame);
+    else
+      ShiftRegisterShiftOutOctets(Register, Transport, Frame);
+
+    // Wait for the latch time of the frame; a frame that is late is latched immediately.
+    if(counter==0)
+      LatchUS=time_us_64();
+    else
+      while(time_us_64()<LatchUS)
+        tight_loop_contents();
+    LatchUS+=IntervalUS;
+    if(Transport->Transfer!=NULL)
+      Transport->Transfer(Register, false, 0);
+    else
+      ShiftRegisterPulseLatchTransport(Register, Transport);
+    SHIFTREGISTER_COUNT(Register, Writes, 1);
+    SHIFTREGISTER_COUNT(Register, BitsOut, Register->SizeInOctets*8u);
+  }
+  if(Transport->Transfer==NULL)
+    ShiftRegisterLoadFrame(Register, Frame-Register->SizeInOctets);
+  Register->TransfersPerformed+=FrameCount;
+  Register->LastOutputValid=false;  // The next write can not be skipped.
 }
 
 
@@ -174,15 +811,11 @@ void ShiftRegisterUpdate(ShiftRegister *Register)
 }
 
 
-// Create a Shiftregister struct, initialize the specified ports and set the initial value in the register.
-ShiftRegister *ShiftRegisterCreate(uint8_t Type, uint8_t ClockGPIO, uint8_t DataInGPIO, uint8_t DataOutGPIO, uint8_t LatchGPIO, uint32_t InitialValue, uint8_t SizeInOctets)
+// Initialize the specified ports and create the struct; the buffers are set up by the caller.
+ShiftRegister *ShiftRegisterInit(uint8_t Type, uint8_t ClockGPIO, uint8_t DataInGPIO, uint8_t DataOutGPIO, uint8_t LatchGPIO, uint16_t SizeInOctets)
 {
   ShiftRegister *Register;
 
-  // Check if a valid size of the register is requested.
-  if(SizeInOctets>MAX_SIZEINOCTETS)
-    return(NULL);
-
   // Initialize ports and set the pins as output. No error checking for now.
   gpio_init(ClockGPIO);
   gpio_set_dir(ClockGPIO, GPIO_OUT);
@@ -209,11 +842,109 @@ ShiftRegister *ShiftRegisterCreate(uint8_t Type, uint8_t ClockGPIO, uint8_t Data
   Register->DataOutGPIO=DataOutGPIO;
   Register->LatchGPIO=LatchGPIO;
   Register->InputBuffer=0;
-  Register->OutputBuffer=InitialValue;
+  Register->OutputBuffer=0;
+  Register->InputOctets=NULL;
+  Register->OutputOctets=NULL;
+  Register->OwnsInputOctets=false;
+  Register->OwnsOutputOctets=false;
+  Register->BackOctets=NULL;
+  Register->PendingOctets=NULL;
+  Register->CommitPending=false;
+  Register->SkipUnchanged=false;                         // Default value; can be adjusted to skip unchanged writes.
+  Register->ForceUpdate=false;
+  Register->LastOutputValid=false;
+  Register->LastInvertOutput=false;
+  Register->LastOutputBuffer=0;
+  Register->LastOutputOctets=NULL;
+  Register->TransfersPerformed=0;
+  Register->TransfersSkipped=0;
   Register->SizeInOctets=SizeInOctets;
   Register->ClockDelayUS=SHIFTREGISTER_CLOCKDELAY_US;    // Default value; can be adjusted for slower devices.
   Register->LatchDelayUS=SHIFTREGISTER_LATCHDELAY_US;    // Default value; can be adjusted for slower devices.
+  Register->ClockDelayNS=0;
+  Register->LatchDelayNS=0;
+  Register->ClockDelayCycles=0;
+  Register->LatchDelayCycles=0;
   Register->InvertOutput=false;                          // Default value; can be adjusted (e.g. for using relais boards).
+  Register->Backend=SHIFTREGISTER_BACKEND_GPIO;
+  Register->Transport=NULL;
+  Register->TransportData=NULL;
+#ifdef SHIFTREGISTER_ENABLE_COUNTERS
+  ShiftRegisterResetCounters(Register);
+#endif
+  Register->ClockMask=(1u << ClockGPIO);
+  Register->DataInMask=(DataInGPIO!=0?(1u << DataInGPIO):0);
+  Register->DataOutMask=(DataOutGPIO!=0?(1u << DataOutGPIO):0);
+  Register->LatchMask=(1u << LatchGPIO);
+  return(Register);
+}
+
+
+// Create a Shiftregister struct, initialize the specified ports and set the initial value in the register.
+ShiftRegister *ShiftRegisterCreate(uint8_t Type, uint8_t ClockGPIO, uint8_t DataInGPIO, uint8_t DataOutGPIO, uint8_t LatchGPIO, uint32_t InitialValue, uint8_t SizeInOctets)
+{
+  ShiftRegister *Register;
+
+  // Check if a valid size of the register is requested.
+  if(SizeInOctets>MAX_SIZEINOCTETS)
+    return(NULL);
+
+  Register=ShiftRegisterInit(Type, ClockGPIO, DataInGPIO, DataOutGPIO, LatchGPIO, SizeInOctets);
+  Register->OutputBuffer=InitialValue;
+  ShiftRegisterUpdate(Register);
+  return(Register);
+}
+
+
+// Release the struct (and the octet arrays, when allocated by the library).
+void ShiftRegisterDestroy(ShiftRegister *Register)
+{
+#ifdef SHIFTREGISTER_ENABLE_PIO
+  ShiftRegisterDisablePIO(Register);
+#endif
+#ifdef SHIFTREGISTER_ENABLE_SPI
+  ShiftRegisterDisableSPI(Register);
+#endif
+  if(Register->OwnsInputOctets)
+    free(Register->InputOctets);
+  if(Register->OwnsOutputOctets)
+    free(Register->OutputOctets);
+  free(Register->LastOutputOctets);
+  if(Register->BackOctets!=NULL)
+  {
+    critical_section_deinit(&Register->FrameLock);
+    free(Register->BackOctets);
+  }
+  free(Register);
+}
+
+
+// Create a Shiftregister struct for a chain of any length. For chains longer than MAX_SIZEINOCTETS the octet arrays
+// InputOctets and OutputOctets are used; pass NULL to have the library allocate them (zeroed). For shorter chains the
+// integer buffers are used and the arrays are ignored. The current content of OutputOctets is written to the register.
+ShiftRegister *ShiftRegisterCreateChain(uint8_t Type, uint8_t ClockGPIO, uint8_t DataInGPIO, uint8_t DataOutGPIO, uint8_t LatchGPIO, uint16_t SizeInOctets, uint8_t *InputOctets, uint8_t *OutputOctets)
+{
+  ShiftRegister *Register;
+
+  // Check if a valid size of the register is requested.
+  if(SizeInOctets==0)
+    return(NULL);
+
+  Register=ShiftRegisterInit(Type, ClockGPIO, DataInGPIO, DataOutGPIO, LatchGPIO, SizeInOctets);
+  if(SizeInOctets>MAX_SIZEINOCTETS)
+  {
+    // Allocate the arrays not provided by the caller.
+    Register->OwnsInputOctets=(InputOctets==NULL);
+    Register->OwnsOutputOctets=(OutputOctets==NULL);
+    Register->InputOctets=(InputOctets!=NULL?InputOctets:(uint8_t *)calloc(SizeInOctets, 1));
+    Register->OutputOctets=(OutputOctets!=NULL?OutputOctets:(uint8_t *)calloc(SizeInOctets, 1));
+    Register->LastOutputOctets=(uint8_t *)calloc(SizeInOctets, 1);
+    if((Register->InputOctets==NULL) || (Register->OutputOctets==NULL) || (Register->LastOutputOctets==NULL))
+    {
+      ShiftRegisterDestroy(Register);
+      return(NULL);
+    }
+  }
   ShiftRegisterUpdate(Register);
   return(Register);
 }
@@ -0,0 +1,197 @@
+/*
+
+  Compile-time specialized version of the ShiftRegister library for C++ (C++17). The type, pin numbers, length, inversion and
+  delays are template parameters, so the compiler resolves them at compile time: the bit loops are fully unrolled into
+  straight-line code with constant pin masks and no branches on the configuration. It uses the same primitives (gpio_put,
+  gpio_get, sleep_us) and constants as the C API in ShiftRegister.c, and can be used alongside it. The header only contains
+  the template, so it can be included in any number of translation units; ShiftRegister.c, which defines functions, is not
+  included and can be added to one translation unit when the C API is used as well.
+
+  Example (two cascaded 74HC595's on clock GPIO 2, data GPIO 3 and latch GPIO 4):
+
+    ShiftRegisterTemplate::ShiftRegister<SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 16> Leds;
+    Leds.OutputBuffer=0x8001;
+    Leds.Update();
+
+  Chains of upto 64 bits use an unsigned integer of the smallest fitting size as buffer. Longer chains use an array of octets;
+  octet 0 is the first octet shifted (MSB first), like the octet arrays of the C API.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterTemplate
+#define MyHardwareShiftRegisterTemplate
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "pico/stdlib.h"
+
+
+// The constants of the C API; the same definitions as in ShiftRegister.c.
+#ifndef SHIFTREGISTER_INPUT
+#define SHIFTREGISTER_INPUT                0
+#define SHIFTREGISTER_OUTPUT               1
+#define SHIFTREGISTER_HYBRID               2
+#endif
+#ifndef SHIFTREGISTER_CLOCKDELAY_US
+#define SHIFTREGISTER_CLOCKDELAY_US        5
+#define SHIFTREGISTER_LATCHDELAY_US        5
+#endif
+
+
+namespace ShiftRegisterTemplate
+{
+
+// Smallest buffer that fits the number of bits; an array of octets for chains longer than 64 bits.
+template<uint32_t Bits>
+using ShiftRegisterBuffer=typename std::conditional<(Bits<=8), uint8_t,
+                          typename std::conditional<(Bits<=16), uint16_t,
+                          typename std::conditional<(Bits<=32), uint32_t,
+                          typename std::conditional<(Bits<=64), uint64_t, std::array<uint8_t, Bits/8>>::type>::type>::type>::type;
+
+
+template<uint8_t Type, uint8_t ClockGPIO, uint8_t DataInGPIO, uint8_t DataOutGPIO, uint8_t LatchGPIO, uint32_t Bits, bool InvertOutput=false,
+         uint16_t ClockDelayUS=SHIFTREGISTER_CLOCKDELAY_US, uint16_t LatchDelayUS=SHIFTREGISTER_LATCHDELAY_US>
+class ShiftRegister
+{
+  static_assert((Bits>0) && ((Bits%8)==0), "The length of the register must be a multiple of 8 bits");
+  static_assert((Type==SHIFTREGISTER_INPUT) || (Type==SHIFTREGISTER_OUTPUT) || (Type==SHIFTREGISTER_HYBRID), "Unknown type of register");
+
+public:
+  using Buffer=ShiftRegisterBuffer<Bits>;
+  static constexpr bool Octets=(Bits>64);
+
+  // The buffers of the register.
+  Buffer InputBuffer{}, OutputBuffer{};
+
+  // Initialize the ports and set the initial value in the register.
+  explicit ShiftRegister(Buffer InitialValue=Buffer{}) : OutputBuffer(InitialValue)
+  {
+    gpio_init(ClockGPIO);
+    gpio_set_dir(ClockGPIO, GPIO_OUT);
+    if constexpr(Type!=SHIFTREGISTER_OUTPUT)
+    {
+      gpio_init(DataInGPIO);
+      gpio_set_dir(DataInGPIO, GPIO_IN);
+    }
+    if constexpr(Type!=SHIFTREGISTER_INPUT)
+    {
+      gpio_init(DataOutGPIO);
+      gpio_set_dir(DataOutGPIO, GPIO_OUT);
+      gpio_put(DataOutGPIO, 0);
+    }
+    gpio_init(LatchGPIO);
+    gpio_set_dir(LatchGPIO, GPIO_OUT);
+    gpio_put(LatchGPIO, 0);
+    Update();
+  }
+
+  static inline void PulseLatch()
+  {
+    gpio_put(LatchGPIO, 1);
+    Delay<LatchDelayUS>();
+    gpio_put(LatchGPIO, 0);
+  }
+
+  static inline void PulseClock()
+  {
+    gpio_put(ClockGPIO, 1);
+    Delay<ClockDelayUS>();
+    gpio_put(ClockGPIO, 0);
+    Delay<ClockDelayUS>();
+  }
+
+  inline void Write()
+  {
+    WriteBuffer();
+    PulseLatch();
+  }
+
+  inline void Read()
+  {
+    gpio_put(LatchGPIO, 1);
+    ReadBuffer();
+    gpio_put(LatchGPIO, 0);
+  }
+
+  inline void ReadWrite()
+  {
+    WriteBuffer();
+    gpio_put(LatchGPIO, 1);
+    ReadBuffer();
+    gpio_put(LatchGPIO, 0);
+  }
+
+  // "Fill" the register with either zeroes or ones.
+  static inline void Fill(bool FillValue)
+  {
+    gpio_put(DataOutGPIO, FillValue);
+    for(uint32_t counter=0; counter<Bits; counter++)
+      PulseClock();
+    PulseLatch();
+  }
+
+  // Update the shift register, depending on the type of circuit.
+  inline void Update()
+  {
+    if constexpr(Type==SHIFTREGISTER_INPUT)
+      Read();
+    else if constexpr(Type==SHIFTREGISTER_OUTPUT)
+      Write();
+    else
+      ReadWrite();
+  }
+
+private:
+  template<uint16_t DelayUS>
+  static inline void Delay()
+  {
+    if constexpr(DelayUS>0)
+      sleep_us(DelayUS);
+  }
+
+  // Integer buffers are written and read as one unrolled sequence of bits, octet arrays octet by octet (each octet unrolled).
+  inline void WriteBuffer()
+  {
+    if constexpr(Octets)
+      for(uint32_t counter=0; counter<Bits/8; counter++)
+        WriteBits<uint8_t, 8>(OutputBuffer[counter], std::make_index_sequence<8>{});
+    else
+      WriteBits<Buffer, Bits>(OutputBuffer, std::make_index_sequence<Bits>{});
+  }
+
+  inline void ReadBuffer()
+  {
+    if constexpr(Octets)
+      for(uint32_t counter=0; counter<Bits/8; counter++)
+        InputBuffer[counter]=ReadBits<uint8_t>(std::make_index_sequence<8>{});
+    else
+      InputBuffer=ReadBits<Buffer>(std::make_index_sequence<Bits>{});
+  }
+
+  // Write the bits of Value, starting with MSB.
+  template<typename Word, uint32_t Width, size_t... Bit>
+  static inline void WriteBits(Word Value, std::index_sequence<Bit...>)
+  {
+    ((gpio_put(DataOutGPIO, ((Value & (Word(1) << (Width-1-Bit)))!=0)!=InvertOutput), PulseClock()), ...);
+  }
+
+  // Read the bits into a word, starting with MSB.
+  template<typename Word, size_t... Bit>
+  static inline Word ReadBits(std::index_sequence<Bit...>)
+  {
+    Word Value=0;
+
+    ((Value=(Word)((Value << 1) | (gpio_get(DataInGPIO)?1:0)), PulseClock(), (void)Bit), ...);
+    return(Value);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,228 @@
+/*
+
+  Non-blocking updates for the ShiftRegister library. ShiftRegisterUpdateAsync() starts a transfer and returns immediately;
+  a repeating timer interrupt then bit-bangs the clock, data and latch lines, one half clock period per interrupt. Completion
+  is signalled by the (optional) callback, called from the timer interrupt, and by the status that can be polled with
+  ShiftRegisterAsyncBusy().
+
+  Rules while a transfer is running:
+  - The output buffer (OutputBuffer or OutputOctets) is copied when the transfer starts. Changes made after
+    ShiftRegisterUpdateAsync() returned are written by the next transfer.
+  - The input buffer (InputBuffer or InputOctets) is updated in one go when the transfer has completed, just before the
+    callback is called; it never contains a partially read value.
+  - Only one transfer per register can be running; ShiftRegisterUpdateAsync() returns false while busy. Do not call the
+    blocking functions (ShiftRegisterUpdate() etc.) on the same register during a transfer.
+  - The transfer drives the pins with gpio_put()/gpio_get(), so only the GPIO and SIO backends are supported.
+    ShiftRegisterUpdateAsync() returns false if another backend (PIO, SPI or a custom transport) was selected after the
+    struct was created.
+  - With SkipUnchanged set, the next blocking write is always performed after an asynchronous transfer.
+
+  The timer period is ClockDelayUS (minimum 1 usec), so this is meant for relaxing the CPU rather than for speed; use the PIO
+  backend for fast transfers. ShiftRegisterAsyncStep() performs a single step and can also be driven by another timer source.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterAsync
+#define MyHardwareShiftRegisterAsync
+
+#include <string.h>
+#include "ShiftRegister.c"
+
+
+#define SHIFTREGISTER_ASYNC_IDLE           0    // No transfer started yet.
+#define SHIFTREGISTER_ASYNC_BUSY           1    // Transfer in progress.
+#define SHIFTREGISTER_ASYNC_DONE           2    // Last transfer completed.
+
+#define SHIFTREGISTER_ASYNC_PHASE_WRITE    0
+#define SHIFTREGISTER_ASYNC_PHASE_LATCH    1
+#define SHIFTREGISTER_ASYNC_PHASE_READ     2
+#define SHIFTREGISTER_ASYNC_PHASE_FINISH   3
+
+
+typedef struct ShiftRegisterAsync ShiftRegisterAsync;
+typedef void (*ShiftRegisterAsyncCallback)(ShiftRegisterAsync *Async);
+
+struct ShiftRegisterAsync
+{
+  // The register and the status of the transfer.
+  ShiftRegister *Register;
+  volatile uint8_t Status;
+
+  // State of the transfer; the current phase, bit and clock level.
+  uint8_t Phase;
+  uint32_t Bit, Bits;
+  bool ClockHigh;
+
+  // Copy of the output taken at the start and the input collected during the transfer; SizeInOctets octets each.
+  uint8_t *OutputOctets, *InputOctets;
+
+  repeating_timer_t Timer;
+  ShiftRegisterAsyncCallback Callback;
+  void *UserData;
+};
+
+
+// Perform the next step (half clock period) of the transfer. Returns false when the transfer has completed.
+bool ShiftRegisterAsyncStep(ShiftRegisterAsync *Async)
+{
+  ShiftRegister *Register=Async->Register;
+
+  switch(Async->Phase)
+  {
+    case SHIFTREGISTER_ASYNC_PHASE_WRITE:  // Clock low and put the next bit on the data line, then clock high.
+                                           if(!Async->ClockHigh)
+                                           {
+                                             gpio_put(Register->ClockGPIO, 0);
+                                             gpio_put(Register->DataOutGPIO, ((Async->OutputOctets[Async->Bit/8] & (0x80 >> (Async->Bit%8)))>0));
+                                           }
+                                           else
+                                           {
+                                             gpio_put(Register->ClockGPIO, 1);
+                                             if(++Async->Bit==Async->Bits)
+                                               Async->Phase=SHIFTREGISTER_ASYNC_PHASE_LATCH;
+                                           }
+                                           Async->ClockHigh=!Async->ClockHigh;
+                                           break;
+    case SHIFTREGISTER_ASYNC_PHASE_LATCH:  // Clock low and latch high; updates the outputs and enables reading.
+                                           gpio_put(Register->ClockGPIO, 0);
+                                           gpio_put(Register->LatchGPIO, 1);
+                                           Async->Phase=(Register->Type==SHIFTREGISTER_OUTPUT?SHIFTREGISTER_ASYNC_PHASE_FINISH:SHIFTREGISTER_ASYNC_PHASE_READ);
+                                           Async->Bit=0;
+                                           Async->ClockHigh=true;  // The clock is already low; read the first bit right away.
+                                           if(Async->Phase==SHIFTREGISTER_ASYNC_PHASE_FINISH)
+                                             break;
+                                           // fall through
+    case SHIFTREGISTER_ASYNC_PHASE_READ:   // Clock low and read the next bit, then clock high.
+                                           if(Async->ClockHigh)
+                                           {
+                                             gpio_put(Register->ClockGPIO, 0);
+                                             if(gpio_get(Register->DataInGPIO))
+                                               Async->InputOctets[Async->Bit/8]|=(uint8_t)(0x80 >> (Async->Bit%8));
+                                           }
+                                           else
+                                           {
+                                             gpio_put(Register->ClockGPIO, 1);
+                                             if(++Async->Bit==Async->Bits)
+                                               Async->Phase=SHIFTREGISTER_ASYNC_PHASE_FINISH;
+                                           }
+                                           Async->ClockHigh=!Async->ClockHigh;
+                                           break;
+    case SHIFTREGISTER_ASYNC_PHASE_FINISH: // Clock and latch low; store the input and signal completion.
+                                           gpio_put(Register->ClockGPIO, 0);
+                                           gpio_put(Register->LatchGPIO, 0);
+                                           if(Register->Type!=SHIFTREGISTER_OUTPUT)
+                                             for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+                                               ShiftRegisterSetInputOctet(Register, counter, Async->InputOctets[counter]);
+                                           Register->LastOutputValid=false;
+                                           Async->Status=SHIFTREGISTER_ASYNC_DONE;
+                                           if(Async->Callback!=NULL)
+                                             Async->Callback(Async);
+                                           return(false);
+  }
+  return(true);
+}
+
+
+// Timer interrupt; perform the next step of the transfer.
+bool ShiftRegisterAsyncTimerCallback(repeating_timer_t *Timer)
+{
+  return(ShiftRegisterAsyncStep((ShiftRegisterAsync *)Timer->user_data));
+}
+
+
+// Prepare a transfer: copy the output buffer and reset the state. Used by ShiftRegisterUpdateAsync() and by applications that
+// drive ShiftRegisterAsyncStep() themselves. Returns false while a transfer is running or if the register no longer uses the
+// GPIO or SIO backend.
+bool ShiftRegisterAsyncBegin(ShiftRegisterAsync *Async, ShiftRegisterAsyncCallback Callback, void *UserData)
+{
+  ShiftRegister *Register=Async->Register;
+  uint8_t Octet;
+
+  if(Async->Status==SHIFTREGISTER_ASYNC_BUSY)
+    return(false);
+  if((Register->Backend!=SHIFTREGISTER_BACKEND_GPIO) && (Register->Backend!=SHIFTREGISTER_BACKEND_SIO))
+    return(false);
+  ShiftRegisterSwapFrame(Register);
+  for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+  {
+    Octet=ShiftRegisterGetOutputOctet(Register, counter);
+    Async->OutputOctets[counter]=(Register->InvertOutput?~Octet:Octet);
+  }
+  memset(Async->InputOctets, 0, Register->SizeInOctets);
+  Async->Bits=Register->SizeInOctets*8u;
+  Async->Bit=0;
+  Async->ClockHigh=false;
+  Async->Phase=(Register->Type==SHIFTREGISTER_INPUT?SHIFTREGISTER_ASYNC_PHASE_LATCH:SHIFTREGISTER_ASYNC_PHASE_WRITE);
+  Async->Callback=Callback;
+  Async->UserData=UserData;
+  Async->Status=SHIFTREGISTER_ASYNC_BUSY;
+  return(true);
+}
+
+
+// Start a transfer, depending on the type of circuit, and return immediately. Callback (may be NULL) is called from the timer
+// interrupt when the transfer has completed. Returns false if a transfer is still running, the register does not use the
+// GPIO or SIO backend or no timer is available.
+bool ShiftRegisterUpdateAsync(ShiftRegisterAsync *Async, ShiftRegisterAsyncCallback Callback, void *UserData)
+{
+  ShiftRegister *Register=Async->Register;
+  uint16_t HalfPeriodUS=(Register->ClockDelayUS>0?Register->ClockDelayUS:1);
+
+  if(!ShiftRegisterAsyncBegin(Async, Callback, UserData))
+    return(false);
+  if(!add_repeating_timer_us(-(int64_t)HalfPeriodUS, ShiftRegisterAsyncTimerCallback, Async, &Async->Timer))
+  {
+    Async->Status=SHIFTREGISTER_ASYNC_IDLE;
+    return(false);
+  }
+  return(true);
+}
+
+
+// Returns true while a transfer is running.
+bool ShiftRegisterAsyncBusy(ShiftRegisterAsync *Async)
+{
+  return(Async->Status==SHIFTREGISTER_ASYNC_BUSY);
+}
+
+
+// Create the struct for asynchronous transfers on the register. Only the GPIO and SIO backends are supported; returns NULL
+// for registers using other backends or if no memory is available.
+ShiftRegisterAsync *ShiftRegisterAsyncCreate(ShiftRegister *Register)
+{
+  ShiftRegisterAsync *Async;
+
+  if((Register->Backend!=SHIFTREGISTER_BACKEND_GPIO) && (Register->Backend!=SHIFTREGISTER_BACKEND_SIO))
+    return(NULL);
+  Async=(ShiftRegisterAsync *)malloc(sizeof(ShiftRegisterAsync));
+  if(Async==NULL)
+    return(NULL);
+  Async->OutputOctets=(uint8_t *)malloc(Register->SizeInOctets*2);
+  if(Async->OutputOctets==NULL)
+  {
+    free(Async);
+    return(NULL);
+  }
+  Async->Register=Register;
+  Async->Status=SHIFTREGISTER_ASYNC_IDLE;
+  Async->InputOctets=Async->OutputOctets+Register->SizeInOctets;
+  Async->Callback=NULL;
+  Async->UserData=NULL;
+  return(Async);
+}
+
+
+// Release the struct; waits for a running transfer to complete.
+void ShiftRegisterAsyncDestroy(ShiftRegisterAsync *Async)
+{
+  while(ShiftRegisterAsyncBusy(Async))
+    tight_loop_contents();
+  free(Async->OutputOctets);
+  free(Async);
+}
+
+#endif
@@ -0,0 +1,246 @@
+/*
+
+  Binary Code Modulation (BCM) for the ShiftRegister library; brightness control of LEDs on the outputs of 74HC595 chains.
+  Every output gets an 8 bit intensity (0 is off, 255 is fully on). The intensities are converted into 8 bit planes: plane n
+  is a frame holding bit n of every intensity. The planes are latched one after the other and plane n stays on the outputs
+  for BaseUS << n microseconds, so an output is on for Intensity/255 of the cycle of 255 * BaseUS microseconds.
+
+  The planes are shown by a repeating timer interrupt, started with ShiftRegisterBCMStart(). Each interrupt latches the plane
+  that was shifted in during the previous one and then shifts in the next plane, so only the latch pulse is tied to the
+  timer and the on-times are not affected by the time needed for shifting. BaseUS must be longer than shifting one frame
+  (ShiftRegisterWrite() without the latch), otherwise the short planes are stretched. Transports that perform complete
+  transfers themselves (PIO) shift and latch in the interrupt.
+
+  Output n is bit (0x80 >> (n % 8)) of octet n / 8 of the frame, as in the octet layout of the register (octet 0 is shifted
+  first). Set the intensities with ShiftRegisterBCMSetIntensity() or write them to Intensities directly, then call
+  ShiftRegisterBCMCommit(). The bit planes are computed by the commit (8 outputs at a time, with an 8x8 bit-matrix transpose)
+  and taken over by the interrupt at the start of the next cycle, so a cycle never mixes old and new intensities. Plane 0 of
+  the next cycle is shifted in when the last plane is latched, so a commit while the last plane is shown (the second half
+  of the cycle) is taken over a cycle later.
+  ShiftRegisterBCMStep() shows the next plane and can also be driven by another timer source.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterBCM
+#define MyHardwareShiftRegisterBCM
+
+#include "ShiftRegister.c"
+
+
+#define SHIFTREGISTER_BCM_PLANES           8
+#define SHIFTREGISTER_BCM_BASE_US          8    // Default duration of plane 0; a cycle of 2040 usec (490 Hz).
+
+
+typedef struct
+{
+  ShiftRegister *Register;
+  const ShiftRegisterTransport *Transport;
+
+  // Intensity per output; SizeInOctets*8 values.
+  uint8_t *Intensities;
+
+  // Bit planes shown by the interrupt, the planes of the last commit and the planes being built by a commit;
+  // SHIFTREGISTER_BCM_PLANES frames each. The pending planes are swapped in at the start of the next cycle.
+  uint8_t *Planes, *PendingPlanes, *BuildPlanes;
+  volatile bool CommitPending;
+  critical_section_t Lock;
+
+  // The plane shifted in and waiting for its latch pulse, and the duration of plane 0.
+  uint8_t Plane;
+  uint32_t BaseUS;
+
+  repeating_timer_t Timer;
+  bool Running;
+} ShiftRegisterBCM;
+
+
+// Transpose an 8x8 bit-matrix; row 0 is the highest octet and column 0 the highest bit of every row.
+uint64_t ShiftRegisterTranspose8(uint64_t Matrix)
+{
+  uint64_t Swap;
+
+  Swap=(Matrix ^ (Matrix>>7)) & 0x00aa00aa00aa00aaull;
+  Matrix^=Swap ^ (Swap<<7);
+  Swap=(Matrix ^ (Matrix>>14)) & 0x0000cccc0000ccccull;
+  Matrix^=Swap ^ (Swap<<14);
+  Swap=(Matrix ^ (Matrix>>28)) & 0x00000000f0f0f0f0ull;
+  Matrix^=Swap ^ (Swap<<28);
+  return(Matrix);
+}
+
+
+// Convert the intensities into bit planes. Every octet of the frame is the transpose of 8 intensities; row n of the
+// transposed matrix holds bit 7-n of the intensities.
+void ShiftRegisterBCMBuildPlanes(ShiftRegisterBCM *BCM, uint8_t *Planes)
+{
+  uint16_t SizeInOctets=BCM->Register->SizeInOctets;
+  uint64_t Matrix;
+
+  for(uint16_t Octet=0; Octet<SizeInOctets; Octet++)
+  {
+    Matrix=0;
+    for(uint8_t counter=0; counter<8; counter++)
+      Matrix=(Matrix<<8) | BCM->Intensities[Octet*8+counter];
+    Matrix=ShiftRegisterTranspose8(Matrix);
+    for(uint8_t Plane=0; Plane<SHIFTREGISTER_BCM_PLANES; Plane++)
+      Planes[Plane*SizeInOctets+Octet]=(uint8_t)(Matrix>>(Plane*8));
+  }
+}
+
+
+// Set the intensity of an output; shown after the next ShiftRegisterBCMCommit().
+void ShiftRegisterBCMSetIntensity(ShiftRegisterBCM *BCM, uint16_t Output, uint8_t Intensity)
+{
+  if(Output<BCM->Register->SizeInOctets*8u)
+    BCM->Intensities[Output]=Intensity;
+}
+
+
+// Compute the bit planes of the intensities; they are shown from the start of the next cycle. Safe to call from the other
+// core (one core committing at a time); later commits within a cycle replace earlier ones. The planes are built in a buffer
+// the interrupt never touches, so the lock is only held to exchange it with the pending planes.
+void ShiftRegisterBCMCommit(ShiftRegisterBCM *BCM)
+{
+  uint8_t *Planes;
+
+  ShiftRegisterBCMBuildPlanes(BCM, BCM->BuildPlanes);
+  critical_section_enter_blocking(&BCM->Lock);
+  Planes=BCM->PendingPlanes;
+  BCM->PendingPlanes=BCM->BuildPlanes;
+  BCM->BuildPlanes=Planes;
+  BCM->CommitPending=true;
+  critical_section_exit(&BCM->Lock);
+}
+
+
+// Take over the planes of the last commit, if any.
+void ShiftRegisterBCMSwapPlanes(ShiftRegisterBCM *BCM)
+{
+  uint8_t *Planes;
+
+  if(!BCM->CommitPending)
+    return;
+  critical_section_enter_blocking(&BCM->Lock);
+  Planes=BCM->Planes;
+  BCM->Planes=BCM->PendingPlanes;
+  BCM->PendingPlanes=Planes;
+  BCM->CommitPending=false;
+  critical_section_exit(&BCM->Lock);
+}
+
+
+// Shift the plane in without latching it; transports performing complete transfers take it from the output buffer.
+void ShiftRegisterBCMShiftPlane(ShiftRegisterBCM *BCM, uint8_t Plane)
+{
+  ShiftRegister *Register=BCM->Register;
+  uint8_t *Frame=BCM->Planes+Plane*Register->SizeInOctets;
+
+  if(BCM->Transport->Transfer!=NULL)
+    ShiftRegisterLoadFrame(Register, Frame);
+  else
+    ShiftRegisterShiftOutOctets(Register, BCM->Transport, Frame);
+}
+
+
+// Latch the plane shifted in by the previous step and shift in the next one. Returns the time in microseconds the latched
+// plane has to stay on the outputs.
+uint32_t ShiftRegisterBCMStep(ShiftRegisterBCM *BCM)
+{
+  uint8_t Plane=BCM->Plane;
+
+  if(BCM->Transport->Transfer!=NULL)
+    BCM->Transport->Transfer(BCM->Register, false, 0);
+  else
+    ShiftRegisterPulseLatchTransport(BCM->Register, BCM->Transport);
+  SHIFTREGISTER_COUNT(BCM->Register, Writes, 1);
+  SHIFTREGISTER_COUNT(BCM->Register, BitsOut, BCM->Register->SizeInOctets*8u);
+
+  // New intensities start with plane 0.
+  BCM->Plane=(Plane+1) % SHIFTREGISTER_BCM_PLANES;
+  if(BCM->Plane==0)
+    ShiftRegisterBCMSwapPlanes(BCM);
+  ShiftRegisterBCMShiftPlane(BCM, BCM->Plane);
+  return(BCM->BaseUS << Plane);
+}
+
+
+// Timer interrupt; show the next plane and schedule the interrupt for the plane after it. A negative delay makes the timer
+// count from the previous interrupt, so the on-times do not drift.
+bool ShiftRegisterBCMTimerCallback(repeating_timer_t *Timer)
+{
+  Timer->delay_us=-(int64_t)ShiftRegisterBCMStep((ShiftRegisterBCM *)Timer->user_data);
+  return(true);
+}
+
+
+// Start showing the intensities from a repeating timer interrupt. Returns false if already running or no timer is available.
+bool ShiftRegisterBCMStart(ShiftRegisterBCM *BCM)
+{
+  int64_t DelayUS;
+
+  if(BCM->Running)
+    return(false);
+  BCM->Transport=ShiftRegisterGetTransport(BCM->Register);
+  BCM->Plane=0;
+  ShiftRegisterBCMSwapPlanes(BCM);
+  ShiftRegisterBCMShiftPlane(BCM, 0);
+  DelayUS=-(int64_t)ShiftRegisterBCMStep(BCM);
+  if(!add_repeating_timer_us(DelayUS, ShiftRegisterBCMTimerCallback, BCM, &BCM->Timer))
+    return(false);
+  BCM->Running=true;
+  return(true);
+}
+
+
+// Stop the interrupt; the outputs keep the last plane shown. Use ShiftRegisterFill() to switch them off.
+void ShiftRegisterBCMStop(ShiftRegisterBCM *BCM)
+{
+  if(!BCM->Running)
+    return;
+  cancel_repeating_timer(&BCM->Timer);
+  BCM->Running=false;
+  BCM->Register->LastOutputValid=false;  // The next write can not be skipped.
+}
+
+
+// Create the BCM engine for an output register, with all intensities 0. BaseUS is the duration of plane 0 (0 for the
+// default). Returns NULL for input registers or if no memory is available.
+ShiftRegisterBCM *ShiftRegisterBCMCreate(ShiftRegister *Register, uint32_t BaseUS)
+{
+  ShiftRegisterBCM *BCM;
+  uint32_t PlanesSize=SHIFTREGISTER_BCM_PLANES*Register->SizeInOctets;
+
+  if(Register->Type==SHIFTREGISTER_INPUT)
+    return(NULL);
+  BCM=(ShiftRegisterBCM *)calloc(1, sizeof(ShiftRegisterBCM));
+  if(BCM==NULL)
+    return(NULL);
+  BCM->Intensities=(uint8_t *)calloc(Register->SizeInOctets*8u+PlanesSize*3, 1);
+  if(BCM->Intensities==NULL)
+  {
+    free(BCM);
+    return(NULL);
+  }
+  BCM->Planes=BCM->Intensities+Register->SizeInOctets*8u;
+  BCM->PendingPlanes=BCM->Planes+PlanesSize;
+  BCM->BuildPlanes=BCM->PendingPlanes+PlanesSize;
+  BCM->Register=Register;
+  BCM->BaseUS=(BaseUS>0?BaseUS:SHIFTREGISTER_BCM_BASE_US);
+  critical_section_init(&BCM->Lock);
+  return(BCM);
+}
+
+
+void ShiftRegisterBCMDestroy(ShiftRegisterBCM *BCM)
+{
+  ShiftRegisterBCMStop(BCM);
+  critical_section_deinit(&BCM->Lock);
+  free(BCM->Intensities);
+  free(BCM);
+}
+
+#endif
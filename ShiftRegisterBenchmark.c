@@ -0,0 +1,387 @@
+/*
+
+  Benchmarks for the ShiftRegister library. The results are printed as CSV (one header line, one line per measurement), so
+  they can be compared between versions to track regressions.
+
+  - Update: ShiftRegisterWrite(), ShiftRegisterRead(), ShiftRegisterReadWrite() and ShiftRegisterFill() on chains of 8 to
+    1024 bits, at several clock/latch delays and per transport. Reported are the mean, minimum and maximum latency of a
+    single call, the jitter (maximum minus minimum), the throughput (bits of the chain per second) and cpu_busy_proxy: the
+    latency without delays divided by the latency at the delay setting. That is not a measured CPU load (the delays are
+    busy waits as well); it estimates the part of the call spent toggling ports rather than waiting, and is left empty
+    where there is no reference.
+  - Frames: writing a sequence of BENCHMARK_FRAMES frames with ShiftRegisterWriteFrames() compared to loading every frame
+    into the output buffer and calling ShiftRegisterWrite() in a loop, reported per frame. On the Pico the difference is the
+    per-call overhead; on Linux only the port accesses take virtual time, so both rows are the same there. The paced rows
+    (delay_ns is the interval) show how accurately the frames are latched at the interval.
+  - Transpose: time needed to convert the 32 bit outputs of 8, 16 and 32 chains into one GPIO word per clock pulse, as used
+    by ShiftRegisterGroupUpdateSliced(); the word-wide 32x32 transpose compared to a loop moving individual bits.
+
+  On the Pico, build with pico_stdlib and check the output on the serial console / USB; time is measured with the SysTick
+  timer at clk_sys. On Linux, define SHIFTREGISTER_HOST and build with -Ihost -pthread; time is then the virtual time of the
+  host simulator (ShiftRegisterHostSimulator.c) and the GPIO and SIO transports are measured. The transpose does not consume
+  simulated time, so on Linux it is timed with the monotonic clock of the host (including the time to read that clock); those
+  figures are only comparable between runs on the same machine. The clock column tells which clock timed the row (systick,
+  virtual or monotonic). The virtual time is deterministic, so the jitter of virtual rows only reflects differences between
+  the calls themselves (e.g. a first call changing more lines, or waiting for the interval in the paced frame rows); jitter
+  caused by the hardware (interrupts, flash cache) only shows up on the Pico.
+
+    cc -DSHIFTREGISTER_HOST -Ihost -pthread -o benchmark ShiftRegisterBenchmark.c
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include <stdio.h>
+#ifdef SHIFTREGISTER_HOST
+#include <time.h>
+#include "ShiftRegisterHostSimulator.c"
+#else
+#include "hardware/structs/systick.h"
+#endif
+#include "ShiftRegisterGroup.c"
+
+
+#define BENCHMARK_CLOCK_GPIO               2
+#define BENCHMARK_DATAOUT_GPIO             3
+#define BENCHMARK_LATCH_GPIO               4
+#define BENCHMARK_DATAIN_GPIO              5
+#define BENCHMARK_UPDATE_ROUNDS            20
+#define BENCHMARK_TRANSPOSE_ROUNDS         1000
+#define BENCHMARK_LENGTHS                  8    // Chain lengths 8, 16, 32 ... 1024 bits.
+#define BENCHMARK_DELAYS                   4
+#define BENCHMARK_OPERATIONS               4
+#define BENCHMARK_FRAMES                   16
+#define BENCHMARK_FRAME_INTERVAL_US        50
+
+
+typedef struct
+{
+  uint32_t Rounds;
+  uint64_t TotalNS, MinNS, MaxNS;
+} BenchmarkResult;
+
+typedef struct
+{
+  const char *Name;
+  void (*Call)(void *Context);
+} BenchmarkOperation;
+
+
+// Delay settings in nanoseconds; 0 must be first, as it is the reference for cpu_busy_proxy.
+static const uint32_t BenchmarkDelaysNS[BENCHMARK_DELAYS]={0, 100, 1000, 5000};
+
+
+#ifdef SHIFTREGISTER_HOST
+// Time with the clock of the host instead of the virtual time; for code that does not consume simulated time.
+static bool BenchmarkWallClock=false;
+
+
+// Virtual time of the simulator, or the monotonic clock of the host.
+uint64_t BenchmarkStart(void)
+{
+  struct timespec Now;
+
+  if(!BenchmarkWallClock)
+    return(ShiftRegisterHostTimeNS());
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return((uint64_t)Now.tv_sec*1000000000u+(uint64_t)Now.tv_nsec);
+}
+
+
+uint64_t BenchmarkElapsedNS(uint64_t Start)
+{
+  return(BenchmarkStart()-Start);
+}
+#else
+// SysTick as a free running 24 bits down counter at the processor clock; calls must take less than 2^24 cycles.
+uint64_t BenchmarkStart(void)
+{
+  return(systick_hw->cvr);
+}
+
+
+uint64_t BenchmarkElapsedNS(uint64_t Start)
+{
+  return((((uint64_t)((Start-systick_hw->cvr) & 0x00ffffff))*1000000000u)/clock_get_hz(clk_sys));
+}
+#endif
+
+
+// Call the operation Rounds times and collect the latency of the individual calls.
+void BenchmarkRun(void (*Call)(void *Context), void *Context, uint32_t Rounds, BenchmarkResult *Result)
+{
+  uint64_t Start, ElapsedNS;
+
+  Result->Rounds=Rounds;
+  Result->TotalNS=Result->MaxNS=0;
+  Result->MinNS=UINT64_MAX;
+  for(uint32_t counter=0; counter<Rounds; counter++)
+  {
+    Start=BenchmarkStart();
+    Call(Context);
+    ElapsedNS=BenchmarkElapsedNS(Start);
+    Result->TotalNS+=ElapsedNS;
+    if(ElapsedNS<Result->MinNS)
+      Result->MinNS=ElapsedNS;
+    if(ElapsedNS>Result->MaxNS)
+      Result->MaxNS=ElapsedNS;
+  }
+}
+
+
+// Name of the clock timing the measurements, for the clock column.
+const char *BenchmarkClock(void)
+{
+#ifdef SHIFTREGISTER_HOST
+  return(BenchmarkWallClock?"monotonic":"virtual");
+#else
+  return("systick");
+#endif
+}
+
+
+// Print a line of the CSV output. ReferenceNS is the mean latency without delays; 0 leaves cpu_busy_proxy empty.
+void BenchmarkPrint(const char *Benchmark, const char *Transport, const char *Operation, uint32_t Bits, uint32_t DelayNS,
+                    BenchmarkResult *Result, uint64_t ReferenceNS)
+{
+  uint64_t MeanNS=Result->TotalNS/Result->Rounds;
+
+  printf("%s,%s,%s,%s,%lu,%lu,%lu,%llu,%llu,%llu,%llu,%llu,", Benchmark, Transport, Operation, BenchmarkClock(),
+         (unsigned long)Bits, (unsigned long)DelayNS, (unsigned long)Result->Rounds, (unsigned long long)MeanNS,
+         (unsigned long long)Result->MinNS, (unsigned long long)Result->MaxNS,
+         (unsigned long long)(Result->MaxNS-Result->MinNS), (unsigned long long)(MeanNS>0?((uint64_t)Bits*1000000000u)/MeanNS:0));
+  if((ReferenceNS>0) && (MeanNS>0))
+    printf("%.3f", (double)ReferenceNS/(double)MeanNS);
+  printf("\n");
+}
+
+
+// The operations measured on the registers.
+void BenchmarkWrite(void *Context)
+{
+  ShiftRegisterWrite((ShiftRegister *)Context);
+}
+
+
+void BenchmarkRead(void *Context)
+{
+  ShiftRegisterRead((ShiftRegister *)Context);
+}
+
+
+void BenchmarkReadWrite(void *Context)
+{
+  ShiftRegisterReadWrite((ShiftRegister *)Context);
+}
+
+
+void BenchmarkFill(void *Context)
+{
+  ShiftRegisterFill((ShiftRegister *)Context, 1);
+}
+
+
+static const BenchmarkOperation BenchmarkOperations[BENCHMARK_OPERATIONS]=
+{
+  {"write", BenchmarkWrite}, {"read", BenchmarkRead}, {"readwrite", BenchmarkReadWrite}, {"fill", BenchmarkFill}
+};
+
+
+// Set the clock and latch delays; whole microseconds use ClockDelayUS/LatchDelayUS, shorter delays ShiftRegisterSetDelayNS().
+void BenchmarkSetDelay(ShiftRegister *Register, uint32_t DelayNS)
+{
+  ShiftRegisterSetDelayNS(Register, DelayNS, DelayNS);
+  if((DelayNS>0) && ((DelayNS%1000)==0))
+  {
+    Register->ClockDelayUS=(uint16_t)(DelayNS/1000);
+    Register->LatchDelayUS=(uint16_t)(DelayNS/1000);
+  }
+}
+
+
+// Measure all operations on all chain lengths and delays for the transport (backend).
+void BenchmarkUpdate(const char *Transport, uint8_t Backend)
+{
+  ShiftRegister *Register;
+  BenchmarkResult Result;
+  uint64_t ReferenceNS=0;
+  uint16_t SizeInOctets;
+
+  for(uint8_t length=0; length<BENCHMARK_LENGTHS; length++)
+  {
+    SizeInOctets=(uint16_t)(1u << length);
+    Register=ShiftRegisterCreateChain(SHIFTREGISTER_HYBRID, BENCHMARK_CLOCK_GPIO, BENCHMARK_DATAIN_GPIO, BENCHMARK_DATAOUT_GPIO,
+                                      BENCHMARK_LATCH_GPIO, SizeInOctets, NULL, NULL);
+    if(Register==NULL)
+      continue;
+    Register->Backend=Backend;
+    for(uint8_t operation=0; operation<BENCHMARK_OPERATIONS; operation++)
+      for(uint8_t delay=0; delay<BENCHMARK_DELAYS; delay++)
+      {
+        BenchmarkSetDelay(Register, BenchmarkDelaysNS[delay]);
+        BenchmarkRun(BenchmarkOperations[operation].Call, Register, BENCHMARK_UPDATE_ROUNDS, &Result);
+        if(delay==0)
+          ReferenceNS=Result.TotalNS/Result.Rounds;
+        BenchmarkPrint("update", Transport, BenchmarkOperations[operation].Name, SizeInOctets*8u, BenchmarkDelaysNS[delay],
+                       &Result, ReferenceNS);
+      }
+    ShiftRegisterDestroy(Register);
+  }
+}
+
+
+typedef struct
+{
+  ShiftRegister *Register;
+  uint8_t *Frames;
+  uint32_t IntervalUS;
+} BenchmarkFramesContext;
+
+
+// Write the frames as one sequence.
+void BenchmarkWriteFrames(void *Context)
+{
+  BenchmarkFramesContext *Frames=(BenchmarkFramesContext *)Context;
+
+  ShiftRegisterWriteFrames(Frames->Register, Frames->Frames, BENCHMARK_FRAMES, Frames->IntervalUS);
+}
+
+
+// Reference; a separate ShiftRegisterWrite() per frame.
+void BenchmarkWriteLoop(void *Context)
+{
+  BenchmarkFramesContext *Frames=(BenchmarkFramesContext *)Context;
+
+  for(uint32_t counter=0; counter<BENCHMARK_FRAMES; counter++)
+  {
+    ShiftRegisterLoadFrame(Frames->Register, Frames->Frames+counter*Frames->Register->SizeInOctets);
+    ShiftRegisterWrite(Frames->Register);
+  }
+}
+
+
+// Measure a sequence of frames written both ways on chains of 8, 32 and 256 bits; the results are per frame.
+void BenchmarkFrames(const char *Transport, uint8_t Backend)
+{
+  const uint16_t Lengths[3]={1, 4, 32};
+  BenchmarkFramesContext Frames;
+  BenchmarkResult Result;
+
+  for(uint8_t length=0; length<3; length++)
+  {
+    Frames.Register=ShiftRegisterCreateChain(SHIFTREGISTER_OUTPUT, BENCHMARK_CLOCK_GPIO, 0, BENCHMARK_DATAOUT_GPIO,
+                                             BENCHMARK_LATCH_GPIO, Lengths[length], NULL, NULL);
+    if(Frames.Register==NULL)
+      continue;
+    Frames.Frames=(uint8_t *)malloc(BENCHMARK_FRAMES*Lengths[length]);
+    if(Frames.Frames==NULL)
+    {
+      ShiftRegisterDestroy(Frames.Register);
+      continue;
+    }
+    Frames.Register->Backend=Backend;
+    ShiftRegisterSetDelayNS(Frames.Register, 0, 0);
+    for(uint32_t counter=0; counter<BENCHMARK_FRAMES*Lengths[length]; counter++)
+      Frames.Frames[counter]=(uint8_t)(counter*0x9du);
+    for(uint8_t operation=0; operation<3; operation++)
+    {
+      Frames.IntervalUS=(operation==2?BENCHMARK_FRAME_INTERVAL_US:0);
+      BenchmarkRun((operation==0?BenchmarkWriteLoop:BenchmarkWriteFrames), &Frames, BENCHMARK_UPDATE_ROUNDS, &Result);
+      Result.TotalNS/=BENCHMARK_FRAMES;
+      Result.MinNS/=BENCHMARK_FRAMES;
+      Result.MaxNS/=BENCHMARK_FRAMES;
+      BenchmarkPrint("frames", Transport, (operation==0?"writeloop":"writeframes"), Lengths[length]*8u, Frames.IntervalUS*1000u,
+                     &Result, 0);
+    }
+    free(Frames.Frames);
+    ShiftRegisterDestroy(Frames.Register);
+  }
+}
+
+
+typedef struct
+{
+  uint32_t Outputs[32], Words[32];
+  uint8_t Count;
+} BenchmarkTransposeContext;
+
+
+// Reference; build the words per clock pulse by moving individual bits.
+void BenchmarkTransposePerBit(void *Context)
+{
+  BenchmarkTransposeContext *Transpose=(BenchmarkTransposeContext *)Context;
+
+  for(uint8_t Clock=0; Clock<32; Clock++)
+  {
+    Transpose->Words[Clock]=0;
+    for(uint8_t Chain=0; Chain<Transpose->Count; Chain++)
+      Transpose->Words[Clock]|=((Transpose->Outputs[Chain]>>(31-Clock)) & 1) << Chain;
+  }
+}
+
+
+// Word-wide; chain n goes into row 31-n of the matrix, as in ShiftRegisterGroupSliceOutput().
+void BenchmarkTransposeWordWide(void *Context)
+{
+  BenchmarkTransposeContext *Transpose=(BenchmarkTransposeContext *)Context;
+
+  for(uint8_t Row=0; Row<32; Row++)
+    Transpose->Words[Row]=0;
+  for(uint8_t Chain=0; Chain<Transpose->Count; Chain++)
+    Transpose->Words[31-Chain]=Transpose->Outputs[Chain];
+  ShiftRegisterTranspose32(Transpose->Words);
+}
+
+
+// Measure both transposes for 8, 16 and 32 chains.
+void BenchmarkTranspose(void)
+{
+  const uint8_t Chains[3]={8, 16, 32};
+  BenchmarkTransposeContext Transpose;
+  BenchmarkResult Result;
+
+#ifdef SHIFTREGISTER_HOST
+  BenchmarkWallClock=true;
+#endif
+  for(uint8_t Chain=0; Chain<32; Chain++)
+    Transpose.Outputs[Chain]=0x9e3779b9u*(Chain+1);
+  for(uint8_t counter=0; counter<3; counter++)
+  {
+    Transpose.Count=Chains[counter];
+    BenchmarkRun(BenchmarkTransposePerBit, &Transpose, BENCHMARK_TRANSPOSE_ROUNDS, &Result);
+    BenchmarkPrint("transpose", "-", "perbit", Chains[counter]*32u, 0, &Result, 0);
+    BenchmarkRun(BenchmarkTransposeWordWide, &Transpose, BENCHMARK_TRANSPOSE_ROUNDS, &Result);
+    BenchmarkPrint("transpose", "-", "wordwide", Chains[counter]*32u, 0, &Result, 0);
+  }
+#ifdef SHIFTREGISTER_HOST
+  BenchmarkWallClock=false;
+#endif
+}
+
+
+int main()
+{
+#ifndef SHIFTREGISTER_HOST
+  stdio_init_all();
+  sleep_ms(2000);
+
+  // Start SysTick as a free running 24 bits down counter at the processor clock.
+  systick_hw->csr=0;
+  systick_hw->rvr=0x00ffffff;
+  systick_hw->cvr=0;
+  systick_hw->csr=0x5;  // Enable, processor clock, no interrupt.
+#endif
+
+  printf("benchmark,transport,operation,clock,bits,delay_ns,rounds,mean_ns,min_ns,max_ns,jitter_ns,bits_per_second,cpu_busy_proxy\n");
+  BenchmarkUpdate("gpio", SHIFTREGISTER_BACKEND_GPIO);
+  BenchmarkFrames("gpio", SHIFTREGISTER_BACKEND_GPIO);
+  BenchmarkUpdate("sio", SHIFTREGISTER_BACKEND_SIO);
+  BenchmarkFrames("sio", SHIFTREGISTER_BACKEND_SIO);
+  BenchmarkTranspose();
+#ifndef SHIFTREGISTER_HOST
+  while(true)
+    tight_loop_contents();
+#endif
+  return(0);
+}
@@ -0,0 +1,131 @@
+/*
+
+  Automatic calibration of the clock speed of a hybrid chain, using the ShiftRegister library. The outputs of the SIPO
+  registers must be looped back to the inputs of the PISO registers (output bit n wired to input bit n), so that every
+  pattern written can be read back on the next transfer.
+
+  ShiftRegisterCalibrate() writes a set of test patterns at decreasing clock delays and reads them back. The shortest delay at
+  which all patterns are read back correctly is increased by a safety margin and stored in the register with
+  ShiftRegisterSetDelayNS() (used for both the clock and the latch). The content of OutputBuffer/OutputOctets is restored and
+  written to the chain afterwards.
+
+  The calibration applies to the GPIO and SIO backends; other backends use their own bit rate.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterCalibrate
+#define MyHardwareShiftRegisterCalibrate
+
+#include <string.h>
+#include "ShiftRegister.c"
+
+
+#define SHIFTREGISTER_CALIBRATE_STEP       75   // Every step the delay is reduced to this percentage of the previous delay.
+#define SHIFTREGISTER_CALIBRATE_PATTERNS   6
+
+
+// Test patterns; every octet in the chain is rotated by its position, so swapped octets are detected as well.
+static const uint8_t ShiftRegisterCalibratePatterns[SHIFTREGISTER_CALIBRATE_PATTERNS]={0x00, 0xff, 0xaa, 0x55, 0x01, 0x7f};
+
+
+// Write all test patterns at the current delay and check if they are read back. Returns true if all patterns match.
+bool ShiftRegisterCalibrateCheck(ShiftRegister *Register)
+{
+  uint8_t Octet;
+
+  for(uint8_t pattern=0; pattern<SHIFTREGISTER_CALIBRATE_PATTERNS; pattern++)
+  {
+    // Fill the buffer with the pattern.
+    Register->OutputBuffer=0;
+    for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+    {
+      Octet=ShiftRegisterCalibratePatterns[pattern];
+      Octet=(uint8_t)((Octet << (counter%8)) | (Octet >> ((8-(counter%8))%8)));
+      if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+        Register->OutputOctets[counter]=Octet;
+      else
+        Register->OutputBuffer=(Register->OutputBuffer<<8) | Octet;
+    }
+
+    // The PISO registers load their inputs while the latch is low, so the pattern is read back by the second transfer.
+    ShiftRegisterReadWrite(Register);
+    ShiftRegisterReadWrite(Register);
+    if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+    {
+      if(memcmp(Register->InputOctets, Register->OutputOctets, Register->SizeInOctets)!=0)
+        return(false);
+    }
+    else if(Register->InputBuffer!=Register->OutputBuffer)
+      return(false);
+  }
+  return(true);
+}
+
+
+// Find the shortest reliable clock delay, starting at StartDelayNS, and store it (increased by MarginPercent) in the register;
+// the result is available in ClockDelayNS. Returns false if the register is not a hybrid chain using the GPIO or SIO backend,
+// or already fails at StartDelayNS; the original delays are kept in that case.
+bool ShiftRegisterCalibrate(ShiftRegister *Register, uint32_t StartDelayNS, uint8_t MarginPercent)
+{
+  uint16_t ClockDelayUS=Register->ClockDelayUS, LatchDelayUS=Register->LatchDelayUS;
+  uint32_t ClockDelayNS=Register->ClockDelayNS, LatchDelayNS=Register->LatchDelayNS;
+  uint32_t OutputBuffer=Register->OutputBuffer, DelayNS=StartDelayNS, FastestNS=0;
+  uint8_t *OutputOctets=NULL;
+  bool InvertOutput=Register->InvertOutput, Passed=false;
+
+  if((Register->Type!=SHIFTREGISTER_HYBRID) || ((Register->Backend!=SHIFTREGISTER_BACKEND_GPIO) && (Register->Backend!=SHIFTREGISTER_BACKEND_SIO)))
+    return(false);
+
+  // Save the output buffer; the patterns are written without inversion.
+  if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+  {
+    OutputOctets=(uint8_t *)malloc(Register->SizeInOctets);
+    if(OutputOctets==NULL)
+      return(false);
+    memcpy(OutputOctets, Register->OutputOctets, Register->SizeInOctets);
+  }
+  Register->InvertOutput=false;
+
+  // Step the delay down until the patterns are no longer read back correctly.
+  while(true)
+  {
+    ShiftRegisterSetDelayNS(Register, DelayNS, DelayNS);
+    if(!ShiftRegisterCalibrateCheck(Register))
+      break;
+    Passed=true;
+    FastestNS=DelayNS;
+    if(DelayNS==0)
+      break;
+    DelayNS=(uint32_t)(((uint64_t)DelayNS*SHIFTREGISTER_CALIBRATE_STEP)/100);
+  }
+
+  // Store the fastest setting with the safety margin, or restore the original delays.
+  if(Passed)
+  {
+    FastestNS=(uint32_t)(((uint64_t)FastestNS*(100+MarginPercent))/100);
+    ShiftRegisterSetDelayNS(Register, FastestNS, FastestNS);
+  }
+  else
+  {
+    ShiftRegisterSetDelayNS(Register, ClockDelayNS, LatchDelayNS);
+    Register->ClockDelayUS=ClockDelayUS;
+    Register->LatchDelayUS=LatchDelayUS;
+  }
+
+  // Restore the output buffer and write it to the chain.
+  Register->InvertOutput=InvertOutput;
+  if(OutputOctets!=NULL)
+  {
+    memcpy(Register->OutputOctets, OutputOctets, Register->SizeInOctets);
+    free(OutputOctets);
+  }
+  Register->OutputBuffer=OutputBuffer;
+  ShiftRegisterUpdate(Register);
+  return(Passed);
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+
+  Debouncing of PISO (74HC165) inputs for the ShiftRegister library. Mechanical buttons bounce; the input buffer returns the
+  raw levels of every read. ShiftRegisterDebounceUpdate() takes the input buffer after a read as a sample and only accepts a
+  new level of an input after it has been seen in PressThreshold (for a change to 1) or ReleaseThreshold (for a change to 0)
+  consecutive samples.
+
+  The number of consecutive samples is kept per input in vertical counters: bit n of the words Counters[0..3] together form
+  the 4 bit counter of input n. All inputs of a word are counted with a handful of logic operations per sample, regardless
+  of how many of the 32 inputs are bouncing, so the cost only grows with the number of words (one per 4 octets of the chain).
+  Thresholds are 1 (no debouncing) to 15 samples; with a read every 2 msec a threshold of 5 gives 10 msec.
+
+  A counter only counts while its input differs from the debounced level and restarts when the new level is accepted, so it
+  never passes the threshold; ShiftRegisterDebounceSetThresholds() restarts all counters, so changes in progress are counted
+  against the new thresholds.
+
+  The debounced levels are in Stable, one word per 4 octets of the chain in the layout of ShiftRegisterGetInputWord().
+  Changed holds the inputs that changed in the last update. Pin n is bit (0x80 >> (n % 8)) of octet n / 8 of the chain
+  (octet 0 is shifted in first); use ShiftRegisterDebounceGet() to read a pin. The first update takes the sample as the
+  debounced level.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterDebounce
+#define MyHardwareShiftRegisterDebounce
+
+#include "ShiftRegister.c"
+
+
+#define SHIFTREGISTER_DEBOUNCE_PLANES      4    // Bits of the vertical counters.
+#define SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD 15
+
+
+typedef struct
+{
+  ShiftRegister *Register;
+  uint16_t Words;
+
+  // Number of consecutive samples needed to accept a new level.
+  uint8_t PressThreshold, ReleaseThreshold;
+
+  // Debounced levels, inputs changed by the last update and the vertical counters; Words words each.
+  uint32_t *Stable, *Changed, *Counters[SHIFTREGISTER_DEBOUNCE_PLANES];
+  bool Primed;
+} ShiftRegisterDebounce;
+
+
+// Mask of the inputs whose counter equals Threshold.
+static inline uint32_t ShiftRegisterDebounceMatch(uint32_t C0, uint32_t C1, uint32_t C2, uint32_t C3, uint8_t Threshold)
+{
+  return(((Threshold & 1)?C0:~C0) & ((Threshold & 2)?C1:~C1) & ((Threshold & 4)?C2:~C2) & ((Threshold & 8)?C3:~C3));
+}
+
+
+// Debounce one word of samples.
+void ShiftRegisterDebounceWord(ShiftRegisterDebounce *Debounce, uint16_t Word, uint32_t Sample)
+{
+  uint32_t C0=Debounce->Counters[0][Word], C1=Debounce->Counters[1][Word], C2=Debounce->Counters[2][Word];
+  uint32_t C3=Debounce->Counters[3][Word], Delta=Sample ^ Debounce->Stable[Word], Carry, Next, Accept;
+
+  // Inputs at their debounced level restart; the others count one more sample (a ripple-carry increment of all counters).
+  C0&=Delta;
+  C1&=Delta;
+  C2&=Delta;
+  C3&=Delta;
+  Carry=Delta;
+  Next=C0 & Carry;
+  C0^=Carry;
+  Carry=Next;
+  Next=C1 & Carry;
+  C1^=Carry;
+  Carry=Next;
+  Next=C2 & Carry;
+  C2^=Carry;
+  C3^=Next;
+
+  // Accept the new level of the inputs that reached their threshold and restart their counters.
+  Accept=Delta & ((ShiftRegisterDebounceMatch(C0, C1, C2, C3, Debounce->PressThreshold) & Sample) |
+                  (ShiftRegisterDebounceMatch(C0, C1, C2, C3, Debounce->ReleaseThreshold) & ~Sample));
+  Debounce->Stable[Word]^=Accept;
+  Debounce->Changed[Word]=Accept;
+  Debounce->Counters[0][Word]=C0 & ~Accept;
+  Debounce->Counters[1][Word]=C1 & ~Accept;
+  Debounce->Counters[2][Word]=C2 & ~Accept;
+  Debounce->Counters[3][Word]=C3 & ~Accept;
+}
+
+
+// Take the input buffer of the register (after ShiftRegisterRead() or ShiftRegisterReadWrite()) as the next sample.
+void ShiftRegisterDebounceUpdate(ShiftRegisterDebounce *Debounce)
+{
+  for(uint16_t Word=0; Word<Debounce->Words; Word++)
+  {
+    if(Debounce->Primed)
+      ShiftRegisterDebounceWord(Debounce, Word, ShiftRegisterGetInputWord(Debounce->Register, Word));
+    else
+    {
+      Debounce->Stable[Word]=ShiftRegisterGetInputWord(Debounce->Register, Word);
+      Debounce->Changed[Word]=0;
+    }
+  }
+  Debounce->Primed=true;
+}
+
+
+// Debounced level of a pin.
+bool ShiftRegisterDebounceGet(ShiftRegisterDebounce *Debounce, uint16_t Pin)
+{
+  uint16_t Word=Pin/32;
+
+  if(Pin>=Debounce->Register->SizeInOctets*8u)
+    return(false);
+  return(((Debounce->Stable[Word]>>(ShiftRegisterInputWordBits(Debounce->Register, Word)-1-(Pin%32))) & 1)>0);
+}
+
+
+// Set the thresholds (1 to SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD samples) for changes to 1 and to 0. The counters restart;
+// a counter above a lowered threshold would otherwise never match it.
+void ShiftRegisterDebounceSetThresholds(ShiftRegisterDebounce *Debounce, uint8_t PressThreshold, uint8_t ReleaseThreshold)
+{
+  Debounce->PressThreshold=(PressThreshold<1?1:(PressThreshold>SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD?SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD:PressThreshold));
+  Debounce->ReleaseThreshold=(ReleaseThreshold<1?1:(ReleaseThreshold>SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD?SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD:ReleaseThreshold));
+  for(uint8_t Plane=0; Plane<SHIFTREGISTER_DEBOUNCE_PLANES; Plane++)
+    memset(Debounce->Counters[Plane], 0, Debounce->Words*sizeof(uint32_t));
+}
+
+
+// Create the debouncer for the inputs of a register. Returns NULL for output registers or if no memory is available.
+ShiftRegisterDebounce *ShiftRegisterDebounceCreate(ShiftRegister *Register, uint8_t PressThreshold, uint8_t ReleaseThreshold)
+{
+  ShiftRegisterDebounce *Debounce;
+  uint16_t Words=(Register->SizeInOctets+MAX_SIZEINOCTETS-1)/MAX_SIZEINOCTETS;
+
+  if(Register->Type==SHIFTREGISTER_OUTPUT)
+    return(NULL);
+  Debounce=(ShiftRegisterDebounce *)calloc(1, sizeof(ShiftRegisterDebounce));
+  if(Debounce==NULL)
+    return(NULL);
+  Debounce->Stable=(uint32_t *)calloc(Words*(2+SHIFTREGISTER_DEBOUNCE_PLANES), sizeof(uint32_t));
+  if(Debounce->Stable==NULL)
+  {
+    free(Debounce);
+    return(NULL);
+  }
+  Debounce->Changed=Debounce->Stable+Words;
+  for(uint8_t Plane=0; Plane<SHIFTREGISTER_DEBOUNCE_PLANES; Plane++)
+    Debounce->Counters[Plane]=Debounce->Changed+Words*(Plane+1);
+  Debounce->Register=Register;
+  Debounce->Words=Words;
+  ShiftRegisterDebounceSetThresholds(Debounce, PressThreshold, ReleaseThreshold);
+  return(Debounce);
+}
+
+
+void ShiftRegisterDebounceDestroy(ShiftRegisterDebounce *Debounce)
+{
+  free(Debounce->Stable);
+  free(Debounce);
+}
+
+#endif
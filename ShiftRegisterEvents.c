@@ -0,0 +1,260 @@
+/*
+
+  Input events for the ShiftRegister library. Instead of comparing InputBuffer with the previous read themselves,
+  applications call ShiftRegisterEventsUpdate() after every read and take events from a queue with ShiftRegisterEventsPoll():
+  - SHIFTREGISTER_EVENT_PRESS:     the input became active.
+  - SHIFTREGISTER_EVENT_RELEASE:   the input became inactive; DurationMS is the time it was held.
+  - SHIFTREGISTER_EVENT_LONGPRESS: the input is held for LongPressMS (once per press; 0 disables long presses).
+  - SHIFTREGISTER_EVENT_REPEAT:    the input is still held, every RepeatMS after the long press (0 disables repeats).
+  Set ActiveLow for inputs that are active at level 0 (e.g. buttons with pull-up resistors).
+
+  The input is handled 32 inputs at a time: edges are found with a single XOR per word and only the inputs that changed are
+  visited. Long presses and repeats are scheduled with a single deadline (the earliest of all held inputs), so an update
+  without changes costs one comparison per 4 octets of the chain and one comparison of the time, also for chains of
+  hundreds of inputs. Use the debounced levels of ShiftRegisterDebounce.c (Stable) to filter bouncing buttons.
+
+  The queue holds SHIFTREGISTER_EVENTS_QUEUESIZE events; when it is full new events are dropped and counted in Dropped. It is
+  a single-producer/single-consumer ring, so updates may run in a timer interrupt while the application polls. Pin n is bit
+  (0x80 >> (n % 8)) of octet n / 8 of the chain (octet 0 is shifted in first). Inputs that are active at the first update
+  only generate a release event.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterEvents
+#define MyHardwareShiftRegisterEvents
+
+#include "ShiftRegister.c"
+#include "hardware/sync.h"
+
+
+#define SHIFTREGISTER_EVENTS_QUEUESIZE     32   // Size of the event queue; must be a power of 2.
+#define SHIFTREGISTER_EVENT_PRESS          0
+#define SHIFTREGISTER_EVENT_RELEASE        1
+#define SHIFTREGISTER_EVENT_LONGPRESS      2
+#define SHIFTREGISTER_EVENT_REPEAT         3
+
+
+typedef struct
+{
+  uint16_t Pin;
+  uint8_t Type;
+  uint32_t TimeMS;      // Time of the update that generated the event (time_us_64() in msec).
+  uint32_t DurationMS;  // Time the input has been held; 0 for press events.
+} ShiftRegisterEvent;
+
+typedef struct
+{
+  ShiftRegister *Register;
+  uint16_t Words;
+
+  // Settings.
+  uint32_t LongPressMS, RepeatMS;
+  bool ActiveLow;
+
+  // Active inputs, inputs waiting for a long press or repeat and inputs that had their long press, per word; the time of the
+  // press and of the next long press or repeat, per input.
+  uint32_t *Active, *Waiting, *LongPressed;
+  uint32_t *PressedMS, *NextMS;
+
+  // Earliest NextMS of the held inputs, if Scheduled.
+  uint32_t DeadlineMS;
+  bool Scheduled, Primed;
+
+  // Event queue; Head is written by the updates, Tail by the application.
+  ShiftRegisterEvent Events[SHIFTREGISTER_EVENTS_QUEUESIZE];
+  volatile uint32_t Head, Tail, Dropped;
+} ShiftRegisterEvents;
+
+
+// Queue an event; dropped when the queue is full.
+void ShiftRegisterEventsPost(ShiftRegisterEvents *Events, uint16_t Pin, uint8_t Type, uint32_t TimeMS, uint32_t DurationMS)
+{
+  ShiftRegisterEvent *Event;
+  uint32_t Head=Events->Head;
+
+  if((Head-Events->Tail)>=SHIFTREGISTER_EVENTS_QUEUESIZE)
+  {
+    Events->Dropped++;
+    return;
+  }
+  Event=&Events->Events[Head & (SHIFTREGISTER_EVENTS_QUEUESIZE-1)];
+  Event->Pin=Pin;
+  Event->Type=Type;
+  Event->TimeMS=TimeMS;
+  Event->DurationMS=DurationMS;
+  __dmb();  // Publish the event before the head.
+  Events->Head=Head+1;
+}
+
+
+// Schedule the next long press or repeat of an input.
+void ShiftRegisterEventsSchedule(ShiftRegisterEvents *Events, uint16_t Pin, uint32_t NextMS)
+{
+  Events->NextMS[Pin]=NextMS;
+  if((!Events->Scheduled) || ((int32_t)(NextMS-Events->DeadlineMS)<0))
+    Events->DeadlineMS=NextMS;
+  Events->Scheduled=true;
+}
+
+
+// Generate the long presses and repeats that are due and schedule the next ones; only the waiting inputs are visited.
+void ShiftRegisterEventsTimers(ShiftRegisterEvents *Events, uint32_t NowMS)
+{
+  uint32_t Pending, Bit;
+  uint16_t Pin;
+  uint8_t Bits;
+
+  Events->Scheduled=false;
+  for(uint16_t Word=0; Word<Events->Words; Word++)
+  {
+    Pending=Events->Waiting[Word];
+    Bits=ShiftRegisterInputWordBits(Events->Register, Word);
+    while(Pending>0)
+    {
+      Bit=31-__builtin_clz(Pending);
+      Pending&=~(1u << Bit);
+      Pin=Word*32+(Bits-1-Bit);
+      if((int32_t)(NowMS-Events->NextMS[Pin])<0)
+      {
+        ShiftRegisterEventsSchedule(Events, Pin, Events->NextMS[Pin]);
+        continue;
+      }
+      if((Events->LongPressed[Word] & (1u << Bit))==0)
+      {
+        ShiftRegisterEventsPost(Events, Pin, SHIFTREGISTER_EVENT_LONGPRESS, NowMS, NowMS-Events->PressedMS[Pin]);
+        Events->LongPressed[Word]|=(1u << Bit);
+      }
+      else
+        ShiftRegisterEventsPost(Events, Pin, SHIFTREGISTER_EVENT_REPEAT, NowMS, NowMS-Events->PressedMS[Pin]);
+      if(Events->RepeatMS>0)
+        ShiftRegisterEventsSchedule(Events, Pin, NowMS+Events->RepeatMS);
+      else
+        Events->Waiting[Word]&=~(1u << Bit);
+    }
+  }
+}
+
+
+// Process the current levels of the inputs. Levels holds one word per 4 octets of the chain (the layout of
+// ShiftRegisterGetInputWord(), e.g. Stable of ShiftRegisterDebounce.c); NULL takes the input buffer of the register.
+void ShiftRegisterEventsUpdate(ShiftRegisterEvents *Events, const uint32_t *Levels)
+{
+  uint32_t NowMS=(uint32_t)(time_us_64()/1000), Active, Changed, Bit;
+  uint16_t Pin;
+  uint8_t Bits;
+
+  for(uint16_t Word=0; Word<Events->Words; Word++)
+  {
+    Bits=ShiftRegisterInputWordBits(Events->Register, Word);
+    Active=(Levels!=NULL?Levels[Word]:ShiftRegisterGetInputWord(Events->Register, Word));
+    if(Events->ActiveLow)
+      Active=~Active;
+    Active&=(Bits<32?(1u << Bits)-1:0xffffffff);
+    Changed=Active ^ Events->Active[Word];
+    if(Changed==0)
+      continue;
+    Events->Active[Word]=Active;
+
+    // Inputs active at the first update are taken as held since now, without press, long press or repeats.
+    if(!Events->Primed)
+      Changed=Active;
+    while(Changed>0)
+    {
+      Bit=31-__builtin_clz(Changed);
+      Changed&=~(1u << Bit);
+      Pin=Word*32+(Bits-1-Bit);
+      if((Active & (1u << Bit))>0)
+      {
+        Events->PressedMS[Pin]=NowMS;
+        if(!Events->Primed)
+          continue;
+        ShiftRegisterEventsPost(Events, Pin, SHIFTREGISTER_EVENT_PRESS, NowMS, 0);
+        if(Events->LongPressMS>0)
+        {
+          Events->Waiting[Word]|=(1u << Bit);
+          ShiftRegisterEventsSchedule(Events, Pin, NowMS+Events->LongPressMS);
+        }
+      }
+      else
+      {
+        ShiftRegisterEventsPost(Events, Pin, SHIFTREGISTER_EVENT_RELEASE, NowMS, NowMS-Events->PressedMS[Pin]);
+        Events->Waiting[Word]&=~(1u << Bit);
+        Events->LongPressed[Word]&=~(1u << Bit);
+      }
+    }
+  }
+  Events->Primed=true;
+
+  // Long presses and repeats.
+  if(Events->Scheduled && ((int32_t)(NowMS-Events->DeadlineMS)>=0))
+    ShiftRegisterEventsTimers(Events, NowMS);
+}
+
+
+// Take the oldest event from the queue. Returns false if there are no events.
+bool ShiftRegisterEventsPoll(ShiftRegisterEvents *Events, ShiftRegisterEvent *Event)
+{
+  uint32_t Tail=Events->Tail;
+
+  if(Tail==Events->Head)
+    return(false);
+  __dmb();  // Read the event only after seeing the head.
+  *Event=Events->Events[Tail & (SHIFTREGISTER_EVENTS_QUEUESIZE-1)];
+  __dmb();  // Free the slot after reading it.
+  Events->Tail=Tail+1;
+  return(true);
+}
+
+
+// Time in msec an input has been held, or 0 if it is not active.
+uint32_t ShiftRegisterEventsHeldMS(ShiftRegisterEvents *Events, uint16_t Pin)
+{
+  uint16_t Word=Pin/32;
+
+  if((Pin>=Events->Register->SizeInOctets*8u) ||
+     (((Events->Active[Word]>>(ShiftRegisterInputWordBits(Events->Register, Word)-1-(Pin%32))) & 1)==0))
+    return(0);
+  return((uint32_t)(time_us_64()/1000)-Events->PressedMS[Pin]);
+}
+
+
+// Create the event layer for the inputs of a register. Returns NULL for output registers or if no memory is available.
+ShiftRegisterEvents *ShiftRegisterEventsCreate(ShiftRegister *Register, uint32_t LongPressMS, uint32_t RepeatMS)
+{
+  ShiftRegisterEvents *Events;
+  uint16_t Words=(Register->SizeInOctets+MAX_SIZEINOCTETS-1)/MAX_SIZEINOCTETS, Pins=Register->SizeInOctets*8u;
+
+  if(Register->Type==SHIFTREGISTER_OUTPUT)
+    return(NULL);
+  Events=(ShiftRegisterEvents *)calloc(1, sizeof(ShiftRegisterEvents));
+  if(Events==NULL)
+    return(NULL);
+  Events->Active=(uint32_t *)calloc(Words*3+Pins*2, sizeof(uint32_t));
+  if(Events->Active==NULL)
+  {
+    free(Events);
+    return(NULL);
+  }
+  Events->Waiting=Events->Active+Words;
+  Events->LongPressed=Events->Waiting+Words;
+  Events->PressedMS=Events->LongPressed+Words;
+  Events->NextMS=Events->PressedMS+Pins;
+  Events->Register=Register;
+  Events->Words=Words;
+  Events->LongPressMS=LongPressMS;
+  Events->RepeatMS=RepeatMS;
+  return(Events);
+}
+
+
+void ShiftRegisterEventsDestroy(ShiftRegisterEvents *Events)
+{
+  free(Events->Active);
+  free(Events);
+}
+
+#endif
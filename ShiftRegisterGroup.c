@@ -0,0 +1,264 @@
+/*
+
+  Parallel updates of multiple chains sharing the clock and latch lines, using the ShiftRegister library. Every chain has
+  its own data line(s); ShiftRegisterGroupUpdate() shifts the data of all chains simultaneously, with one clock pulse per bit
+  for the whole group. The time to update the group equals the time needed for the longest chain.
+
+  The group can mix input, output and hybrid chains. First the bits of all output (and hybrid) chains are written, then the
+  latch is set high and the bits of all input (and hybrid) chains are read, then the latch is set low again; the same sequence
+  as ShiftRegisterReadWrite(). Shorter output chains get their bits during the last clock pulses (preceded by zeroes) so that
+  all chains hold their own data when latched; shorter input chains are read during the first clock pulses.
+
+  The data lines are accessed through the SIO registers with the masks precomputed by ShiftRegisterCreate(); the clock and
+  latch delays of the first register in the group are used. Only registers using the GPIO or SIO backend can be grouped.
+
+  When the data lines of the chains are on consecutive GPIO ports (chain n on port DataOutGPIO/DataInGPIO of the first chain
+  plus n), ShiftRegisterGroupUpdateSliced() is faster: the output buffers are transposed 32 bits at a time into one GPIO word
+  per clock pulse (a 32x32 bit-matrix transpose using word-wide operations), so every clock pulse takes a single masked SIO
+  write for all data lines, combined with the falling edge of the clock. Inputs are sampled as one word per clock pulse and
+  transposed back. All chains must have the same type and length.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterGroup
+#define MyHardwareShiftRegisterGroup
+
+#include "ShiftRegister.c"
+
+
+#define SHIFTREGISTER_GROUP_MAXREGISTERS   30   // All data lines of the group must fit in the GPIO ports.
+
+
+// Return bit Bit (0 is shifted first) of the output of the register, inverted if required.
+bool ShiftRegisterGroupOutputBit(ShiftRegister *Register, uint32_t Bit)
+{
+  return(((ShiftRegisterGetOutputOctet(Register, (uint16_t)(Bit/8)) & (0x80 >> (Bit%8)))>0)!=Register->InvertOutput);
+}
+
+
+// Update all registers in the group in parallel. Returns false if the registers do not share the clock and latch lines, or
+// one of them does not use the GPIO or SIO backend.
+bool ShiftRegisterGroupUpdate(ShiftRegister **Registers, uint8_t Count)
+{
+  ShiftRegister *Register, *First;
+  uint32_t Bits[SHIFTREGISTER_GROUP_MAXREGISTERS];
+  uint8_t InputOctets[SHIFTREGISTER_GROUP_MAXREGISTERS];
+  uint32_t OutputBits=0, InputBits=0, SetMask, ClearMask, Input;
+
+  // Check the group and determine the longest output and input chain.
+  if((Count==0) || (Count>SHIFTREGISTER_GROUP_MAXREGISTERS))
+    return(false);
+  First=Registers[0];
+  for(uint8_t counter=0; counter<Count; counter++)
+  {
+    Register=Registers[counter];
+    if((Register->ClockGPIO!=First->ClockGPIO) || (Register->LatchGPIO!=First->LatchGPIO) ||
+       ((Register->Backend!=SHIFTREGISTER_BACKEND_GPIO) && (Register->Backend!=SHIFTREGISTER_BACKEND_SIO)))
+      return(false);
+    Bits[counter]=Register->SizeInOctets*8u;
+    if(Register->Type!=SHIFTREGISTER_INPUT)
+    {
+      ShiftRegisterSwapFrame(Register);
+      Register->LastOutputValid=false;  // Written outside ShiftRegisterWrite(); the next write can not be skipped.
+      OutputBits=(Bits[counter]>OutputBits?Bits[counter]:OutputBits);
+    }
+    if(Register->Type!=SHIFTREGISTER_OUTPUT)
+      InputBits=(Bits[counter]>InputBits?Bits[counter]:InputBits);
+  }
+
+  // Write the bits of all output chains; one clock pulse per bit for the whole group. The data lines change right after the
+  // falling edge of the clock and get a clock delay before the rising edge (setup time).
+  for(uint32_t Bit=0; Bit<OutputBits; Bit++)
+  {
+    SetMask=0;
+    ClearMask=0;
+    for(uint8_t counter=0; counter<Count; counter++)
+    {
+      Register=Registers[counter];
+      if(Register->Type==SHIFTREGISTER_INPUT)
+        continue;
+      if((Bit>=OutputBits-Bits[counter]) && ShiftRegisterGroupOutputBit(Register, Bit-(OutputBits-Bits[counter])))
+        SetMask|=Register->DataOutMask;
+      else
+        ClearMask|=Register->DataOutMask;
+    }
+    gpio_set_mask(SetMask);
+    gpio_clr_mask(ClearMask);
+    ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+    gpio_set_mask(First->ClockMask);
+    ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+    gpio_clr_mask(First->ClockMask);
+  }
+  if(OutputBits>0)
+    ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+
+  // Set the latch to high; this updates the outputs and enables reading from the incoming shift registers.
+  gpio_set_mask(First->LatchMask);
+  ShiftRegisterDelay(First->LatchDelayUS, First->LatchDelayCycles);
+
+  // Read the bits of all input chains; one read of the GPIO ports per bit for the whole group.
+  for(uint32_t Bit=0; Bit<InputBits; Bit++)
+  {
+    Input=gpio_get_all();
+    for(uint8_t counter=0; counter<Count; counter++)
+    {
+      Register=Registers[counter];
+      if((Register->Type==SHIFTREGISTER_OUTPUT) || (Bit>=Bits[counter]))
+        continue;
+      InputOctets[counter]=(uint8_t)((InputOctets[counter]<<1) | ((Input & Register->DataInMask)>0?1:0));
+      if((Bit%8)==7)
+        ShiftRegisterSetInputOctet(Register, (uint16_t)(Bit/8), InputOctets[counter]);
+    }
+    gpio_set_mask(First->ClockMask);
+    ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+    gpio_clr_mask(First->ClockMask);
+    ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+  }
+
+  // All read and written; set the latch to low.
+  gpio_clr_mask(First->LatchMask);
+  return(true);
+}
+
+
+// Transpose a 32x32 bit-matrix in place; afterwards bit (31-k) of Matrix[r] holds the original bit (31-r) of Matrix[k].
+// Uses 5 rounds of swapping blocks of 16, 8, 4, 2 and 1 bits with masks, instead of moving individual bits.
+void ShiftRegisterTranspose32(uint32_t *Matrix)
+{
+  uint32_t Mask=0x0000ffff, Swap;
+
+  for(uint32_t Block=16; Block!=0; Block>>=1, Mask^=(Mask<<Block))
+    for(uint32_t Row=0; Row<32; Row=(Row+Block+1) & ~Block)
+    {
+      Swap=(Matrix[Row] ^ (Matrix[Row+Block]>>Block)) & Mask;
+      Matrix[Row]^=Swap;
+      Matrix[Row+Block]^=(Swap<<Block);
+    }
+}
+
+
+// Convert up to 32 bits (starting at bit Bit, 0 is shifted first) of the outputs of Count chains into one word per clock
+// pulse; bit n of Words[i] is the bit of chain n for clock pulse i.
+void ShiftRegisterGroupSliceOutput(ShiftRegister **Registers, uint8_t Count, uint32_t Bit, uint32_t *Words)
+{
+  ShiftRegister *Register;
+  uint32_t Value;
+
+  // Chain n goes into row 31-n, so the transposed bits end up in bit n.
+  for(uint8_t counter=0; counter<32; counter++)
+    Words[counter]=0;
+  for(uint8_t counter=0; counter<Count; counter++)
+  {
+    Register=Registers[counter];
+    Value=0;
+    for(uint8_t octet=0; octet<4; octet++)
+      Value=(Value<<8) | ((Bit/8)+octet<Register->SizeInOctets?ShiftRegisterGetOutputOctet(Register, (uint16_t)((Bit/8)+octet)):0);
+    Words[31-counter]=(Register->InvertOutput?~Value:Value);
+  }
+  ShiftRegisterTranspose32(Words);
+}
+
+
+// Store up to 32 bits sampled per clock pulse (bit n of Words[i] is the bit of chain n for clock pulse i) in the input
+// buffers of Count chains, starting at bit Bit.
+void ShiftRegisterGroupUnsliceInput(ShiftRegister **Registers, uint8_t Count, uint32_t Bit, uint32_t *Words)
+{
+  ShiftRegister *Register;
+
+  ShiftRegisterTranspose32(Words);
+  for(uint8_t counter=0; counter<Count; counter++)
+  {
+    Register=Registers[counter];
+    for(uint8_t octet=0; (octet<4) && ((Bit/8)+octet<Register->SizeInOctets); octet++)
+      ShiftRegisterSetInputOctet(Register, (uint16_t)((Bit/8)+octet), (uint8_t)(Words[31-counter]>>(24-(octet*8))));
+  }
+}
+
+
+// Update all registers in the group in parallel, using consecutive data lines. Returns false if the registers do not share
+// the clock and latch lines, do not use the GPIO or SIO backend, differ in type or length, or their data lines are not consecutive.
+bool ShiftRegisterGroupUpdateSliced(ShiftRegister **Registers, uint8_t Count)
+{
+  ShiftRegister *Register, *First;
+  uint32_t Words[32], Bits, Block, DataOutMask=0, Current, Toggle;
+
+  // Check the group.
+  if((Count==0) || (Count>SHIFTREGISTER_GROUP_MAXREGISTERS))
+    return(false);
+  First=Registers[0];
+  for(uint8_t counter=0; counter<Count; counter++)
+  {
+    Register=Registers[counter];
+    if((Register->ClockGPIO!=First->ClockGPIO) || (Register->LatchGPIO!=First->LatchGPIO) ||
+       ((Register->Backend!=SHIFTREGISTER_BACKEND_GPIO) && (Register->Backend!=SHIFTREGISTER_BACKEND_SIO)) ||
+       (Register->Type!=First->Type) || (Register->SizeInOctets!=First->SizeInOctets) ||
+       ((First->Type!=SHIFTREGISTER_INPUT) && (Register->DataOutGPIO!=First->DataOutGPIO+counter)) ||
+       ((First->Type!=SHIFTREGISTER_OUTPUT) && (Register->DataInGPIO!=First->DataInGPIO+counter)))
+      return(false);
+    if(Register->Type!=SHIFTREGISTER_INPUT)
+    {
+      ShiftRegisterSwapFrame(Register);
+      Register->LastOutputValid=false;  // Written outside ShiftRegisterWrite(); the next write can not be skipped.
+      DataOutMask|=Register->DataOutMask;
+    }
+  }
+  Bits=First->SizeInOctets*8u;
+
+  // Write 32 bits at a time; every clock pulse is one store setting the data lines, and one store combining the falling edge
+  // of the clock with the changes of the data lines for the next clock pulse.
+  if(First->Type!=SHIFTREGISTER_INPUT)
+  {
+    Current=sio_hw->gpio_out & DataOutMask;
+    gpio_clr_mask(First->ClockMask);
+    Toggle=0;
+    for(uint32_t Bit=0; Bit<Bits; Bit+=32)
+    {
+      ShiftRegisterGroupSliceOutput(Registers, Count, Bit, Words);
+      Block=(Bits-Bit<32?Bits-Bit:32);
+      for(uint32_t counter=0; counter<Block; counter++)
+      {
+        Toggle|=((Words[counter]<<First->DataOutGPIO) ^ Current) & DataOutMask;
+        Current^=(Toggle & DataOutMask);
+        gpio_xor_mask(Toggle);
+        ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+        gpio_set_mask(First->ClockMask);
+        ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+        Toggle=First->ClockMask;  // The clock goes low together with the next data bits.
+      }
+    }
+    gpio_xor_mask(Toggle);
+    ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+  }
+
+  // Set the latch to high; this updates the outputs and enables reading from the incoming shift registers.
+  gpio_set_mask(First->LatchMask);
+  ShiftRegisterDelay(First->LatchDelayUS, First->LatchDelayCycles);
+
+  // Read 32 bits at a time; one sample of the GPIO ports per clock pulse.
+  if(First->Type!=SHIFTREGISTER_OUTPUT)
+    for(uint32_t Bit=0; Bit<Bits; Bit+=32)
+    {
+      Block=(Bits-Bit<32?Bits-Bit:32);
+      for(uint32_t counter=0; counter<32; counter++)
+        Words[counter]=0;
+      for(uint32_t counter=0; counter<Block; counter++)
+      {
+        Words[counter]=(gpio_get_all()>>First->DataInGPIO);
+        gpio_set_mask(First->ClockMask);
+        ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+        gpio_clr_mask(First->ClockMask);
+        ShiftRegisterDelay(First->ClockDelayUS, First->ClockDelayCycles);
+      }
+      ShiftRegisterGroupUnsliceInput(Registers, Count, Bit, Words);
+    }
+
+  // All read and written; set the latch to low.
+  gpio_clr_mask(First->LatchMask);
+  return(true);
+}
+
+#endif
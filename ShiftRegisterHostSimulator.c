@@ -0,0 +1,1785 @@
+/*
+
+  Host simulator for the ShiftRegister library. Allows applications and changes to the library to be run on Linux instead
+  of flashing a board: the simulator implements the pico SDK functions used by the library (gpio_put, gpio_get, sleep_us,
+  gpio_init etc.; declared by the stub headers in the directory 'host') and models cascaded 74HC595 (SIPO) and 74HC165 (PISO)
+  chips connected to the simulated GPIO ports.
+
+  Build with the stub headers in front of the include path and include this file before the library, e.g.:
+
+    #include "ShiftRegisterHostSimulator.c"
+    #include "GameController.c"
+
+    cc -Ihost -pthread -o test test.c
+
+  Time is virtual and counted in nanoseconds (ShiftRegisterHostTimeNS()): every gpio_put/gpio_get takes GPIONS, sleep_us
+  and busy_wait_at_least_cycles take the requested period at ClockHz. The chips are modelled at the level of the edges on
+  their pins:
+  - 74HC595: the data line is sampled on the rising edge of the clock, the rising edge of the latch copies the shift stages
+    to the outputs (Parallel). The optional output-enable line (active low) tells if the outputs are driven.
+  - 74HC165: while the load line (the latch of the library) is low the inputs (Parallel) are loaded into the shift stages;
+    while it is high every rising edge of the clock shifts the chain one bit. The serial output changes PropagationNS after
+    the clock edge; reading it earlier returns the previous bit.
+  Violations of the setup time (data before clock), hold time (data after clock), minimum pulse width of the clock and the
+  propagation delay are counted per chain, so the timing of the library can be checked at any delay setting.
+
+  Parallel uses the layout of the register buffers; octet 0 is the first octet shifted out/in. The inputs of a 74HC165 chain
+  can be connected to the outputs of a 74HC595 chain with ShiftRegisterHostLoopback(), e.g. for ShiftRegisterCalibrate().
+
+  Repeating timers (add_repeating_timer_us()) run in virtual time as well. They fire while the application waits in sleep_us(),
+  sleep_ms() or tight_loop_contents(), and never interrupt other code, so background services (asynchronous transfers, BCM,
+  scanning) can be run by sleeping in the application. Interrupts raised by the DMA channels are handled the same way, at the
+  time they are raised if the application is waiting, otherwise as soon as it waits.
+
+  The PIO blocks are emulated as well (hardware/pio.h): the state machines execute the programs loaded into the instruction
+  memory at the speed set by their clock divider, with side-set, delays, autopull/autopush and 4 word FIFOs, and drive the
+  ports that are assigned to their block with gpio_set_function() or pio_gpio_init(). They run in the background whenever
+  the time advances (ShiftRegisterHostAdvance()), so the timing of the PIO backend is checked like that of the GPIO backend.
+  Unsupported instructions (IRQ, EXEC destinations, STATUS source) do nothing. DMA channels (hardware/dma.h) move words
+  between memory and the FIFOs as soon as their DREQ allows; a completed channel raises DMA_IRQ_0 (hardware/irq.h).
+
+  The SIO mask functions (gpio_set_mask(), gpio_clr_mask(), gpio_xor_mask() and gpio_get_all()) take one cycle of clk_sys
+  each. Their stores are recorded in ShiftRegisterHostStores (with the time, upto SHIFTREGISTER_HOST_MAXSTORES stores since
+  the last reset; ShiftRegisterHostStoreCount counts all), so the sequence of stores of the SIO backend can be checked.
+  sio_hw->gpio_out mirrors the output levels set by the CPU.
+
+  The SPI peripherals (hardware/spi.h) clock the octets in mode 0, MSB first, on the ports assigned to them with
+  gpio_set_function(): TX changes half a bit period before the rising edge of SCK and RX is sampled at that edge. The bit
+  rate is clk_sys divided by an even divider, as on the RP2040, and the CPU waits for the transfer like spi_write_blocking().
+
+  Critical sections (pico/sync.h) are mutexes, so frames can be committed from other threads while the application runs the
+  simulator (which must only be used from one thread); build with -pthread. Core1 (pico/multicore.h) is a thread as well,
+  with __sev() and __wfe() as a shared event; while a service runs on core1, core0 must leave the simulator alone.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterHostSimulator
+#define MyHardwareShiftRegisterHostSimulator
+
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "hardware/structs/sio.h"
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+
+
+#define SHIFTREGISTER_HOST_595             0
+#define SHIFTREGISTER_HOST_165             1
+#define SHIFTREGISTER_HOST_NOPIN           255  // No output-enable line; the outputs are always driven.
+#define SHIFTREGISTER_HOST_GPIOS           30
+#define SHIFTREGISTER_HOST_MAXCHAINS       8
+#define SHIFTREGISTER_HOST_MAXTIMERS       8
+#define SHIFTREGISTER_HOST_CLOCKHZ         125000000  // Default clk_sys frequency.
+#define SHIFTREGISTER_HOST_GPIONS          24         // Default duration of gpio_put/gpio_get; about 3 cycles at 125 MHz.
+#define SHIFTREGISTER_HOST_SETUPNS         4    // Default timing of the chips; typical values of the 74HC series at 4.5V. Use the
+#define SHIFTREGISTER_HOST_HOLDNS          0    // worst case values of the datasheet to check the margins.
+#define SHIFTREGISTER_HOST_PULSEWIDTHNS    6
+#define SHIFTREGISTER_HOST_PROPAGATIONNS   16
+#define SHIFTREGISTER_HOST_FIFODEPTH       4    // Depth of the TX and RX FIFOs of a state machine.
+#define SHIFTREGISTER_HOST_IRQS            32
+#define SHIFTREGISTER_HOST_MAXSTORES       1024 // SIO stores recorded.
+#define SHIFTREGISTER_HOST_SIO_SET         0    // Registers of the SIO stores.
+#define SHIFTREGISTER_HOST_SIO_CLR         1
+#define SHIFTREGISTER_HOST_SIO_TOGL        2
+#define SHIFTREGISTER_HOST_MAXHANDLERS     4    // Shared handlers per interrupt.
+
+
+typedef struct ShiftRegisterHostChain ShiftRegisterHostChain;
+
+struct ShiftRegisterHostChain
+{
+  // Type of the chips and the ports they are connected to. DataGPIO is the serial input of a 74HC595 chain and the serial
+  // output of a 74HC165 chain; LatchGPIO is the storage clock of a 74HC595 and the shift/load line of a 74HC165.
+  uint8_t Type, ClockGPIO, DataGPIO, LatchGPIO, EnableGPIO;
+  uint16_t SizeInOctets;
+
+  // Shift stages and parallel outputs (74HC595) or inputs (74HC165), SizeInOctets octets each. Source (optional) drives the
+  // inputs of a 74HC165 chain.
+  uint8_t *Shift, *Parallel;
+  ShiftRegisterHostChain *Source;
+
+  // Timing of the chips; can be adjusted after the chain is added.
+  uint32_t SetupNS, HoldNS, PulseWidthNS, PropagationNS;
+
+  // Time of the last clock edges and of the last change of the serial output of a 74HC165.
+  uint64_t ClockRiseNS, ClockFallNS, DataChangedNS;
+  bool DataPrevious;
+
+  // Statistics.
+  uint32_t Clocks, Latches, SetupViolations, HoldViolations, PulseWidthViolations, PropagationViolations;
+};
+
+typedef struct
+{
+  repeating_timer_t *Timer;
+  uint64_t DueNS;
+} ShiftRegisterHostTimer;
+
+typedef struct
+{
+  uint64_t TimeNS;
+  uint32_t ClockHz, GPIONS;
+
+  // Level of the ports, the level before their last change and the time of that change. Out is the level set by the CPU;
+  // it drives the port while the port is assigned to SIO (Peripheral 0), otherwise Peripheral is the function of the port.
+  bool Level[SHIFTREGISTER_HOST_GPIOS], PreviousLevel[SHIFTREGISTER_HOST_GPIOS];
+  uint64_t ChangedNS[SHIFTREGISTER_HOST_GPIOS];
+  bool Out[SHIFTREGISTER_HOST_GPIOS];
+  uint8_t Peripheral[SHIFTREGISTER_HOST_GPIOS];
+
+  uint8_t ChainCount;
+  ShiftRegisterHostTimer Timers[SHIFTREGISTER_HOST_MAXTIMERS];
+  bool InInterrupt;
+} ShiftRegisterHostState;
+
+typedef struct
+{
+  uint8_t Register;
+  uint32_t Mask;
+  uint64_t TimeNS;
+} ShiftRegisterHostStore;
+
+typedef struct
+{
+  uint32_t Data[SHIFTREGISTER_HOST_FIFODEPTH];
+  uint8_t Head, Count;
+} ShiftRegisterHostFIFO;
+
+typedef struct
+{
+  pio_sm_config Config;
+  bool Claimed, Enabled, Stalled;
+
+  // Program counter, scratch and shift registers (with the number of bits shifted) and the FIFOs.
+  uint8_t PC, OSRCount, ISRCount;
+  uint32_t X, Y, OSR, ISR;
+  ShiftRegisterHostFIFO TxFIFO, RxFIFO;
+
+  // Time of the next instruction and the length of a cycle, in picoseconds. A stalled state machine waits for its FIFOs.
+  uint64_t NextPS, PeriodPS;
+
+  // Statistics.
+  uint32_t Instructions, Stalls;
+} ShiftRegisterHostStateMachine;
+
+typedef struct
+{
+  uint16_t Memory[PIO_INSTRUCTION_COUNT];
+  uint32_t Used;  // Instruction memory in use; one bit per instruction.
+  ShiftRegisterHostStateMachine StateMachines[NUM_PIO_STATE_MACHINES];
+} ShiftRegisterHostPIO;
+
+typedef struct
+{
+  dma_channel_config Config;
+  bool Claimed, Busy, IRQ0Enabled, IRQ0Raised;
+
+  // Current addresses and the number of transfers left; TransferCount is reloaded when the channel is triggered.
+  uintptr_t ReadAddr, WriteAddr;
+  uint32_t Count, TransferCount;
+
+  // Statistics.
+  uint32_t Transfers;
+} ShiftRegisterHostDMAChannel;
+
+
+static ShiftRegisterHostState ShiftRegisterHost={0, SHIFTREGISTER_HOST_CLOCKHZ, SHIFTREGISTER_HOST_GPIONS, {false}, {false}, {0}, {false}, {0}, 0, {{NULL, 0}}, false};
+static ShiftRegisterHostChain ShiftRegisterHostChains[SHIFTREGISTER_HOST_MAXCHAINS];
+static ShiftRegisterHostPIO ShiftRegisterHostPIOs[NUM_PIOS];
+pio_hw_t ShiftRegisterHostPIOBlocks[NUM_PIOS];
+spi_inst_t ShiftRegisterHostSPIs[2];
+static ShiftRegisterHostDMAChannel ShiftRegisterHostDMA[NUM_DMA_CHANNELS];
+static irq_handler_t ShiftRegisterHostHandlers[SHIFTREGISTER_HOST_IRQS][SHIFTREGISTER_HOST_MAXHANDLERS];
+static uint32_t ShiftRegisterHostIRQEnabled;
+static ShiftRegisterHostStore ShiftRegisterHostStores[SHIFTREGISTER_HOST_MAXSTORES];
+static uint32_t ShiftRegisterHostStoreCount;
+static sio_hw_t ShiftRegisterHostSIO;
+sio_hw_t *sio_hw=&ShiftRegisterHostSIO;
+
+
+// Level of the serial output of a 74HC165 chain; the first bit of the shift stages.
+bool ShiftRegisterHostSerialOut(ShiftRegisterHostChain *Chain)
+{
+  return((Chain->Shift[0] & 0x80)>0);
+}
+
+
+// Load the inputs of a 74HC165 chain into the shift stages.
+void ShiftRegisterHostLoad(ShiftRegisterHostChain *Chain)
+{
+  bool SerialOut=ShiftRegisterHostSerialOut(Chain);
+
+  if(Chain->Source!=NULL)
+    memcpy(Chain->Parallel, Chain->Source->Parallel, (Chain->SizeInOctets<Chain->Source->SizeInOctets?Chain->SizeInOctets:Chain->Source->SizeInOctets));
+  memcpy(Chain->Shift, Chain->Parallel, Chain->SizeInOctets);
+  if(ShiftRegisterHostSerialOut(Chain)!=SerialOut)
+  {
+    Chain->DataPrevious=SerialOut;
+    Chain->DataChangedNS=ShiftRegisterHost.TimeNS;
+  }
+}
+
+
+// Shift the chain one bit; Bit enters at the end of the last octet.
+void ShiftRegisterHostShift(ShiftRegisterHostChain *Chain, bool Bit)
+{
+  for(uint16_t counter=0; counter<Chain->SizeInOctets; counter++)
+  {
+    Chain->Shift[counter]<<=1;
+    if(counter+1<Chain->SizeInOctets)
+      Chain->Shift[counter]|=(Chain->Shift[counter+1]>>7);
+    else
+      Chain->Shift[counter]|=(Bit?1:0);
+  }
+  Chain->Clocks++;
+}
+
+
+// Rising edge of the clock of a 74HC165 chain in shift mode; the serial output changes to the next bit.
+void ShiftRegisterHost165Clock(ShiftRegisterHostChain *Chain)
+{
+  bool SerialOut=ShiftRegisterHostSerialOut(Chain);
+
+  ShiftRegisterHostShift(Chain, false);
+  Chain->DataPrevious=SerialOut;
+  Chain->DataChangedNS=ShiftRegisterHost.TimeNS;
+}
+
+
+// Rising edge of the latch of a 74HC595 chain; the shift stages are copied to the outputs.
+void ShiftRegisterHost595Latch(ShiftRegisterHostChain *Chain)
+{
+  memcpy(Chain->Parallel, Chain->Shift, Chain->SizeInOctets);
+  Chain->Latches++;
+}
+
+
+// Check the minimum pulse width and remember the time of a clock edge.
+void ShiftRegisterHostClockEdge(ShiftRegisterHostChain *Chain, bool Rising)
+{
+  uint64_t Now=ShiftRegisterHost.TimeNS;
+
+  if(Rising)
+  {
+    if((Chain->Clocks>0) && (Now-Chain->ClockFallNS<Chain->PulseWidthNS))
+      Chain->PulseWidthViolations++;
+    Chain->ClockRiseNS=Now;
+  }
+  else
+  {
+    if(Now-Chain->ClockRiseNS<Chain->PulseWidthNS)
+      Chain->PulseWidthViolations++;
+    Chain->ClockFallNS=Now;
+  }
+}
+
+
+// A port of a 74HC165 chain changed level.
+void ShiftRegisterHost165Edge(ShiftRegisterHostChain *Chain, uint8_t GPIO, bool Level)
+{
+  uint64_t Now=ShiftRegisterHost.TimeNS;
+
+  if(GPIO==Chain->LatchGPIO)
+  {
+    // Load on the falling edge and capture the inputs on the rising edge; the inputs are loaded as long as the line is low.
+    ShiftRegisterHostLoad(Chain);
+    if(Level)
+      Chain->Latches++;
+  }
+  else if(GPIO==Chain->ClockGPIO)
+  {
+    ShiftRegisterHostClockEdge(Chain, Level);
+    if(Level && ShiftRegisterHost.Level[Chain->LatchGPIO])
+    {
+      if(Now-ShiftRegisterHost.ChangedNS[Chain->LatchGPIO]<Chain->SetupNS)
+        Chain->SetupViolations++;
+      ShiftRegisterHost165Clock(Chain);
+    }
+  }
+}
+
+
+// A port of a 74HC595 chain changed level.
+void ShiftRegisterHost595Edge(ShiftRegisterHostChain *Chain, uint8_t GPIO, bool Level)
+{
+  uint64_t Now=ShiftRegisterHost.TimeNS;
+  bool Data;
+
+  if(GPIO==Chain->DataGPIO)
+  {
+    if((Chain->Clocks>0) && (Now-Chain->ClockRiseNS<Chain->HoldNS))
+      Chain->HoldViolations++;
+  }
+  else if(GPIO==Chain->ClockGPIO)
+  {
+    ShiftRegisterHostClockEdge(Chain, Level);
+    if(Level)
+    {
+      // Data that changed within the setup time is not seen yet.
+      Data=ShiftRegisterHost.Level[Chain->DataGPIO];
+      if(Now-ShiftRegisterHost.ChangedNS[Chain->DataGPIO]<Chain->SetupNS)
+      {
+        Chain->SetupViolations++;
+        Data=ShiftRegisterHost.PreviousLevel[Chain->DataGPIO];
+      }
+      ShiftRegisterHostShift(Chain, Data);
+    }
+  }
+  else if((GPIO==Chain->LatchGPIO) && Level)
+    ShiftRegisterHost595Latch(Chain);
+}
+
+
+// Drive the ports in Mask to the levels in Levels. All ports change before the chips see the edges (in the order of the
+// ports), so data and clock changing in the same store count as a setup violation.
+void ShiftRegisterHostDrive(uint32_t Mask, uint32_t Levels)
+{
+  uint32_t Changed=0;
+  bool Level;
+
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+  {
+    Level=((Levels>>gpio) & 1)>0;
+    if(((Mask & (1u << gpio))==0) || (ShiftRegisterHost.Level[gpio]==Level))
+      continue;
+    ShiftRegisterHost.PreviousLevel[gpio]=ShiftRegisterHost.Level[gpio];
+    ShiftRegisterHost.Level[gpio]=Level;
+    ShiftRegisterHost.ChangedNS[gpio]=ShiftRegisterHost.TimeNS;
+    Changed|=(1u << gpio);
+  }
+
+  // The 74HC165 chains first, so on a shared latch line they capture the outputs of the 74HC595 chains before these change.
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+  {
+    if((Changed & (1u << gpio))==0)
+      continue;
+    for(uint8_t counter=0; counter<ShiftRegisterHost.ChainCount; counter++)
+      if(ShiftRegisterHostChains[counter].Type==SHIFTREGISTER_HOST_165)
+        ShiftRegisterHost165Edge(&ShiftRegisterHostChains[counter], gpio, ShiftRegisterHost.Level[gpio]);
+    for(uint8_t counter=0; counter<ShiftRegisterHost.ChainCount; counter++)
+      if(ShiftRegisterHostChains[counter].Type==SHIFTREGISTER_HOST_595)
+        ShiftRegisterHost595Edge(&ShiftRegisterHostChains[counter], gpio, ShiftRegisterHost.Level[gpio]);
+  }
+}
+
+
+// Level of a port as seen by the CPU or a peripheral, including the serial output of the 74HC165 chains; takes no time.
+bool ShiftRegisterHostSample(uint gpio)
+{
+  ShiftRegisterHostChain *Chain;
+
+  for(uint8_t counter=0; counter<ShiftRegisterHost.ChainCount; counter++)
+  {
+    Chain=&ShiftRegisterHostChains[counter];
+    if((Chain->Type!=SHIFTREGISTER_HOST_165) || (Chain->DataGPIO!=gpio))
+      continue;
+    if(!ShiftRegisterHost.Level[Chain->LatchGPIO])
+      ShiftRegisterHostLoad(Chain);
+    if(ShiftRegisterHost.TimeNS-Chain->DataChangedNS<Chain->PropagationNS)
+    {
+      Chain->PropagationViolations++;
+      return(Chain->DataPrevious);
+    }
+    return(ShiftRegisterHostSerialOut(Chain));
+  }
+  return((gpio<SHIFTREGISTER_HOST_GPIOS) && ShiftRegisterHost.Level[gpio]);
+}
+
+
+// Set up a chain of SizeInOctets chips of Type (SHIFTREGISTER_HOST_595 or SHIFTREGISTER_HOST_165) on the specified ports,
+// with the default timing; the chain is not added to the simulated ports. Chains on SHIFTREGISTER_HOST_NOPIN only are driven
+// by calling the functions of the chips directly, like ShiftRegisterSimulator.c does. Returns false if no memory is
+// available; free Shift when done.
+bool ShiftRegisterHostInitChain(ShiftRegisterHostChain *Chain, uint8_t Type, uint8_t ClockGPIO, uint8_t DataGPIO, uint8_t LatchGPIO, uint8_t EnableGPIO, uint16_t SizeInOctets)
+{
+  uint8_t *Octets;
+
+  if(SizeInOctets==0)
+    return(false);
+  Octets=(uint8_t *)calloc(SizeInOctets*2u, 1);
+  if(Octets==NULL)
+    return(false);
+  memset(Chain, 0, sizeof(ShiftRegisterHostChain));
+  Chain->Shift=Octets;
+  Chain->Parallel=Octets+SizeInOctets;
+  Chain->Type=Type;
+  Chain->ClockGPIO=ClockGPIO;
+  Chain->DataGPIO=DataGPIO;
+  Chain->LatchGPIO=LatchGPIO;
+  Chain->EnableGPIO=EnableGPIO;
+  Chain->SizeInOctets=SizeInOctets;
+  Chain->SetupNS=SHIFTREGISTER_HOST_SETUPNS;
+  Chain->HoldNS=SHIFTREGISTER_HOST_HOLDNS;
+  Chain->PulseWidthNS=SHIFTREGISTER_HOST_PULSEWIDTHNS;
+  Chain->PropagationNS=SHIFTREGISTER_HOST_PROPAGATIONNS;
+  if(Type==SHIFTREGISTER_HOST_165)
+    ShiftRegisterHostLoad(Chain);
+  return(true);
+}
+
+
+// Add a chain of SizeInOctets 74HC595 chips. EnableGPIO is the output-enable line, or SHIFTREGISTER_HOST_NOPIN. Returns NULL if
+// the maximum number of chains is reached or no memory is available.
+ShiftRegisterHostChain *ShiftRegisterHostAdd595(uint8_t ClockGPIO, uint8_t DataGPIO, uint8_t LatchGPIO, uint8_t EnableGPIO, uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain=&ShiftRegisterHostChains[ShiftRegisterHost.ChainCount];
+
+  if((ShiftRegisterHost.ChainCount>=SHIFTREGISTER_HOST_MAXCHAINS) ||
+     (!ShiftRegisterHostInitChain(Chain, SHIFTREGISTER_HOST_595, ClockGPIO, DataGPIO, LatchGPIO, EnableGPIO, SizeInOctets)))
+    return(NULL);
+  ShiftRegisterHost.ChainCount++;
+  return(Chain);
+}
+
+
+// Add a chain of SizeInOctets 74HC165 chips; DataGPIO is the port reading the serial output and LoadGPIO the shift/load line.
+ShiftRegisterHostChain *ShiftRegisterHostAdd165(uint8_t ClockGPIO, uint8_t DataGPIO, uint8_t LoadGPIO, uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain=&ShiftRegisterHostChains[ShiftRegisterHost.ChainCount];
+
+  if((ShiftRegisterHost.ChainCount>=SHIFTREGISTER_HOST_MAXCHAINS) ||
+     (!ShiftRegisterHostInitChain(Chain, SHIFTREGISTER_HOST_165, ClockGPIO, DataGPIO, LoadGPIO, SHIFTREGISTER_HOST_NOPIN, SizeInOctets)))
+    return(NULL);
+  ShiftRegisterHost.ChainCount++;
+  return(Chain);
+}
+
+
+// Connect the inputs of a 74HC165 chain to the outputs of a 74HC595 chain.
+void ShiftRegisterHostLoopback(ShiftRegisterHostChain *Chain165, ShiftRegisterHostChain *Chain595)
+{
+  Chain165->Source=Chain595;
+}
+
+
+// Returns true if the outputs of a 74HC595 chain are driven (output-enable low or not connected).
+bool ShiftRegisterHostOutputsEnabled(ShiftRegisterHostChain *Chain)
+{
+  return((Chain->EnableGPIO==SHIFTREGISTER_HOST_NOPIN) || (!ShiftRegisterHost.Level[Chain->EnableGPIO]));
+}
+
+
+uint64_t ShiftRegisterHostTimeNS(void)
+{
+  return(ShiftRegisterHost.TimeNS);
+}
+
+
+// Remove all chains and reset the ports, the PIO blocks, the DMA channels, the SPI peripherals, the interrupts, the SIO
+// stores and the time.
+void ShiftRegisterHostReset(void)
+{
+  for(uint8_t counter=0; counter<ShiftRegisterHost.ChainCount; counter++)
+    free(ShiftRegisterHostChains[counter].Shift);
+  memset(&ShiftRegisterHost, 0, sizeof(ShiftRegisterHostState));
+  memset(ShiftRegisterHostChains, 0, sizeof(ShiftRegisterHostChains));
+  memset(ShiftRegisterHostPIOs, 0, sizeof(ShiftRegisterHostPIOs));
+  memset(ShiftRegisterHostDMA, 0, sizeof(ShiftRegisterHostDMA));
+  memset(ShiftRegisterHostSPIs, 0, sizeof(ShiftRegisterHostSPIs));
+  memset(ShiftRegisterHostHandlers, 0, sizeof(ShiftRegisterHostHandlers));
+  ShiftRegisterHostIRQEnabled=0;
+  ShiftRegisterHostStoreCount=0;
+  memset(&ShiftRegisterHostSIO, 0, sizeof(sio_hw_t));
+  ShiftRegisterHost.ClockHz=SHIFTREGISTER_HOST_CLOCKHZ;
+  ShiftRegisterHost.GPIONS=SHIFTREGISTER_HOST_GPIONS;
+}
+
+
+// The state machine of a PIO block, for checking its statistics.
+ShiftRegisterHostStateMachine *ShiftRegisterHostGetStateMachine(PIO pio, uint sm)
+{
+  return(&ShiftRegisterHostPIOs[pio-ShiftRegisterHostPIOBlocks].StateMachines[sm]);
+}
+
+
+bool ShiftRegisterHostFIFOPut(ShiftRegisterHostFIFO *FIFO, uint32_t Value)
+{
+  if(FIFO->Count>=SHIFTREGISTER_HOST_FIFODEPTH)
+    return(false);
+  FIFO->Data[(FIFO->Head+FIFO->Count)%SHIFTREGISTER_HOST_FIFODEPTH]=Value;
+  FIFO->Count++;
+  return(true);
+}
+
+
+bool ShiftRegisterHostFIFOTake(ShiftRegisterHostFIFO *FIFO, uint32_t *Value)
+{
+  if(FIFO->Count==0)
+    return(false);
+  *Value=FIFO->Data[FIFO->Head];
+  FIFO->Head=(FIFO->Head+1)%SHIFTREGISTER_HOST_FIFODEPTH;
+  FIFO->Count--;
+  return(true);
+}
+
+
+// Resume a state machine stalled on its FIFOs; called after every FIFO access from outside the state machine.
+void ShiftRegisterHostWake(ShiftRegisterHostStateMachine *StateMachine)
+{
+  if(!StateMachine->Stalled)
+    return;
+  StateMachine->Stalled=false;
+  if(StateMachine->NextPS<ShiftRegisterHost.TimeNS*1000)
+    StateMachine->NextPS=ShiftRegisterHost.TimeNS*1000;
+}
+
+
+// Drive Count ports from Base to the lowest bits of Value; only the ports assigned to the PIO block change.
+void ShiftRegisterHostPIOPins(uint8_t Block, uint8_t Base, uint8_t Count, uint32_t Value)
+{
+  uint32_t Mask=0, Levels=0;
+  uint8_t gpio;
+
+  for(uint8_t counter=0; counter<Count; counter++)
+  {
+    gpio=(Base+counter)%32;
+    if((gpio>=SHIFTREGISTER_HOST_GPIOS) || (ShiftRegisterHost.Peripheral[gpio]!=GPIO_FUNC_PIO0+Block))
+      continue;
+    Mask|=(1u << gpio);
+    Levels|=((Value>>counter) & 1) << gpio;
+  }
+  if(Mask>0)
+    ShiftRegisterHostDrive(Mask, Levels);
+}
+
+
+// Read Count ports from the IN base; the first port in bit 0.
+uint32_t ShiftRegisterHostPIOReadPins(ShiftRegisterHostStateMachine *StateMachine, uint8_t Count)
+{
+  uint32_t Value=0;
+
+  for(uint8_t counter=0; counter<Count; counter++)
+    if(ShiftRegisterHostSample((StateMachine->Config.in_base+counter)%32))
+      Value|=(1u << counter);
+  return(Value);
+}
+
+
+// Push the ISR to the RX FIFO. Returns false if the FIFO is full.
+bool ShiftRegisterHostPIOPush(ShiftRegisterHostStateMachine *StateMachine)
+{
+  if(!ShiftRegisterHostFIFOPut(&StateMachine->RxFIFO, StateMachine->ISR))
+    return(false);
+  StateMachine->ISR=0;
+  StateMachine->ISRCount=0;
+  return(true);
+}
+
+
+// Pull the OSR from the TX FIFO. Returns false if the FIFO is empty.
+bool ShiftRegisterHostPIOPull(ShiftRegisterHostStateMachine *StateMachine)
+{
+  if(!ShiftRegisterHostFIFOTake(&StateMachine->TxFIFO, &StateMachine->OSR))
+    return(false);
+  StateMachine->OSRCount=0;
+  return(true);
+}
+
+
+// Write a value to a destination of OUT, MOV or SET; Bits is the number of bits written. Returns true for a jump.
+bool ShiftRegisterHostPIOWrite(uint8_t Block, ShiftRegisterHostStateMachine *StateMachine, uint8_t Destination, uint32_t Value, uint8_t Bits,
+                               uint8_t Base, uint8_t Count)
+{
+  switch(Destination)
+  {
+    case pio_pins:
+      ShiftRegisterHostPIOPins(Block, Base, Count, Value);
+      break;
+    case pio_x:
+      StateMachine->X=Value;
+      break;
+    case pio_y:
+      StateMachine->Y=Value;
+      break;
+    case pio_pc:
+      StateMachine->PC=(uint8_t)(Value & 0x1f);
+      return(true);
+    case pio_isr:
+      StateMachine->ISR=Value;
+      StateMachine->ISRCount=Bits;
+      break;
+    case pio_osr:
+      StateMachine->OSR=Value;
+      StateMachine->OSRCount=0;
+      break;
+  }
+  return(false);
+}
+
+
+// Value of a source of IN or MOV.
+uint32_t ShiftRegisterHostPIORead(ShiftRegisterHostStateMachine *StateMachine, uint8_t Source, uint8_t Bits)
+{
+  switch(Source)
+  {
+    case pio_pins:
+      return(ShiftRegisterHostPIOReadPins(StateMachine, Bits));
+    case pio_x:
+      return(StateMachine->X);
+    case pio_y:
+      return(StateMachine->Y);
+    case pio_isr:
+      return(StateMachine->ISR);
+    case pio_osr:
+      return(StateMachine->OSR);
+  }
+  return(0);
+}
+
+
+// Execute the instruction at the program counter. An instruction that stalls on a FIFO is retried when the FIFO is accessed.
+void ShiftRegisterHostPIOStep(uint8_t Block, ShiftRegisterHostStateMachine *StateMachine)
+{
+  pio_sm_config *Config=&StateMachine->Config;
+  uint16_t Instruction=ShiftRegisterHostPIOs[Block].Memory[StateMachine->PC];
+  uint8_t Field=(Instruction>>8) & 0x1f, SideSetBits=Config->sideset_bit_count, ValueBits, Count, Argument=Instruction & 0x1f;
+  uint8_t Operation=(Instruction>>5) & 7, Threshold;
+  uint32_t Value, Data, Mask;
+  bool Jump=false, Condition=false, Stall=false;
+
+  // Side-set is applied when the instruction starts, also if it stalls.
+  if(SideSetBits>0)
+  {
+    ValueBits=SideSetBits-(Config->sideset_optional?1:0);
+    if((!Config->sideset_optional) || ((Field & 0x10)>0))
+      ShiftRegisterHostPIOPins(Block, Config->sideset_base, ValueBits, (Field>>(5-SideSetBits)) & ((1u << ValueBits)-1));
+  }
+  Count=(Argument==0?32:Argument);
+  Mask=(Count==32?0xffffffff:(1u << Count)-1);
+  switch(Instruction>>13)
+  {
+    case 0:  // JMP
+      switch(Operation)
+      {
+        case 0: Condition=true; break;
+        case 1: Condition=(StateMachine->X==0); break;
+        case 2: Condition=(StateMachine->X--!=0); break;
+        case 3: Condition=(StateMachine->Y==0); break;
+        case 4: Condition=(StateMachine->Y--!=0); break;
+        case 5: Condition=(StateMachine->X!=StateMachine->Y); break;
+        case 7: Condition=(StateMachine->OSRCount<(Config->pull_threshold==0?32:Config->pull_threshold)); break;
+      }
+      if(Condition)
+      {
+        StateMachine->PC=Argument;
+        Jump=true;
+      }
+      break;
+
+    case 1:  // WAIT on a GPIO (source 0) or IN pin (source 1); polled every cycle.
+      if((Operation & 3)==0)
+        Value=ShiftRegisterHostSample(Argument);
+      else
+        Value=(ShiftRegisterHostPIOReadPins(StateMachine, Argument+1)>>Argument) & 1;
+      if(((Operation & 3)<2) && ((Value>0)!=((Operation & 4)>0)))
+      {
+        StateMachine->NextPS+=StateMachine->PeriodPS;
+        return;
+      }
+      break;
+
+    case 2:  // IN; a full ISR waiting for an autopush stalls until the RX FIFO has room.
+      Threshold=(Config->push_threshold==0?32:Config->push_threshold);
+      if(Config->autopush && (StateMachine->ISRCount>=Threshold) && (!ShiftRegisterHostPIOPush(StateMachine)))
+      {
+        Stall=true;
+        break;
+      }
+      Data=ShiftRegisterHostPIORead(StateMachine, Operation, Count) & Mask;
+      if(Config->in_shift_right)
+        StateMachine->ISR=(uint32_t)(((uint64_t)StateMachine->ISR>>Count) | ((uint64_t)Data<<(32-Count)));
+      else
+        StateMachine->ISR=(uint32_t)(((uint64_t)StateMachine->ISR<<Count) | Data);
+      StateMachine->ISRCount=(StateMachine->ISRCount+Count>32?32:StateMachine->ISRCount+Count);
+      if(Config->autopush && (StateMachine->ISRCount>=Threshold))
+        ShiftRegisterHostPIOPush(StateMachine);
+      break;
+
+    case 3:  // OUT; an empty OSR is refilled first with autopull, stalling on an empty TX FIFO.
+      Threshold=(Config->pull_threshold==0?32:Config->pull_threshold);
+      if(Config->autopull && (StateMachine->OSRCount>=Threshold) && (!ShiftRegisterHostPIOPull(StateMachine)))
+      {
+        Stall=true;
+        break;
+      }
+      if(Config->out_shift_right)
+      {
+        Data=StateMachine->OSR & Mask;
+        StateMachine->OSR=(uint32_t)((uint64_t)StateMachine->OSR>>Count);
+      }
+      else
+      {
+        Data=(uint32_t)(((uint64_t)StateMachine->OSR<<Count)>>32);
+        StateMachine->OSR=(uint32_t)((uint64_t)StateMachine->OSR<<Count);
+      }
+      StateMachine->OSRCount=(StateMachine->OSRCount+Count>32?32:StateMachine->OSRCount+Count);
+      Jump=ShiftRegisterHostPIOWrite(Block, StateMachine, Operation, Data, Count, Config->out_base, Config->out_count);
+      if(Config->autopull && (StateMachine->OSRCount>=Threshold))
+        ShiftRegisterHostPIOPull(StateMachine);
+      break;
+
+    case 4:  // PUSH and PULL; IfFull/IfEmpty (bit 6) make them conditional, Block (bit 5) stalls instead of dropping.
+      if((Instruction & 0x80)==0)
+      {
+        if(((Instruction & 0x40)>0) && (StateMachine->ISRCount<(Config->push_threshold==0?32:Config->push_threshold)))
+          break;
+        if(ShiftRegisterHostPIOPush(StateMachine))
+          break;
+        Stall=((Instruction & 0x20)>0);
+        if(!Stall)
+        {
+          StateMachine->ISR=0;
+          StateMachine->ISRCount=0;
+        }
+      }
+      else
+      {
+        // With autopull PULL does nothing while the OSR holds data.
+        Threshold=(Config->pull_threshold==0?32:Config->pull_threshold);
+        if((((Instruction & 0x40)>0) || Config->autopull) && (StateMachine->OSRCount<Threshold))
+          break;
+        if(ShiftRegisterHostPIOPull(StateMachine))
+          break;
+        Stall=((Instruction & 0x20)>0);
+        if(!Stall)
+        {
+          StateMachine->OSR=StateMachine->X;
+          StateMachine->OSRCount=0;
+        }
+      }
+      break;
+
+    case 5:  // MOV with optional invert (1) or bit-reverse (2).
+      Value=ShiftRegisterHostPIORead(StateMachine, Argument & 7, 32);
+      if(((Argument>>3) & 3)==1)
+        Value=~Value;
+      else if(((Argument>>3) & 3)==2)
+      {
+        Data=Value;
+        Value=0;
+        for(uint8_t counter=0; counter<32; counter++)
+          Value|=((Data>>counter) & 1) << (31-counter);
+      }
+      Jump=ShiftRegisterHostPIOWrite(Block, StateMachine, Operation, Value, 0, Config->out_base, Config->out_count);
+      break;
+
+    case 7:  // SET
+      Jump=ShiftRegisterHostPIOWrite(Block, StateMachine, Operation, Argument, 5, Config->set_base, Config->set_count);
+      break;
+  }
+  if(Stall)
+  {
+    StateMachine->Stalled=true;
+    StateMachine->Stalls++;
+    return;
+  }
+
+  // The delay follows the instruction.
+  if(!Jump)
+    StateMachine->PC=(StateMachine->PC==Config->wrap?Config->wrap_target:(StateMachine->PC+1)%PIO_INSTRUCTION_COUNT);
+  StateMachine->NextPS+=StateMachine->PeriodPS*(1u+(Field & ((1u << (5-SideSetBits))-1)));
+  StateMachine->Instructions++;
+}
+
+
+// The state machine owning the FIFO register at an address, or NULL for memory; Tx tells which FIFO.
+ShiftRegisterHostStateMachine *ShiftRegisterHostFIFOAt(uintptr_t Address, bool *Tx)
+{
+  for(uint8_t Block=0; Block<NUM_PIOS; Block++)
+    for(uint8_t counter=0; counter<NUM_PIO_STATE_MACHINES; counter++)
+      if((Address==(uintptr_t)&ShiftRegisterHostPIOBlocks[Block].txf[counter]) ||
+         (Address==(uintptr_t)&ShiftRegisterHostPIOBlocks[Block].rxf[counter]))
+      {
+        *Tx=(Address==(uintptr_t)&ShiftRegisterHostPIOBlocks[Block].txf[counter]);
+        return(&ShiftRegisterHostPIOs[Block].StateMachines[counter]);
+      }
+  return(NULL);
+}
+
+
+// Is the DREQ of a channel asserted; a PIO TX DREQ while the FIFO has room, an RX DREQ while it holds data.
+bool ShiftRegisterHostDREQ(uint DREQ)
+{
+  ShiftRegisterHostStateMachine *StateMachine;
+
+  if(DREQ>=NUM_PIOS*8)
+    return(true);
+  StateMachine=&ShiftRegisterHostPIOs[DREQ/8].StateMachines[DREQ%4];
+  if((DREQ%8)<4)
+    return(StateMachine->TxFIFO.Count<SHIFTREGISTER_HOST_FIFODEPTH);
+  return(StateMachine->RxFIFO.Count>0);
+}
+
+
+// Move one element of a channel; FIFO registers take from and put into the FIFOs of the state machine.
+void ShiftRegisterHostDMATransfer(ShiftRegisterHostDMAChannel *Channel)
+{
+  ShiftRegisterHostStateMachine *StateMachine;
+  uint8_t Size=(uint8_t)(1u << Channel->Config.size);
+  uint32_t Value=0;
+  bool Tx;
+
+  StateMachine=ShiftRegisterHostFIFOAt(Channel->ReadAddr, &Tx);
+  if(StateMachine!=NULL)
+  {
+    ShiftRegisterHostFIFOTake(&StateMachine->RxFIFO, &Value);
+    ShiftRegisterHostWake(StateMachine);
+  }
+  else
+    memcpy(&Value, (const void *)Channel->ReadAddr, Size);
+  StateMachine=ShiftRegisterHostFIFOAt(Channel->WriteAddr, &Tx);
+  if(StateMachine!=NULL)
+  {
+    ShiftRegisterHostFIFOPut(&StateMachine->TxFIFO, Value);
+    ShiftRegisterHostWake(StateMachine);
+  }
+  else
+    memcpy((void *)Channel->WriteAddr, &Value, Size);
+  if(Channel->Config.read_increment)
+    Channel->ReadAddr+=Size;
+  if(Channel->Config.write_increment)
+    Channel->WriteAddr+=Size;
+  Channel->Transfers++;
+}
+
+
+// Perform the transfers of the busy DMA channels while their DREQ is asserted. Returns true if a completed channel raised
+// an interrupt.
+bool ShiftRegisterHostServiceDMA(void)
+{
+  ShiftRegisterHostDMAChannel *Channel;
+  bool Raised=false;
+
+  for(uint8_t counter=0; counter<NUM_DMA_CHANNELS; counter++)
+  {
+    Channel=&ShiftRegisterHostDMA[counter];
+    while(Channel->Busy && ShiftRegisterHostDREQ(Channel->Config.dreq))
+    {
+      ShiftRegisterHostDMATransfer(Channel);
+      if(--Channel->Count>0)
+        continue;
+      Channel->Busy=false;
+      Channel->IRQ0Raised=true;
+      Raised|=Channel->IRQ0Enabled;
+    }
+  }
+  return(Raised);
+}
+
+
+// Is an enabled interrupt with handlers raised by the hardware; only DMA_IRQ_0 has sources.
+bool ShiftRegisterHostIRQPending(uint num)
+{
+  bool Handled=false;
+
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXHANDLERS; counter++)
+    Handled|=(ShiftRegisterHostHandlers[num][counter]!=NULL);
+  if((num!=DMA_IRQ_0) || ((ShiftRegisterHostIRQEnabled & (1u << num))==0) || (!Handled))
+    return(false);
+  for(uint8_t counter=0; counter<NUM_DMA_CHANNELS; counter++)
+    if(ShiftRegisterHostDMA[counter].IRQ0Enabled && ShiftRegisterHostDMA[counter].IRQ0Raised)
+      return(true);
+  return(false);
+}
+
+
+// Run the background hardware up to UntilNS; the DMA channels are serviced before every instruction of the state machines,
+// which are executed in the order of time. With StopOnIRQ it returns false as soon as an interrupt is raised, at the time
+// it is raised.
+bool ShiftRegisterHostRun(uint64_t UntilNS, bool StopOnIRQ)
+{
+  ShiftRegisterHostStateMachine *Next, *StateMachine;
+  uint8_t NextBlock=0;
+
+  while(true)
+  {
+    if(ShiftRegisterHostServiceDMA() && StopOnIRQ && ShiftRegisterHostIRQPending(DMA_IRQ_0))
+      return(false);
+    Next=NULL;
+    for(uint8_t Block=0; Block<NUM_PIOS; Block++)
+      for(uint8_t counter=0; counter<NUM_PIO_STATE_MACHINES; counter++)
+      {
+        StateMachine=&ShiftRegisterHostPIOs[Block].StateMachines[counter];
+        if(StateMachine->Enabled && (!StateMachine->Stalled) && (StateMachine->NextPS<=UntilNS*1000) &&
+           ((Next==NULL) || (StateMachine->NextPS<Next->NextPS)))
+        {
+          Next=StateMachine;
+          NextBlock=Block;
+        }
+      }
+    if(Next==NULL)
+      return(true);
+    if(Next->NextPS/1000>ShiftRegisterHost.TimeNS)
+      ShiftRegisterHost.TimeNS=Next->NextPS/1000;
+    ShiftRegisterHostPIOStep(NextBlock, Next);
+  }
+}
+
+
+// Call the handlers of the interrupts raised by the hardware. Returns false if none was pending.
+bool ShiftRegisterHostDispatchIRQ(void)
+{
+  bool Dispatched=false;
+
+  for(uint num=0; num<SHIFTREGISTER_HOST_IRQS; num++)
+  {
+    if(!ShiftRegisterHostIRQPending(num))
+      continue;
+    ShiftRegisterHost.InInterrupt=true;
+    for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXHANDLERS; counter++)
+      if(ShiftRegisterHostHandlers[num][counter]!=NULL)
+        ShiftRegisterHostHandlers[num][counter]();
+    ShiftRegisterHost.InInterrupt=false;
+    Dispatched=true;
+  }
+  return(Dispatched);
+}
+
+
+// Advance the time by NS nanoseconds; the background hardware runs meanwhile. All time passing in the simulator goes
+// through here.
+void ShiftRegisterHostAdvance(uint64_t NS)
+{
+  uint64_t UntilNS=ShiftRegisterHost.TimeNS+NS;
+
+  ShiftRegisterHostRun(UntilNS, false);
+  ShiftRegisterHost.TimeNS=UntilNS;
+}
+
+
+// Advance the time to UntilNS, handling the interrupts and firing the repeating timers that are due on the way. Nothing
+// fires from within a timer callback or interrupt handler.
+void ShiftRegisterHostWait(uint64_t UntilNS)
+{
+  ShiftRegisterHostTimer *Timer;
+  repeating_timer_t *Current;
+  uint64_t PeriodNS, TargetNS;
+  bool Again;
+
+  if(ShiftRegisterHost.InInterrupt)
+  {
+    if(ShiftRegisterHost.TimeNS<UntilNS)
+      ShiftRegisterHostAdvance(UntilNS-ShiftRegisterHost.TimeNS);
+    return;
+  }
+  while(true)
+  {
+    if(ShiftRegisterHostDispatchIRQ())
+      continue;
+
+    // Find the first timer that is due and run the hardware upto it; an interrupt on the way is handled first.
+    Timer=NULL;
+    for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXTIMERS; counter++)
+      if((ShiftRegisterHost.Timers[counter].Timer!=NULL) && (ShiftRegisterHost.Timers[counter].DueNS<=UntilNS) &&
+         ((Timer==NULL) || (ShiftRegisterHost.Timers[counter].DueNS<Timer->DueNS)))
+        Timer=&ShiftRegisterHost.Timers[counter];
+    TargetNS=(Timer!=NULL?Timer->DueNS:UntilNS);
+    if((TargetNS>ShiftRegisterHost.TimeNS) && (!ShiftRegisterHostRun(TargetNS, true)))
+      continue;
+    if(ShiftRegisterHost.TimeNS<TargetNS)
+      ShiftRegisterHost.TimeNS=TargetNS;
+    if(Timer==NULL)
+      break;
+
+    // Call it; the callback may change delay_us or cancel the timer.
+    Current=Timer->Timer;
+    ShiftRegisterHost.InInterrupt=true;
+    Again=Current->callback(Current);
+    ShiftRegisterHost.InInterrupt=false;
+    if(Timer->Timer!=Current)
+      continue;
+    PeriodNS=(uint64_t)(Current->delay_us<0?-Current->delay_us:Current->delay_us)*1000;
+    if(PeriodNS==0)
+      PeriodNS=1000;
+    if(!Again)
+      Timer->Timer=NULL;
+    else if(Current->delay_us<0)
+      Timer->DueNS+=PeriodNS;  // Negative delay; the period runs from the start of the previous call.
+    else
+      Timer->DueNS=ShiftRegisterHost.TimeNS+PeriodNS;
+  }
+}
+
+
+// Set the output level of a port by the CPU; the port is driven if it is assigned to SIO.
+void ShiftRegisterHostSetOut(uint gpio, bool Level)
+{
+  ShiftRegisterHost.Out[gpio]=Level;
+  if(Level)
+    ShiftRegisterHostSIO.gpio_out|=(1u << gpio);
+  else
+    ShiftRegisterHostSIO.gpio_out&=~(1u << gpio);
+  if(ShiftRegisterHost.Peripheral[gpio]==0)
+    ShiftRegisterHostDrive(1u << gpio, (uint32_t)Level << gpio);
+}
+
+
+// The pico SDK functions used by the library.
+void gpio_init(uint gpio)
+{
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  if(gpio>=SHIFTREGISTER_HOST_GPIOS)
+    return;
+  ShiftRegisterHost.Peripheral[gpio]=0;
+  ShiftRegisterHostSetOut(gpio, false);
+}
+
+
+void gpio_set_dir(uint gpio, bool out)
+{
+  (void)gpio;
+  (void)out;
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+}
+
+
+void gpio_put(uint gpio, bool value)
+{
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  if(gpio>=SHIFTREGISTER_HOST_GPIOS)
+    return;
+  ShiftRegisterHostSetOut(gpio, value);
+}
+
+
+bool gpio_get(uint gpio)
+{
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  return(ShiftRegisterHostSample(gpio));
+}
+
+
+// Assign a port to a peripheral; assigned back to SIO it takes the level last set with gpio_put().
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  if(gpio>=SHIFTREGISTER_HOST_GPIOS)
+    return;
+  ShiftRegisterHost.Peripheral[gpio]=(fn==GPIO_FUNC_SIO?0:(uint8_t)fn);
+  if(fn==GPIO_FUNC_SIO)
+    ShiftRegisterHostDrive(1u << gpio, (uint32_t)ShiftRegisterHost.Out[gpio] << gpio);
+}
+
+
+// A store to gpio_set, gpio_clr or gpio_togl; takes one cycle. All ports in Mask change at once.
+void ShiftRegisterHostSIOStore(uint8_t Register, uint32_t Mask)
+{
+  uint32_t Driven=0, Levels=0;
+  bool Level;
+
+  ShiftRegisterHostAdvance((1000000000u+ShiftRegisterHost.ClockHz-1)/ShiftRegisterHost.ClockHz);
+  if(ShiftRegisterHostStoreCount<SHIFTREGISTER_HOST_MAXSTORES)
+  {
+    ShiftRegisterHostStores[ShiftRegisterHostStoreCount].Register=Register;
+    ShiftRegisterHostStores[ShiftRegisterHostStoreCount].Mask=Mask;
+    ShiftRegisterHostStores[ShiftRegisterHostStoreCount].TimeNS=ShiftRegisterHost.TimeNS;
+  }
+  ShiftRegisterHostStoreCount++;
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+  {
+    if((Mask & (1u << gpio))==0)
+      continue;
+    Level=(Register==SHIFTREGISTER_HOST_SIO_SET?true:(Register==SHIFTREGISTER_HOST_SIO_CLR?false:!ShiftRegisterHost.Out[gpio]));
+    ShiftRegisterHost.Out[gpio]=Level;
+    if(Level)
+      ShiftRegisterHostSIO.gpio_out|=(1u << gpio);
+    else
+      ShiftRegisterHostSIO.gpio_out&=~(1u << gpio);
+    if(ShiftRegisterHost.Peripheral[gpio]==0)
+    {
+      Driven|=(1u << gpio);
+      Levels|=((uint32_t)Level << gpio);
+    }
+  }
+  ShiftRegisterHostDrive(Driven, Levels);
+}
+
+
+void gpio_set_mask(uint32_t mask)
+{
+  ShiftRegisterHostSIOStore(SHIFTREGISTER_HOST_SIO_SET, mask);
+}
+
+
+void gpio_clr_mask(uint32_t mask)
+{
+  ShiftRegisterHostSIOStore(SHIFTREGISTER_HOST_SIO_CLR, mask);
+}
+
+
+void gpio_xor_mask(uint32_t mask)
+{
+  ShiftRegisterHostSIOStore(SHIFTREGISTER_HOST_SIO_TOGL, mask);
+}
+
+
+// Read all ports at once; takes one cycle.
+uint32_t gpio_get_all(void)
+{
+  uint32_t Value=0;
+
+  ShiftRegisterHostAdvance((1000000000u+ShiftRegisterHost.ClockHz-1)/ShiftRegisterHost.ClockHz);
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+    if(ShiftRegisterHostSample(gpio))
+      Value|=(1u << gpio);
+  return(Value);
+}
+
+
+void sleep_us(uint64_t us)
+{
+  ShiftRegisterHostWait(ShiftRegisterHost.TimeNS+us*1000);
+}
+
+
+void sleep_ms(uint32_t ms)
+{
+  ShiftRegisterHostWait(ShiftRegisterHost.TimeNS+(uint64_t)ms*1000000);
+}
+
+
+void busy_wait_at_least_cycles(uint32_t cycles)
+{
+  ShiftRegisterHostAdvance(((uint64_t)cycles*1000000000+ShiftRegisterHost.ClockHz-1)/ShiftRegisterHost.ClockHz);
+}
+
+
+uint32_t time_us_32(void)
+{
+  return((uint32_t)(ShiftRegisterHost.TimeNS/1000));
+}
+
+
+uint64_t time_us_64(void)
+{
+  return(ShiftRegisterHost.TimeNS/1000);
+}
+
+
+void tight_loop_contents(void)
+{
+  ShiftRegisterHostWait(ShiftRegisterHost.TimeNS+ShiftRegisterHost.GPIONS);
+}
+
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out)
+{
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXTIMERS; counter++)
+    if(ShiftRegisterHost.Timers[counter].Timer==NULL)
+    {
+      out->delay_us=delay_us;
+      out->callback=callback;
+      out->user_data=user_data;
+      ShiftRegisterHost.Timers[counter].Timer=out;
+      ShiftRegisterHost.Timers[counter].DueNS=ShiftRegisterHost.TimeNS+(uint64_t)(delay_us<0?-delay_us:delay_us)*1000;
+      return(true);
+    }
+  return(false);
+}
+
+
+bool cancel_repeating_timer(repeating_timer_t *timer)
+{
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXTIMERS; counter++)
+    if(ShiftRegisterHost.Timers[counter].Timer==timer)
+    {
+      ShiftRegisterHost.Timers[counter].Timer=NULL;
+      return(true);
+    }
+  return(false);
+}
+
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+  (void)clk_index;
+  return(ShiftRegisterHost.ClockHz);
+}
+
+
+// The pico SDK functions of hardware/pio.h.
+int ShiftRegisterHostFindProgramSpace(PIO pio, const pio_program_t *program)
+{
+  uint32_t Used=ShiftRegisterHostPIOs[pio-ShiftRegisterHostPIOBlocks].Used, Mask=(1u << program->length)-1;
+
+  // Programs without origin are placed as high as possible, like the SDK does.
+  if(program->origin>=0)
+    return(((program->origin+program->length<=PIO_INSTRUCTION_COUNT) && ((Used & (Mask << program->origin))==0))?program->origin:-1);
+  for(int Offset=PIO_INSTRUCTION_COUNT-program->length; Offset>=0; Offset--)
+    if((Used & (Mask << Offset))==0)
+      return(Offset);
+  return(-1);
+}
+
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program)
+{
+  return(ShiftRegisterHostFindProgramSpace(pio, program)>=0);
+}
+
+
+// Load a program; JMP instructions are relocated to the offset. There is no error handling; check with pio_can_add_program().
+uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+  ShiftRegisterHostPIO *Block=&ShiftRegisterHostPIOs[pio-ShiftRegisterHostPIOBlocks];
+  int Offset=ShiftRegisterHostFindProgramSpace(pio, program);
+  uint16_t Instruction;
+
+  if(Offset<0)
+    return(0);
+  for(uint8_t counter=0; counter<program->length; counter++)
+  {
+    Instruction=program->instructions[counter];
+    Block->Memory[Offset+counter]=((Instruction>>13)==0?Instruction+Offset:Instruction);
+  }
+  Block->Used|=((1u << program->length)-1) << Offset;
+  return((uint)Offset);
+}
+
+
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset)
+{
+  ShiftRegisterHostPIOs[pio-ShiftRegisterHostPIOBlocks].Used&=~(((1u << program->length)-1) << loaded_offset);
+}
+
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+  ShiftRegisterHostPIO *Block=&ShiftRegisterHostPIOs[pio-ShiftRegisterHostPIOBlocks];
+
+  for(uint8_t counter=0; counter<NUM_PIO_STATE_MACHINES; counter++)
+    if(!Block->StateMachines[counter].Claimed)
+    {
+      Block->StateMachines[counter].Claimed=true;
+      return(counter);
+    }
+  if(required)
+  {
+    fprintf(stderr, "No PIO state machines are available\n");
+    abort();
+  }
+  return(-1);
+}
+
+
+void pio_sm_unclaim(PIO pio, uint sm)
+{
+  ShiftRegisterHostGetStateMachine(pio, sm)->Claimed=false;
+}
+
+
+// The defaults of the SDK: no side-set, wrap around the whole memory, shift right without autopull/autopush.
+pio_sm_config pio_get_default_sm_config(void)
+{
+  pio_sm_config Config;
+
+  memset(&Config, 0, sizeof(pio_sm_config));
+  Config.clkdiv=1.0f;
+  Config.wrap=PIO_INSTRUCTION_COUNT-1;
+  Config.out_shift_right=true;
+  Config.in_shift_right=true;
+  Config.out_count=32;
+  return(Config);
+}
+
+
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap)
+{
+  c->wrap_target=(uint8_t)wrap_target;
+  c->wrap=(uint8_t)wrap;
+}
+
+
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs)
+{
+  c->sideset_bit_count=(uint8_t)bit_count;
+  c->sideset_optional=optional;
+  c->sideset_pindirs=pindirs;
+}
+
+
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base)
+{
+  c->sideset_base=(uint8_t)sideset_base;
+}
+
+
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count)
+{
+  c->set_base=(uint8_t)set_base;
+  c->set_count=(uint8_t)set_count;
+}
+
+
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count)
+{
+  c->out_base=(uint8_t)out_base;
+  c->out_count=(uint8_t)out_count;
+}
+
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base)
+{
+  c->in_base=(uint8_t)in_base;
+}
+
+
+// A threshold of 32 is stored as 0, as in the SHIFTCTRL register.
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold)
+{
+  c->out_shift_right=shift_right;
+  c->autopull=autopull;
+  c->pull_threshold=(uint8_t)(pull_threshold & 0x1f);
+}
+
+
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold)
+{
+  c->in_shift_right=shift_right;
+  c->autopush=autopush;
+  c->push_threshold=(uint8_t)(push_threshold & 0x1f);
+}
+
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div)
+{
+  c->clkdiv=div;
+}
+
+
+void pio_gpio_init(PIO pio, uint pin)
+{
+  gpio_set_function(pin, (enum gpio_function)(GPIO_FUNC_PIO0+(pio-ShiftRegisterHostPIOBlocks)));
+}
+
+
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask)
+{
+  (void)sm;
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+    if((pin_mask & (1u << gpio))>0)
+      ShiftRegisterHostPIOPins((uint8_t)(pio-ShiftRegisterHostPIOBlocks), gpio, 1, pin_values>>gpio);
+}
+
+
+// Pin directions are not simulated; the ports of a PIO block are always outputs.
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask)
+{
+  (void)pio;
+  (void)sm;
+  (void)pin_dirs;
+  (void)pin_mask;
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+}
+
+
+// Reset the state machine and apply the configuration. The clock divider has 8 fractional bits, as on the RP2040.
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config)
+{
+  ShiftRegisterHostStateMachine *StateMachine=ShiftRegisterHostGetStateMachine(pio, sm);
+  uint32_t Integer=(uint32_t)config->clkdiv, Fraction=(uint32_t)((config->clkdiv-(float)Integer)*256.0f);
+
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  StateMachine->Enabled=false;
+  StateMachine->Stalled=false;
+  StateMachine->Config=*config;
+  StateMachine->PC=(uint8_t)initial_pc;
+  StateMachine->X=StateMachine->Y=StateMachine->ISR=StateMachine->OSR=0;
+  StateMachine->ISRCount=0;
+  StateMachine->OSRCount=32;
+  memset(&StateMachine->TxFIFO, 0, sizeof(ShiftRegisterHostFIFO));
+  memset(&StateMachine->RxFIFO, 0, sizeof(ShiftRegisterHostFIFO));
+  StateMachine->PeriodPS=((uint64_t)(Integer*256+Fraction)*3906250000ull+ShiftRegisterHost.ClockHz/2)/ShiftRegisterHost.ClockHz;
+}
+
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+  ShiftRegisterHostStateMachine *StateMachine=ShiftRegisterHostGetStateMachine(pio, sm);
+
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  if(enabled && (!StateMachine->Enabled))
+  {
+    StateMachine->Stalled=false;
+    StateMachine->NextPS=ShiftRegisterHost.TimeNS*1000;
+  }
+  StateMachine->Enabled=enabled;
+}
+
+
+// Put a word in the TX FIFO; waits (in steps of GPIONS) while it is full.
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+  ShiftRegisterHostStateMachine *StateMachine=ShiftRegisterHostGetStateMachine(pio, sm);
+
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  while(!ShiftRegisterHostFIFOPut(&StateMachine->TxFIFO, data))
+    ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  ShiftRegisterHostWake(StateMachine);
+}
+
+
+// Take a word from the RX FIFO; waits (in steps of GPIONS) while it is empty.
+uint32_t pio_sm_get_blocking(PIO pio, uint sm)
+{
+  ShiftRegisterHostStateMachine *StateMachine=ShiftRegisterHostGetStateMachine(pio, sm);
+  uint32_t Data;
+
+  ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  while(!ShiftRegisterHostFIFOTake(&StateMachine->RxFIFO, &Data))
+    ShiftRegisterHostAdvance(ShiftRegisterHost.GPIONS);
+  ShiftRegisterHostWake(StateMachine);
+  return(Data);
+}
+
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+  return((uint)(pio-ShiftRegisterHostPIOBlocks)*8+(is_tx?0:4)+sm);
+}
+
+
+// The pico SDK functions of hardware/dma.h and hardware/irq.h; setting up the channels takes no time.
+int dma_claim_unused_channel(bool required)
+{
+  for(uint8_t counter=0; counter<NUM_DMA_CHANNELS; counter++)
+    if(!ShiftRegisterHostDMA[counter].Claimed)
+    {
+      ShiftRegisterHostDMA[counter].Claimed=true;
+      return(counter);
+    }
+  if(required)
+  {
+    fprintf(stderr, "No DMA channels are available\n");
+    abort();
+  }
+  return(-1);
+}
+
+
+void dma_channel_unclaim(uint channel)
+{
+  ShiftRegisterHostDMA[channel].Claimed=false;
+}
+
+
+// The defaults of the SDK: 32 bit transfers, incrementing reads, unpaced.
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+  dma_channel_config Config={DMA_SIZE_32, true, false, DREQ_FORCE};
+
+  (void)channel;
+  return(Config);
+}
+
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+  c->size=size;
+}
+
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+  c->read_increment=incr;
+}
+
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+  c->write_increment=incr;
+}
+
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+  c->dreq=dreq;
+}
+
+
+// Trigger a channel; it transfers TransferCount elements from its current addresses.
+void ShiftRegisterHostTriggerDMA(ShiftRegisterHostDMAChannel *Channel)
+{
+  Channel->Count=Channel->TransferCount;
+  Channel->Busy=(Channel->Count>0);
+}
+
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr,
+                           uint transfer_count, bool trigger)
+{
+  ShiftRegisterHostDMAChannel *Channel=&ShiftRegisterHostDMA[channel];
+
+  Channel->Config=*config;
+  Channel->WriteAddr=(uintptr_t)write_addr;
+  Channel->ReadAddr=(uintptr_t)read_addr;
+  Channel->TransferCount=transfer_count;
+  if(trigger)
+    ShiftRegisterHostTriggerDMA(Channel);
+}
+
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger)
+{
+  ShiftRegisterHostDMA[channel].ReadAddr=(uintptr_t)read_addr;
+  if(trigger)
+    ShiftRegisterHostTriggerDMA(&ShiftRegisterHostDMA[channel]);
+}
+
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger)
+{
+  ShiftRegisterHostDMA[channel].WriteAddr=(uintptr_t)write_addr;
+  if(trigger)
+    ShiftRegisterHostTriggerDMA(&ShiftRegisterHostDMA[channel]);
+}
+
+
+bool dma_channel_is_busy(uint channel)
+{
+  return(ShiftRegisterHostDMA[channel].Busy);
+}
+
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+  ShiftRegisterHostDMA[channel].IRQ0Enabled=enabled;
+}
+
+
+bool dma_channel_get_irq0_status(uint channel)
+{
+  return(ShiftRegisterHostDMA[channel].IRQ0Enabled && ShiftRegisterHostDMA[channel].IRQ0Raised);
+}
+
+
+void dma_channel_acknowledge_irq0(uint channel)
+{
+  ShiftRegisterHostDMA[channel].IRQ0Raised=false;
+}
+
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+  (void)order_priority;
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXHANDLERS; counter++)
+    if(ShiftRegisterHostHandlers[num][counter]==NULL)
+    {
+      ShiftRegisterHostHandlers[num][counter]=handler;
+      return;
+    }
+  fprintf(stderr, "No shared handler slots are available for interrupt %u\n", num);
+  abort();
+}
+
+
+void irq_remove_handler(uint num, irq_handler_t handler)
+{
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXHANDLERS; counter++)
+    if(ShiftRegisterHostHandlers[num][counter]==handler)
+      ShiftRegisterHostHandlers[num][counter]=NULL;
+}
+
+
+void irq_set_enabled(uint num, bool enabled)
+{
+  if(enabled)
+    ShiftRegisterHostIRQEnabled|=(1u << num);
+  else
+    ShiftRegisterHostIRQEnabled&=~(1u << num);
+}
+
+
+// The port with an SPI function (GPIO number modulo 4: 0 RX, 2 SCK, 3 TX) that is assigned to the peripheral, or
+// SHIFTREGISTER_HOST_NOPIN.
+uint8_t ShiftRegisterHostSPIPin(spi_inst_t *spi, uint8_t Function)
+{
+  uint8_t Instance=(uint8_t)(spi-ShiftRegisterHostSPIs);
+
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+    if((ShiftRegisterHost.Peripheral[gpio]==GPIO_FUNC_SPI) && ((gpio & 3)==Function) && (((gpio>>3) & 1)==Instance))
+      return(gpio);
+  return(SHIFTREGISTER_HOST_NOPIN);
+}
+
+
+// Clock one octet out on TX and in from RX, MSB first in mode 0: TX changes half a bit period before the rising edge of
+// SCK, RX is sampled at the rising edge and SCK falls half a period later.
+uint8_t ShiftRegisterHostSPITransfer(spi_inst_t *spi, uint8_t Octet)
+{
+  uint8_t SCK=ShiftRegisterHostSPIPin(spi, 2), TX=ShiftRegisterHostSPIPin(spi, 3), RX=ShiftRegisterHostSPIPin(spi, 0);
+  uint64_t HalfNS=(1000000000ull+2ull*spi->BaudHz-1)/(2ull*spi->BaudHz);
+  uint8_t Value=0;
+
+  for(int8_t Bit=7; Bit>=0; Bit--)
+  {
+    if(TX!=SHIFTREGISTER_HOST_NOPIN)
+      ShiftRegisterHostDrive(1u << TX, (uint32_t)((Octet>>Bit) & 1) << TX);
+    ShiftRegisterHostAdvance(HalfNS);
+    Value=(uint8_t)(Value<<1) | ((RX!=SHIFTREGISTER_HOST_NOPIN) && ShiftRegisterHostSample(RX));
+    if(SCK!=SHIFTREGISTER_HOST_NOPIN)
+      ShiftRegisterHostDrive(1u << SCK, 1u << SCK);
+    ShiftRegisterHostAdvance(HalfNS);
+    if(SCK!=SHIFTREGISTER_HOST_NOPIN)
+      ShiftRegisterHostDrive(1u << SCK, 0);
+  }
+  spi->Octets++;
+  return(Value);
+}
+
+
+// The bit rate is clk_peri (clk_sys here) divided by an even divider of at least 2; returns the rate set.
+uint spi_init(spi_inst_t *spi, uint baudrate)
+{
+  uint32_t Divider=(ShiftRegisterHost.ClockHz+baudrate-1)/baudrate;
+
+  Divider=(Divider<2?2:Divider+(Divider & 1));
+  spi->Enabled=true;
+  spi->BaudHz=ShiftRegisterHost.ClockHz/Divider;
+  spi->DataBits=8;
+  spi->CPOL=SPI_CPOL_0;
+  spi->CPHA=SPI_CPHA_0;
+  spi->Order=SPI_MSB_FIRST;
+  return(spi->BaudHz);
+}
+
+
+void spi_deinit(spi_inst_t *spi)
+{
+  spi->Enabled=false;
+}
+
+
+// Only 8 data bits in mode 0, MSB first are emulated; the format is kept for checks.
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order)
+{
+  spi->DataBits=(uint8_t)data_bits;
+  spi->CPOL=cpol;
+  spi->CPHA=cpha;
+  spi->Order=order;
+}
+
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+  if(!spi->Enabled)
+    return(0);
+  for(size_t counter=0; counter<len; counter++)
+    ShiftRegisterHostSPITransfer(spi, src[counter]);
+  return((int)len);
+}
+
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len)
+{
+  if(!spi->Enabled)
+    return(0);
+  for(size_t counter=0; counter<len; counter++)
+    dst[counter]=ShiftRegisterHostSPITransfer(spi, repeated_tx_data);
+  return((int)len);
+}
+
+
+// The event of __sev() and __wfe(), and the thread running core1.
+static pthread_mutex_t ShiftRegisterHostEventLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ShiftRegisterHostEventSignal=PTHREAD_COND_INITIALIZER;
+static bool ShiftRegisterHostEvent, ShiftRegisterHostCore1Running, ShiftRegisterHostCore1Reset;
+static pthread_t ShiftRegisterHostCore1;
+static void (*ShiftRegisterHostCore1Entry)(void);
+
+
+void __sev(void)
+{
+  pthread_mutex_lock(&ShiftRegisterHostEventLock);
+  ShiftRegisterHostEvent=true;
+  pthread_cond_broadcast(&ShiftRegisterHostEventSignal);
+  pthread_mutex_unlock(&ShiftRegisterHostEventLock);
+}
+
+
+// Wait for the event and clear it. Core1 ends here when it is reset.
+void __wfe(void)
+{
+  pthread_mutex_lock(&ShiftRegisterHostEventLock);
+  while((!ShiftRegisterHostEvent) && (!ShiftRegisterHostCore1Reset))
+    pthread_cond_wait(&ShiftRegisterHostEventSignal, &ShiftRegisterHostEventLock);
+  ShiftRegisterHostEvent=false;
+  if(ShiftRegisterHostCore1Reset && pthread_equal(pthread_self(), ShiftRegisterHostCore1))
+  {
+    pthread_mutex_unlock(&ShiftRegisterHostEventLock);
+    pthread_exit(NULL);
+  }
+  pthread_mutex_unlock(&ShiftRegisterHostEventLock);
+}
+
+
+void *ShiftRegisterHostCore1Thread(void *Argument)
+{
+  (void)Argument;
+  ShiftRegisterHostCore1Entry();
+  return(NULL);
+}
+
+
+void multicore_launch_core1(void (*entry)(void))
+{
+  if(ShiftRegisterHostCore1Running)
+    return;
+  ShiftRegisterHostCore1Entry=entry;
+  ShiftRegisterHostCore1Reset=false;
+  ShiftRegisterHostCore1Running=(pthread_create(&ShiftRegisterHostCore1, NULL, ShiftRegisterHostCore1Thread, NULL)==0);
+}
+
+
+// Stop core1; it ends at its next __wfe() (or when its entry function returns).
+void multicore_reset_core1(void)
+{
+  if(!ShiftRegisterHostCore1Running)
+    return;
+  pthread_mutex_lock(&ShiftRegisterHostEventLock);
+  ShiftRegisterHostCore1Reset=true;
+  pthread_cond_broadcast(&ShiftRegisterHostEventSignal);
+  pthread_mutex_unlock(&ShiftRegisterHostEventLock);
+  pthread_join(ShiftRegisterHostCore1, NULL);
+  ShiftRegisterHostCore1Running=false;
+  ShiftRegisterHostCore1Reset=false;
+  ShiftRegisterHostEvent=false;
+}
+
+
+void critical_section_init(critical_section_t *crit_sec)
+{
+  pthread_mutex_init(&crit_sec->Mutex, NULL);
+}
+
+
+void critical_section_enter_blocking(critical_section_t *crit_sec)
+{
+  pthread_mutex_lock(&crit_sec->Mutex);
+}
+
+
+void critical_section_exit(critical_section_t *crit_sec)
+{
+  pthread_mutex_unlock(&crit_sec->Mutex);
+}
+
+
+void critical_section_deinit(critical_section_t *crit_sec)
+{
+  pthread_mutex_destroy(&crit_sec->Mutex);
+}
+
+#endif
@@ -0,0 +1,240 @@
+/*
+
+  Multiplexed LED matrix driver for the ShiftRegister library. The matrix is connected to a chain of 74HC595 chips: the
+  first ColumnOctets octets of the frame drive the columns, the next octets select the row (one output per row). The driver
+  owns a framebuffer and scans the rows from a repeating timer interrupt, one row per interrupt; the application only
+  changes pixels (ShiftRegisterMatrixSetPixel() etc.). Every interrupt shifts one frame and pulses the latch, regardless of
+  the content of the framebuffer, so the CPU time per refresh is fixed: Rows frames.
+
+  Ghosting (the previous row glowing in the new one while the drivers switch) is avoided by blanking the outputs around the
+  row change when Blank is set (the default):
+  - With the output-enable line of the chips (EnableGPIO, active low) connected, the outputs are disabled while the next row
+    is latched and enabled again BlankNS nanoseconds later.
+  - Without it (EnableGPIO is SHIFTREGISTER_MATRIX_NOPIN), a frame with all rows and columns off is latched before the next
+    row is shifted in; this doubles the time spent shifting.
+  Set RowActiveLow and/or ColumnActiveLow for drivers that switch on a low output (e.g. PNP/P-channel row drivers).
+
+  Pixels are stored per row as ColumnOctets octets; column n is bit (0x80 >> (n % 8)) of octet n / 8 of the row, as in the
+  octet layout of the register (octet 0 is shifted first). Pixel changes are picked up by the next scan of the row; a row
+  scanned while it is being changed may show part of the change for one refresh.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterMatrix
+#define MyHardwareShiftRegisterMatrix
+
+#include "ShiftRegister.c"
+
+
+#define SHIFTREGISTER_MATRIX_NOPIN         255  // No output-enable line connected.
+#define SHIFTREGISTER_MATRIX_NOROW         0xffff
+#define SHIFTREGISTER_MATRIX_BLANK_NS      1000 // Default blanking time around the row change.
+
+
+typedef struct
+{
+  ShiftRegister *Register;
+  const ShiftRegisterTransport *Transport;
+
+  // Size of the matrix and the layout of the frame.
+  uint16_t Rows, Columns, ColumnOctets;
+
+  // Framebuffer (Rows * ColumnOctets octets), the frame being shifted and the frame with all outputs off.
+  uint8_t *Pixels, *Frame, *BlankFrame;
+
+  // Settings; can be adjusted before ShiftRegisterMatrixStart().
+  uint8_t EnableGPIO;
+  bool Blank, RowActiveLow, ColumnActiveLow;
+  uint32_t BlankNS, BlankCycles;
+
+  // Row scanned by the next interrupt.
+  uint16_t Row;
+  uint32_t RowPeriodUS;
+
+  repeating_timer_t Timer;
+  bool Running;
+} ShiftRegisterMatrix;
+
+
+// The pixels of a row; ColumnOctets octets.
+uint8_t *ShiftRegisterMatrixRow(ShiftRegisterMatrix *Matrix, uint16_t Row)
+{
+  return(Matrix->Pixels+Row*Matrix->ColumnOctets);
+}
+
+
+void ShiftRegisterMatrixSetPixel(ShiftRegisterMatrix *Matrix, uint16_t Row, uint16_t Column, bool On)
+{
+  uint8_t *Octet;
+
+  if((Row>=Matrix->Rows) || (Column>=Matrix->Columns))
+    return;
+  Octet=ShiftRegisterMatrixRow(Matrix, Row)+Column/8;
+  if(On)
+    *Octet|=(0x80 >> (Column%8));
+  else
+    *Octet&=~(0x80 >> (Column%8));
+}
+
+
+bool ShiftRegisterMatrixGetPixel(ShiftRegisterMatrix *Matrix, uint16_t Row, uint16_t Column)
+{
+  if((Row>=Matrix->Rows) || (Column>=Matrix->Columns))
+    return(false);
+  return((ShiftRegisterMatrixRow(Matrix, Row)[Column/8] & (0x80 >> (Column%8)))>0);
+}
+
+
+// Switch all pixels off.
+void ShiftRegisterMatrixClear(ShiftRegisterMatrix *Matrix)
+{
+  memset(Matrix->Pixels, 0, Matrix->Rows*Matrix->ColumnOctets);
+}
+
+
+// Build the frame of a row (or the blank frame for SHIFTREGISTER_MATRIX_NOROW), applying the polarity of the drivers.
+void ShiftRegisterMatrixBuildFrame(ShiftRegisterMatrix *Matrix, uint16_t Row, uint8_t *Frame)
+{
+  uint8_t ColumnInvert=(Matrix->ColumnActiveLow?0xff:0x00), RowInvert=(Matrix->RowActiveLow?0xff:0x00);
+  uint16_t SizeInOctets=Matrix->Register->SizeInOctets;
+
+  for(uint16_t counter=0; counter<Matrix->ColumnOctets; counter++)
+    Frame[counter]=(Row!=SHIFTREGISTER_MATRIX_NOROW?ShiftRegisterMatrixRow(Matrix, Row)[counter]:0) ^ ColumnInvert;
+  for(uint16_t counter=Matrix->ColumnOctets; counter<SizeInOctets; counter++)
+    Frame[counter]=RowInvert;
+  if(Row!=SHIFTREGISTER_MATRIX_NOROW)
+    Frame[Matrix->ColumnOctets+Row/8]^=(0x80 >> (Row%8));
+}
+
+
+// Shift a frame in and latch it; transports performing complete transfers take it from the output buffer. The outputs are
+// disabled around the latch pulse when blanking with the output-enable line.
+void ShiftRegisterMatrixWriteFrame(ShiftRegisterMatrix *Matrix, const uint8_t *Frame)
+{
+  ShiftRegister *Register=Matrix->Register;
+  bool Disable=(Matrix->Blank && (Matrix->EnableGPIO!=SHIFTREGISTER_MATRIX_NOPIN));
+
+  if(Matrix->Transport->Transfer!=NULL)
+    ShiftRegisterLoadFrame(Register, Frame);
+  else
+    ShiftRegisterShiftOutOctets(Register, Matrix->Transport, Frame);
+  if(Disable)
+    gpio_put(Matrix->EnableGPIO, 1);
+  if(Matrix->Transport->Transfer!=NULL)
+    Matrix->Transport->Transfer(Register, false, 0);
+  else
+    ShiftRegisterPulseLatchTransport(Register, Matrix->Transport);
+  if(Disable)
+  {
+    if(Matrix->BlankCycles>0)
+      busy_wait_at_least_cycles(Matrix->BlankCycles);
+    gpio_put(Matrix->EnableGPIO, 0);
+  }
+  SHIFTREGISTER_COUNT(Register, Writes, 1);
+  SHIFTREGISTER_COUNT(Register, BitsOut, Register->SizeInOctets*8u);
+}
+
+
+// Show the next row. Called from the timer interrupt; can also be driven by another timer source.
+void ShiftRegisterMatrixStep(ShiftRegisterMatrix *Matrix)
+{
+  if((Matrix->EnableGPIO==SHIFTREGISTER_MATRIX_NOPIN) && Matrix->Blank)
+    ShiftRegisterMatrixWriteFrame(Matrix, Matrix->BlankFrame);
+  ShiftRegisterMatrixBuildFrame(Matrix, Matrix->Row, Matrix->Frame);
+  ShiftRegisterMatrixWriteFrame(Matrix, Matrix->Frame);
+  Matrix->Row=(Matrix->Row+1<Matrix->Rows?Matrix->Row+1:0);
+}
+
+
+// Timer interrupt; a negative delay makes the timer count from the previous interrupt, so every row gets the same time.
+bool ShiftRegisterMatrixTimerCallback(repeating_timer_t *Timer)
+{
+  ShiftRegisterMatrixStep((ShiftRegisterMatrix *)Timer->user_data);
+  return(true);
+}
+
+
+// Start scanning the matrix RefreshHz times per second. The time per row (1/(RefreshHz*Rows) sec, minimum 1 usec) must be
+// longer than writing a frame (twice when blanking without output-enable line). Returns false if already running or no
+// timer is available.
+bool ShiftRegisterMatrixStart(ShiftRegisterMatrix *Matrix, uint32_t RefreshHz)
+{
+  if(Matrix->Running || (RefreshHz==0))
+    return(false);
+  Matrix->Transport=ShiftRegisterGetTransport(Matrix->Register);
+  Matrix->BlankCycles=ShiftRegisterNSToCycles(Matrix->BlankNS, clock_get_hz(clk_sys));
+  ShiftRegisterMatrixBuildFrame(Matrix, SHIFTREGISTER_MATRIX_NOROW, Matrix->BlankFrame);
+  Matrix->RowPeriodUS=1000000u/(RefreshHz*Matrix->Rows);
+  if(Matrix->RowPeriodUS==0)
+    Matrix->RowPeriodUS=1;
+  Matrix->Row=0;
+  if(!add_repeating_timer_us(-(int64_t)Matrix->RowPeriodUS, ShiftRegisterMatrixTimerCallback, Matrix, &Matrix->Timer))
+    return(false);
+  Matrix->Running=true;
+  return(true);
+}
+
+
+// Stop scanning and switch all outputs off.
+void ShiftRegisterMatrixStop(ShiftRegisterMatrix *Matrix)
+{
+  if(!Matrix->Running)
+    return;
+  cancel_repeating_timer(&Matrix->Timer);
+  ShiftRegisterMatrixWriteFrame(Matrix, Matrix->BlankFrame);
+  Matrix->Running=false;
+  Matrix->Register->LastOutputValid=false;  // The next write can not be skipped.
+}
+
+
+// Create the driver for a matrix of Rows x Columns pixels on an output register; the chain must hold the column octets
+// followed by the row octets. EnableGPIO is the output-enable line of the chips, or SHIFTREGISTER_MATRIX_NOPIN. Returns NULL
+// if the chain is too short, for input registers or if no memory is available.
+ShiftRegisterMatrix *ShiftRegisterMatrixCreate(ShiftRegister *Register, uint16_t Rows, uint16_t Columns, uint8_t EnableGPIO)
+{
+  ShiftRegisterMatrix *Matrix;
+  uint16_t ColumnOctets=(Columns+7)/8;
+
+  if((Register->Type==SHIFTREGISTER_INPUT) || (Rows==0) || (Columns==0) || (ColumnOctets+(Rows+7)/8>Register->SizeInOctets))
+    return(NULL);
+  Matrix=(ShiftRegisterMatrix *)calloc(1, sizeof(ShiftRegisterMatrix));
+  if(Matrix==NULL)
+    return(NULL);
+  Matrix->Pixels=(uint8_t *)calloc(Rows*ColumnOctets+Register->SizeInOctets*2, 1);
+  if(Matrix->Pixels==NULL)
+  {
+    free(Matrix);
+    return(NULL);
+  }
+  Matrix->Frame=Matrix->Pixels+Rows*ColumnOctets;
+  Matrix->BlankFrame=Matrix->Frame+Register->SizeInOctets;
+  Matrix->Register=Register;
+  Matrix->Rows=Rows;
+  Matrix->Columns=Columns;
+  Matrix->ColumnOctets=ColumnOctets;
+  Matrix->EnableGPIO=EnableGPIO;
+  Matrix->Blank=true;
+  Matrix->BlankNS=SHIFTREGISTER_MATRIX_BLANK_NS;
+  if(EnableGPIO!=SHIFTREGISTER_MATRIX_NOPIN)
+  {
+    gpio_init(EnableGPIO);
+    gpio_set_dir(EnableGPIO, GPIO_OUT);
+    gpio_put(EnableGPIO, 0);
+  }
+  return(Matrix);
+}
+
+
+// Stop scanning and release the driver.
+void ShiftRegisterMatrixDestroy(ShiftRegisterMatrix *Matrix)
+{
+  ShiftRegisterMatrixStop(Matrix);
+  free(Matrix->Pixels);
+  free(Matrix);
+}
+
+#endif
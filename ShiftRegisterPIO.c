@@ -0,0 +1,203 @@
+/*
+
+  PIO backend for the ShiftRegister library. Instead of bit-banging the clock and data lines from the CPU, a PIO state machine
+  clocks the bits in and out and handles the latch. The CPU only pushes the octets into the TX FIFO and collects the result from
+  the RX FIFO, so the chain can be clocked at MHz rates without spending CPU time per bit.
+
+  To use it, define SHIFTREGISTER_ENABLE_PIO before including ShiftRegister.c (and link hardware_pio) and call
+  ShiftRegisterEnablePIO() after ShiftRegisterCreate(). ShiftRegisterUpdate() and ShiftRegisterFill() then use the state machine;
+  it is a transport that performs complete transfers, so ShiftRegisterWrite(), ShiftRegisterRead() and ShiftRegisterReadWrite()
+  perform the transfer for the type of the register.
+
+  The program is generated at runtime for the type of register (input, output or hybrid). Every transfer is started by pushing
+  the number of bits minus 1, followed by one word per octet (octet in bits 31..24, MSB first) for output and hybrid registers.
+  The state machine pushes one word per octet read (octet in bits 7..0) for input and hybrid registers, and always finishes the
+  transfer by pushing a completion token (0) after the latch line went low. Each bit takes 4 PIO cycles: 2 with the clock low and
+  2 with the clock high.
+
+  Pin mapping:
+  - ClockGPIO:    side-set pin
+  - DataOutGPIO:  OUT pin (output and hybrid only)
+  - DataInGPIO:   IN pin (input and hybrid only)
+  - LatchGPIO:    SET pin
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterPIO
+#define MyHardwareShiftRegisterPIO
+
+#include "hardware/pio.h"
+#include "hardware/pio_instructions.h"
+#include "hardware/clocks.h"
+
+
+#define SHIFTREGISTER_PIO_CYCLESPERBIT     4    // PIO cycles per bit; 2 clock low, 2 clock high.
+#define SHIFTREGISTER_PIO_MAXPROGRAMLENGTH 11   // Longest generated program (hybrid).
+#define SHIFTREGISTER_PIO_SIDESET(Value)   pio_encode_sideset(1, Value)
+
+
+// Generate the PIO program for the type of register. Returns the number of instructions.
+uint8_t ShiftRegisterPIOBuildProgram(ShiftRegister *Register, uint16_t *Program)
+{
+  uint8_t Length=0, Loop;
+
+  // Get the number of bits (minus 1) into the X (and Y) scratch register.
+  Program[Length++]=pio_encode_pull(false, true) | SHIFTREGISTER_PIO_SIDESET(0);
+  Program[Length++]=pio_encode_mov(pio_x, pio_osr) | SHIFTREGISTER_PIO_SIDESET(0);
+  if(Register->Type==SHIFTREGISTER_HYBRID)
+    Program[Length++]=pio_encode_mov(pio_y, pio_osr) | SHIFTREGISTER_PIO_SIDESET(0);
+
+  if(Register->Type!=SHIFTREGISTER_INPUT)
+  {
+    // Discard the bit count from the OSR so the next OUT autopulls the first octet.
+    Program[Length++]=pio_encode_out(pio_null, 32) | SHIFTREGISTER_PIO_SIDESET(0);
+
+    // Write the bits, starting with MSB. The register samples the data on the rising edge of the clock.
+    Loop=Length;
+    Program[Length++]=pio_encode_out(pio_pins, 1) | SHIFTREGISTER_PIO_SIDESET(0) | pio_encode_delay(1);
+    Program[Length++]=pio_encode_jmp_x_dec(Loop) | SHIFTREGISTER_PIO_SIDESET(1) | pio_encode_delay(1);
+  }
+
+  // Set the latch to high; this updates the outputs and enables reading from the incoming shift register.
+  Program[Length++]=pio_encode_set(pio_pins, 1) | SHIFTREGISTER_PIO_SIDESET(0) | pio_encode_delay(1);
+
+  if(Register->Type!=SHIFTREGISTER_OUTPUT)
+  {
+    // Read the bits, starting with MSB. Every 8 bits are autopushed to the RX FIFO.
+    Loop=Length;
+    Program[Length++]=pio_encode_in(pio_pins, 1) | SHIFTREGISTER_PIO_SIDESET(0) | pio_encode_delay(1);
+    Program[Length++]=pio_encode_jmp_x_dec(Loop) | SHIFTREGISTER_PIO_SIDESET(1) | pio_encode_delay(1);
+    if(Register->Type==SHIFTREGISTER_HYBRID)
+      Program[Length-1]=pio_encode_jmp_y_dec(Loop) | SHIFTREGISTER_PIO_SIDESET(1) | pio_encode_delay(1);
+  }
+
+  // All read and written; set the latch to low and signal completion.
+  Program[Length++]=pio_encode_set(pio_pins, 0) | SHIFTREGISTER_PIO_SIDESET(0);
+  Program[Length++]=pio_encode_push(false, true) | SHIFTREGISTER_PIO_SIDESET(0);
+  return(Length);
+}
+
+
+// Perform a transfer using the state machine. When Fill is true all octets written are FillOctet and the input is discarded.
+void ShiftRegisterPIOShift(ShiftRegister *Register, bool Fill, uint8_t FillOctet)
+{
+  PIO PIOInstance=Register->PIOInstance;
+  uint StateMachine=Register->PIOStateMachine;
+  uint8_t Octet;
+
+  // Start the transfer by pushing the number of bits, followed by the octets to write.
+  pio_sm_put_blocking(PIOInstance, StateMachine, (Register->SizeInOctets*8u)-1);
+  if(Register->Type!=SHIFTREGISTER_INPUT)
+    for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+    {
+      if(Fill)
+        Octet=FillOctet;
+      else
+      {
+        Octet=ShiftRegisterGetOutputOctet(Register, counter);
+        if(Register->InvertOutput)  // Do we need to invert the output?
+          Octet=~Octet;
+      }
+      pio_sm_put_blocking(PIOInstance, StateMachine, ((uint32_t)Octet)<<24);
+    }
+
+  // Collect the octets read, starting with MSB.
+  if(Register->Type!=SHIFTREGISTER_OUTPUT)
+    for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+    {
+      Octet=(uint8_t)pio_sm_get_blocking(PIOInstance, StateMachine);
+      if(!Fill)
+        ShiftRegisterSetInputOctet(Register, counter, Octet);
+    }
+
+  // Wait for the completion token; the latch is low again after this.
+  pio_sm_get_blocking(PIOInstance, StateMachine);
+}
+
+
+// The state machine performs complete transfers.
+const ShiftRegisterTransport ShiftRegisterPIOTransport={NULL, NULL, NULL, ShiftRegisterPIOShift};
+
+
+// Hand the register over to a state machine on the specified PIO block, clocking the bits at BitRateHz. Returns false if no
+// state machine or instruction memory is available; the register then keeps using the GPIO backend.
+bool ShiftRegisterEnablePIO(ShiftRegister *Register, PIO PIOInstance, uint32_t BitRateHz)
+{
+  uint16_t Instructions[SHIFTREGISTER_PIO_MAXPROGRAMLENGTH];
+  pio_program_t Program={.instructions=Instructions, .length=0, .origin=-1};
+  pio_sm_config Config;
+  uint32_t PinMask;
+  float Divider;
+  int StateMachine;
+
+  // Check if a state machine and enough instruction memory are available.
+  Program.length=ShiftRegisterPIOBuildProgram(Register, Instructions);
+  if((BitRateHz==0) || (!pio_can_add_program(PIOInstance, &Program)))
+    return(false);
+  StateMachine=pio_claim_unused_sm(PIOInstance, false);
+  if(StateMachine<0)
+    return(false);
+  Register->PIOInstance=PIOInstance;
+  Register->PIOStateMachine=(uint8_t)StateMachine;
+  Register->PIOProgramOffset=(uint8_t)pio_add_program(PIOInstance, &Program);
+  Register->PIOProgramLength=Program.length;
+
+  // Configure the pins; clock is side-set, latch is set and the data lines are out and in.
+  Config=pio_get_default_sm_config();
+  sm_config_set_wrap(&Config, Register->PIOProgramOffset, Register->PIOProgramOffset+Program.length-1);
+  sm_config_set_sideset(&Config, 1, false, false);
+  sm_config_set_sideset_pins(&Config, Register->ClockGPIO);
+  sm_config_set_set_pins(&Config, Register->LatchGPIO, 1);
+  PinMask=(1u << Register->ClockGPIO) | (1u << Register->LatchGPIO);
+  pio_gpio_init(PIOInstance, Register->ClockGPIO);
+  pio_gpio_init(PIOInstance, Register->LatchGPIO);
+  if(Register->Type!=SHIFTREGISTER_INPUT)
+  {
+    sm_config_set_out_pins(&Config, Register->DataOutGPIO, 1);
+    sm_config_set_out_shift(&Config, false, true, 8);  // Shift left (MSB first), autopull every octet.
+    PinMask|=(1u << Register->DataOutGPIO);
+    pio_gpio_init(PIOInstance, Register->DataOutGPIO);
+  }
+  if(Register->Type!=SHIFTREGISTER_OUTPUT)
+  {
+    sm_config_set_in_pins(&Config, Register->DataInGPIO);
+    sm_config_set_in_shift(&Config, false, true, 8);   // Shift left (MSB first), autopush every octet.
+  }
+
+  // Set the speed; every bit takes SHIFTREGISTER_PIO_CYCLESPERBIT cycles.
+  Divider=(float)clock_get_hz(clk_sys)/((float)BitRateHz*SHIFTREGISTER_PIO_CYCLESPERBIT);
+  sm_config_set_clkdiv(&Config, (Divider<1.0f?1.0f:Divider));
+
+  // Start with all outputs low and start the state machine; it waits for the first transfer.
+  pio_sm_set_pins_with_mask(PIOInstance, StateMachine, 0, PinMask);
+  pio_sm_set_pindirs_with_mask(PIOInstance, StateMachine, PinMask, PinMask);
+  pio_sm_init(PIOInstance, StateMachine, Register->PIOProgramOffset, &Config);
+  pio_sm_set_enabled(PIOInstance, StateMachine, true);
+  Register->Backend=SHIFTREGISTER_BACKEND_PIO;
+  return(true);
+}
+
+
+// Stop the state machine, free its resources and return the pins to the GPIO backend.
+void ShiftRegisterDisablePIO(ShiftRegister *Register)
+{
+  uint16_t Instructions[SHIFTREGISTER_PIO_MAXPROGRAMLENGTH];
+  pio_program_t Program={.instructions=Instructions, .length=Register->PIOProgramLength, .origin=-1};
+
+  if(Register->Backend!=SHIFTREGISTER_BACKEND_PIO)
+    return;
+  pio_sm_set_enabled(Register->PIOInstance, Register->PIOStateMachine, false);
+  pio_remove_program(Register->PIOInstance, &Program, Register->PIOProgramOffset);
+  pio_sm_unclaim(Register->PIOInstance, Register->PIOStateMachine);
+  gpio_set_function(Register->ClockGPIO, GPIO_FUNC_SIO);
+  gpio_set_function(Register->LatchGPIO, GPIO_FUNC_SIO);
+  if(Register->Type!=SHIFTREGISTER_INPUT)
+    gpio_set_function(Register->DataOutGPIO, GPIO_FUNC_SIO);
+  Register->Backend=SHIFTREGISTER_BACKEND_GPIO;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+
+  SPI backend for the ShiftRegister library. SIPO (74HC595) and PISO (74HC165) chains are SPI-compatible: the clock line
+  is SCK, the data line of the SIPO registers is TX (MOSI) and the data line of the PISO registers is RX (MISO). With the
+  SPI backend the octets are shifted by one of the SPI peripherals of the RP2040 while the library handles the latch line
+  around the transfer, exactly as with the GPIO backend.
+
+  To use it, define SHIFTREGISTER_ENABLE_SPI before including ShiftRegister.c (and link hardware_spi) and call
+  ShiftRegisterEnableSPI() after creating the register. ShiftRegisterWrite(), ShiftRegisterRead(), ShiftRegisterReadWrite(),
+  ShiftRegisterUpdate() and ShiftRegisterFill() then use the SPI peripheral; the struct and buffers are used as before.
+
+  The pins must be on the SPI function of the same peripheral (check the GPIO function table of the RP2040):
+  - ClockGPIO:    SCK (GPIO 2, 6, 10, 14, 18, 22, 26)
+  - DataOutGPIO:  TX  (GPIO 3, 7, 11, 15, 19, 23, 27; output and hybrid only)
+  - DataInGPIO:   RX  (GPIO 0, 4, 8, 12, 16, 20, 24, 28; input and hybrid only)
+  - LatchGPIO:    any GPIO port; stays under control of the library.
+
+  The SPI peripheral is used in mode 0 (clock idles low, data sampled on the rising edge), MSB first, matching the timing of
+  the GPIO backend. ClockDelayUS/ClockDelayNS are not used; the bit rate is set by ShiftRegisterEnableSPI().
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterSPI
+#define MyHardwareShiftRegisterSPI
+
+#include "hardware/spi.h"
+
+
+#define SHIFTREGISTER_SPI_RX               0    // Function of a GPIO port on its SPI peripheral (GPIO number modulo 4).
+#define SHIFTREGISTER_SPI_SCK              2
+#define SHIFTREGISTER_SPI_TX               3
+
+
+// Return the SPI peripheral of a GPIO port if the port has the requested SPI function, or NULL.
+spi_inst_t *ShiftRegisterSPIInstance(uint8_t GPIO, uint8_t Function)
+{
+  if((GPIO>29) || ((GPIO & 3)!=Function))
+    return(NULL);
+  return(((GPIO>>3) & 1)==0?spi0:spi1);
+}
+
+
+// Write the lowest Bits bits (a multiple of 8) of Value through the SPI peripheral, starting with MSB.
+void ShiftRegisterSPIShiftOut(ShiftRegister *Register, uint32_t Value, uint8_t Bits)
+{
+  uint8_t Octets[4], Length=Bits/8;
+
+  for(uint8_t counter=Length; counter>0; counter--)
+  {
+    Octets[counter-1]=(uint8_t)Value;
+    Value>>=8;
+  }
+  spi_write_blocking(Register->SPIInstance, Octets, Length);
+}
+
+
+// Read Bits bits (a multiple of 8) through the SPI peripheral, starting with MSB.
+uint32_t ShiftRegisterSPIShiftIn(ShiftRegister *Register, uint8_t Bits)
+{
+  uint8_t Octets[4], Length=Bits/8;
+  uint32_t Value=0;
+
+  spi_read_blocking(Register->SPIInstance, 0, Octets, Length);
+  for(uint8_t counter=0; counter<Length; counter++)
+    Value=(Value<<8) | Octets[counter];
+  return(Value);
+}
+
+
+// The SPI peripheral shifts the bits; the latch line is a GPIO port.
+const ShiftRegisterTransport ShiftRegisterSPITransport={ShiftRegisterSPIShiftOut, ShiftRegisterSPIShiftIn, ShiftRegisterGPIOLatch, NULL};
+
+
+// Hand the clock and data lines of the register over to the matching SPI peripheral, running at BitRateHz. Returns false if
+// the pins are not on the SPI function of the same peripheral; the register then keeps using its current backend.
+bool ShiftRegisterEnableSPI(ShiftRegister *Register, uint32_t BitRateHz)
+{
+  spi_inst_t *SPIInstance=ShiftRegisterSPIInstance(Register->ClockGPIO, SHIFTREGISTER_SPI_SCK);
+
+  // Check the pin mapping.
+  if((SPIInstance==NULL) || (BitRateHz==0))
+    return(false);
+  if((Register->Type!=SHIFTREGISTER_INPUT) && (ShiftRegisterSPIInstance(Register->DataOutGPIO, SHIFTREGISTER_SPI_TX)!=SPIInstance))
+    return(false);
+  if((Register->Type!=SHIFTREGISTER_OUTPUT) && (ShiftRegisterSPIInstance(Register->DataInGPIO, SHIFTREGISTER_SPI_RX)!=SPIInstance))
+    return(false);
+
+  // Mode 0, MSB first; the same timing as the GPIO backend.
+  spi_init(SPIInstance, BitRateHz);
+  spi_set_format(SPIInstance, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+  gpio_set_function(Register->ClockGPIO, GPIO_FUNC_SPI);
+  if(Register->Type!=SHIFTREGISTER_INPUT)
+    gpio_set_function(Register->DataOutGPIO, GPIO_FUNC_SPI);
+  if(Register->Type!=SHIFTREGISTER_OUTPUT)
+    gpio_set_function(Register->DataInGPIO, GPIO_FUNC_SPI);
+  Register->SPIInstance=SPIInstance;
+  Register->Backend=SHIFTREGISTER_BACKEND_SPI;
+  return(true);
+}
+
+
+// Release the SPI peripheral and return the pins to the GPIO backend.
+void ShiftRegisterDisableSPI(ShiftRegister *Register)
+{
+  if(Register->Backend!=SHIFTREGISTER_BACKEND_SPI)
+    return;
+  spi_deinit(Register->SPIInstance);
+  gpio_set_function(Register->ClockGPIO, GPIO_FUNC_SIO);
+  if(Register->Type!=SHIFTREGISTER_INPUT)
+    gpio_set_function(Register->DataOutGPIO, GPIO_FUNC_SIO);
+  if(Register->Type!=SHIFTREGISTER_OUTPUT)
+    gpio_set_function(Register->DataInGPIO, GPIO_FUNC_SIO);
+  Register->Backend=SHIFTREGISTER_BACKEND_GPIO;
+}
+
+#endif
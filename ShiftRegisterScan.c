@@ -0,0 +1,242 @@
+/*
+
+  Input change detection for the ShiftRegister library. Instead of polling PISO (74HC165) chains with ShiftRegisterRead() in
+  the main loop, a repeating timer interrupt reads the chains registered with ShiftRegisterScanAdd() every PeriodUS
+  microseconds and compares the input with the previous scan. Only inputs that changed are passed to the application, as
+  events (register, pin, new level, time of the scan) in a lock-free queue. The application takes them with
+  ShiftRegisterScanPoll(), which never blocks.
+
+  The queue is a single-producer/single-consumer ring: the timer interrupt is the only producer and the application (on
+  either core) the only consumer. When the queue is full, new events are dropped and counted in Dropped; the input buffer of
+  the register always has the latest levels. The comparison is done a word at a time, so a scan without changes costs the
+  read of the chain and one comparison per 4 octets.
+
+  Pin n is bit (0x80 >> (n % 8)) of octet n / 8 of the chain, as in the octet layout of the register (octet 0 is shifted in
+  first); for chains upto MAX_SIZEINOCTETS this is bit (SizeInOctets*8-1-n) of InputBuffer. While scanning, only the
+  interrupt reads the registers; do not call ShiftRegisterRead() etc. on them. ShiftRegisterScanStep() performs a single scan
+  and can also be driven by another timer source.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterScan
+#define MyHardwareShiftRegisterScan
+
+#include "ShiftRegister.c"
+#include "hardware/sync.h"
+
+
+#define SHIFTREGISTER_SCAN_QUEUESIZE       64   // Size of the event queue; must be a power of 2.
+#define SHIFTREGISTER_SCAN_MAXREGISTERS    8
+
+
+typedef struct
+{
+  ShiftRegister *Register;
+  uint16_t Pin;
+  bool Level;
+  uint64_t TimeUS;  // Time of the scan that detected the change.
+} ShiftRegisterScanEvent;
+
+typedef struct
+{
+  // Registers scanned and the input of the previous scan of each (SizeInOctets octets).
+  ShiftRegister *Registers[SHIFTREGISTER_SCAN_MAXREGISTERS];
+  uint8_t *Previous[SHIFTREGISTER_SCAN_MAXREGISTERS];
+  uint8_t RegisterCount;
+
+  // Event queue; Head is written by the interrupt, Tail by the application.
+  ShiftRegisterScanEvent Events[SHIFTREGISTER_SCAN_QUEUESIZE];
+  volatile uint32_t Head, Tail, Dropped;
+
+  uint32_t PeriodUS;
+  repeating_timer_t Timer;
+  bool Running;
+} ShiftRegisterScan;
+
+
+// Queue an event; dropped when the queue is full.
+void ShiftRegisterScanPost(ShiftRegisterScan *Scan, ShiftRegister *Register, uint16_t Pin, bool Level, uint64_t TimeUS)
+{
+  ShiftRegisterScanEvent *Event;
+  uint32_t Head=Scan->Head;
+
+  if((Head-Scan->Tail)>=SHIFTREGISTER_SCAN_QUEUESIZE)
+  {
+    Scan->Dropped++;
+    return;
+  }
+  Event=&Scan->Events[Head & (SHIFTREGISTER_SCAN_QUEUESIZE-1)];
+  Event->Register=Register;
+  Event->Pin=Pin;
+  Event->Level=Level;
+  Event->TimeUS=TimeUS;
+  __dmb();  // Publish the event before the head.
+  Scan->Head=Head+1;
+}
+
+
+// Post an event for every bit set in Changed; Value holds the new levels and FirstPin is the pin of the highest bit of the
+// Bits bits.
+void ShiftRegisterScanPostChanges(ShiftRegisterScan *Scan, ShiftRegister *Register, uint32_t Changed, uint32_t Value, uint16_t FirstPin,
+                                  uint8_t Bits, uint64_t TimeUS)
+{
+  uint8_t Bit;
+
+  while(Changed>0)
+  {
+    Bit=31-__builtin_clz(Changed);
+    ShiftRegisterScanPost(Scan, Register, FirstPin+(Bits-1-Bit), ((Value>>Bit) & 1)>0, TimeUS);
+    Changed&=~(1u << Bit);
+  }
+}
+
+
+// Read the register and post the changes since the previous scan.
+void ShiftRegisterScanRegister(ShiftRegisterScan *Scan, uint8_t Number, uint64_t TimeUS)
+{
+  ShiftRegister *Register=Scan->Registers[Number];
+  uint8_t *Previous=Scan->Previous[Number];
+  uint32_t Value, Old;
+  uint16_t Octets;
+
+  ShiftRegisterRead(Register);
+  if(Register->SizeInOctets<=MAX_SIZEINOCTETS)
+  {
+    memcpy(&Old, Previous, sizeof(uint32_t));
+    if(Register->InputBuffer!=Old)
+    {
+      ShiftRegisterScanPostChanges(Scan, Register, Register->InputBuffer ^ Old, Register->InputBuffer, 0, Register->SizeInOctets*8, TimeUS);
+      memcpy(Previous, &Register->InputBuffer, sizeof(uint32_t));
+    }
+    return;
+  }
+
+  // Long chains; compare upto 4 octets at a time.
+  for(uint16_t Index=0; Index<Register->SizeInOctets; Index+=Octets)
+  {
+    Octets=Register->SizeInOctets-Index;
+    if(Octets>MAX_SIZEINOCTETS)
+      Octets=MAX_SIZEINOCTETS;
+    if(memcmp(&Register->InputOctets[Index], &Previous[Index], Octets)==0)
+      continue;
+    Value=Old=0;
+    for(uint16_t counter=0; counter<Octets; counter++)
+    {
+      Value=(Value<<8) | Register->InputOctets[Index+counter];
+      Old=(Old<<8) | Previous[Index+counter];
+    }
+    ShiftRegisterScanPostChanges(Scan, Register, Value ^ Old, Value, Index*8, Octets*8, TimeUS);
+    memcpy(&Previous[Index], &Register->InputOctets[Index], Octets);
+  }
+}
+
+
+// Scan all registers once.
+void ShiftRegisterScanStep(ShiftRegisterScan *Scan)
+{
+  uint64_t TimeUS=time_us_64();
+
+  for(uint8_t counter=0; counter<Scan->RegisterCount; counter++)
+    ShiftRegisterScanRegister(Scan, counter, TimeUS);
+}
+
+
+// Take the oldest event from the queue. Returns false if there are no events.
+bool ShiftRegisterScanPoll(ShiftRegisterScan *Scan, ShiftRegisterScanEvent *Event)
+{
+  uint32_t Tail=Scan->Tail;
+
+  if(Tail==Scan->Head)
+    return(false);
+  __dmb();  // Read the event only after seeing the head.
+  *Event=Scan->Events[Tail & (SHIFTREGISTER_SCAN_QUEUESIZE-1)];
+  __dmb();  // Free the slot after reading it.
+  Scan->Tail=Tail+1;
+  return(true);
+}
+
+
+// Add an input register to the scan; only before ShiftRegisterScanStart(). Returns false for other types of registers, if
+// the maximum number of registers is reached or no memory is available.
+bool ShiftRegisterScanAdd(ShiftRegisterScan *Scan, ShiftRegister *Register)
+{
+  uint8_t *Previous;
+
+  if(Scan->Running || (Register->Type!=SHIFTREGISTER_INPUT) || (Scan->RegisterCount>=SHIFTREGISTER_SCAN_MAXREGISTERS))
+    return(false);
+  Previous=(uint8_t *)calloc(Register->SizeInOctets>MAX_SIZEINOCTETS?Register->SizeInOctets:sizeof(uint32_t), 1);
+  if(Previous==NULL)
+    return(false);
+  Scan->Registers[Scan->RegisterCount]=Register;
+  Scan->Previous[Scan->RegisterCount]=Previous;
+  Scan->RegisterCount++;
+  return(true);
+}
+
+
+bool ShiftRegisterScanTimerCallback(repeating_timer_t *Timer)
+{
+  ShiftRegisterScanStep((ShiftRegisterScan *)Timer->user_data);
+  return(true);
+}
+
+
+// Start scanning. The first scan is done immediately and only records the levels; later scans post the changes. Returns
+// false if already running or no timer is available.
+bool ShiftRegisterScanStart(ShiftRegisterScan *Scan)
+{
+  ShiftRegister *Register;
+
+  if(Scan->Running)
+    return(false);
+  for(uint8_t counter=0; counter<Scan->RegisterCount; counter++)
+  {
+    Register=Scan->Registers[counter];
+    ShiftRegisterRead(Register);
+    if(Register->SizeInOctets<=MAX_SIZEINOCTETS)
+      memcpy(Scan->Previous[counter], &Register->InputBuffer, sizeof(uint32_t));
+    else
+      memcpy(Scan->Previous[counter], Register->InputOctets, Register->SizeInOctets);
+  }
+  if(!add_repeating_timer_us(-(int64_t)Scan->PeriodUS, ShiftRegisterScanTimerCallback, Scan, &Scan->Timer))
+    return(false);
+  Scan->Running=true;
+  return(true);
+}
+
+
+void ShiftRegisterScanStop(ShiftRegisterScan *Scan)
+{
+  if(!Scan->Running)
+    return;
+  cancel_repeating_timer(&Scan->Timer);
+  Scan->Running=false;
+}
+
+
+// Create a scan running every PeriodUS microseconds (minimum 1). Returns NULL if no memory is available.
+ShiftRegisterScan *ShiftRegisterScanCreate(uint32_t PeriodUS)
+{
+  ShiftRegisterScan *Scan=(ShiftRegisterScan *)calloc(1, sizeof(ShiftRegisterScan));
+
+  if(Scan==NULL)
+    return(NULL);
+  Scan->PeriodUS=(PeriodUS>0?PeriodUS:1);
+  return(Scan);
+}
+
+
+// Stop scanning and release the scan; the registers are not destroyed.
+void ShiftRegisterScanDestroy(ShiftRegisterScan *Scan)
+{
+  ShiftRegisterScanStop(Scan);
+  for(uint8_t counter=0; counter<Scan->RegisterCount; counter++)
+    free(Scan->Previous[counter]);
+  free(Scan);
+}
+
+#endif
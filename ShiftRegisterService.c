@@ -0,0 +1,220 @@
+/*
+
+  Shift register service running on core1 of the RP2040, using the ShiftRegister library. All shift register traffic is
+  handled by a worker on core1, so core0 is free for the application logic.
+
+  Core0 submits requests (update, write a value, fill) for registers registered with the service. Requests and results are
+  passed through two lock-free single-producer/single-consumer rings in shared memory: core0 is the only producer of
+  requests and consumer of results, core1 the only producer of results and consumer of requests. Core1 sleeps (WFE) while
+  there is nothing to do and is woken by SEV after a request is submitted.
+
+  Requests are handled in the order submitted and results are returned in the same order. Results are fetched with
+  ShiftRegisterServicePoll(), which never blocks. The Ticket of a request is returned with its result, so the application can
+  match them. For chains upto MAX_SIZEINOCTETS the input read is returned in the result; for longer chains it is in
+  InputOctets of the register, which core0 should only read after receiving the result.
+
+  While the service runs, registers registered with it must only be accessed through the service. To change the output of
+  long chains, use double buffering (ShiftRegisterCommitFrame()) and submit an update.
+
+  Link pico_multicore when using this file.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterService
+#define MyHardwareShiftRegisterService
+
+#include "ShiftRegister.c"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+
+
+#define SHIFTREGISTER_SERVICE_QUEUESIZE    16   // Size of the request and result rings; must be a power of 2.
+#define SHIFTREGISTER_SERVICE_MAXREGISTERS 8
+#define SHIFTREGISTER_SERVICE_UPDATE       0    // ShiftRegisterUpdate() with the current output.
+#define SHIFTREGISTER_SERVICE_WRITE        1    // Set OutputBuffer to Value, then ShiftRegisterUpdate().
+#define SHIFTREGISTER_SERVICE_FILL         2    // ShiftRegisterFill() with Value.
+
+
+typedef struct
+{
+  ShiftRegister *Register;
+  uint8_t Operation;
+  uint32_t Value, Ticket;
+} ShiftRegisterServiceRequest;
+
+typedef struct
+{
+  ShiftRegister *Register;
+  uint8_t Operation;
+  uint32_t InputBuffer, Ticket;
+} ShiftRegisterServiceResult;
+
+typedef struct
+{
+  ShiftRegisterServiceRequest Requests[SHIFTREGISTER_SERVICE_QUEUESIZE];
+  ShiftRegisterServiceResult Results[SHIFTREGISTER_SERVICE_QUEUESIZE];
+  volatile uint32_t RequestHead, RequestTail, ResultHead, ResultTail;  // Head written by the producer, tail by the consumer.
+
+  ShiftRegister *Registers[SHIFTREGISTER_SERVICE_MAXREGISTERS];
+  uint8_t RegisterCount;
+  volatile bool Running;
+} ShiftRegisterServiceState;
+
+
+static ShiftRegisterServiceState ShiftRegisterService;
+
+
+// Worker on core1; handle the requests in order and post the results.
+void ShiftRegisterServiceWorker(void)
+{
+  ShiftRegisterServiceRequest *Request;
+  ShiftRegisterServiceResult *Result;
+  uint32_t Tail;
+
+  while(true)
+  {
+    // Sleep until a request is available.
+    Tail=ShiftRegisterService.RequestTail;
+    if(Tail==ShiftRegisterService.RequestHead)
+    {
+      __wfe();
+      continue;
+    }
+    __dmb();  // Read the request only after seeing the head.
+    Request=&ShiftRegisterService.Requests[Tail & (SHIFTREGISTER_SERVICE_QUEUESIZE-1)];
+
+    switch(Request->Operation)
+    {
+      case SHIFTREGISTER_SERVICE_WRITE:  Request->Register->OutputBuffer=Request->Value;
+                                         ShiftRegisterUpdate(Request->Register);
+                                         break;
+      case SHIFTREGISTER_SERVICE_FILL:   ShiftRegisterFill(Request->Register, (uint8_t)Request->Value);
+                                         break;
+      default:                           ShiftRegisterUpdate(Request->Register);
+                                         break;
+    }
+
+    // Wait for room in the result ring; core0 signals when it takes a result.
+    while((ShiftRegisterService.ResultHead-ShiftRegisterService.ResultTail)>=SHIFTREGISTER_SERVICE_QUEUESIZE)
+      __wfe();
+    Result=&ShiftRegisterService.Results[ShiftRegisterService.ResultHead & (SHIFTREGISTER_SERVICE_QUEUESIZE-1)];
+    Result->Register=Request->Register;
+    Result->Operation=Request->Operation;
+    Result->InputBuffer=Request->Register->InputBuffer;
+    Result->Ticket=Request->Ticket;
+    __dmb();  // Publish the result and free the request slot.
+    ShiftRegisterService.ResultHead++;
+    ShiftRegisterService.RequestTail=Tail+1;
+    __sev();
+  }
+}
+
+
+// Register a shift register with the service. Returns false if the maximum number of registers is reached.
+bool ShiftRegisterServiceAdd(ShiftRegister *Register)
+{
+  if(ShiftRegisterService.RegisterCount>=SHIFTREGISTER_SERVICE_MAXREGISTERS)
+    return(false);
+  ShiftRegisterService.Registers[ShiftRegisterService.RegisterCount++]=Register;
+  return(true);
+}
+
+
+// Submit a request for a registered shift register. Returns false if the register is unknown, the service is not running or
+// the request ring is full.
+bool ShiftRegisterServiceSubmit(ShiftRegister *Register, uint8_t Operation, uint32_t Value, uint32_t Ticket)
+{
+  ShiftRegisterServiceRequest *Request;
+  uint32_t Head=ShiftRegisterService.RequestHead;
+  bool Registered=false;
+
+  for(uint8_t counter=0; counter<ShiftRegisterService.RegisterCount; counter++)
+    Registered|=(ShiftRegisterService.Registers[counter]==Register);
+  if((!Registered) || (!ShiftRegisterService.Running) || ((Head-ShiftRegisterService.RequestTail)>=SHIFTREGISTER_SERVICE_QUEUESIZE))
+    return(false);
+
+  Request=&ShiftRegisterService.Requests[Head & (SHIFTREGISTER_SERVICE_QUEUESIZE-1)];
+  Request->Register=Register;
+  Request->Operation=Operation;
+  Request->Value=Value;
+  Request->Ticket=Ticket;
+  __dmb();  // Publish the request before the head.
+  ShiftRegisterService.RequestHead=Head+1;
+  __sev();
+  return(true);
+}
+
+
+// Shorthands for the requests.
+bool ShiftRegisterServiceUpdate(ShiftRegister *Register, uint32_t Ticket)
+{
+  return(ShiftRegisterServiceSubmit(Register, SHIFTREGISTER_SERVICE_UPDATE, 0, Ticket));
+}
+
+
+bool ShiftRegisterServiceWrite(ShiftRegister *Register, uint32_t Value, uint32_t Ticket)
+{
+  return(ShiftRegisterServiceSubmit(Register, SHIFTREGISTER_SERVICE_WRITE, Value, Ticket));
+}
+
+
+bool ShiftRegisterServiceFill(ShiftRegister *Register, uint8_t FillValue, uint32_t Ticket)
+{
+  return(ShiftRegisterServiceSubmit(Register, SHIFTREGISTER_SERVICE_FILL, FillValue, Ticket));
+}
+
+
+// Fetch the next result, if available. Never blocks; returns false if there is no result.
+bool ShiftRegisterServicePoll(ShiftRegisterServiceResult *Result)
+{
+  uint32_t Tail=ShiftRegisterService.ResultTail;
+
+  if(Tail==ShiftRegisterService.ResultHead)
+    return(false);
+  __dmb();  // Read the result only after seeing the head.
+  *Result=ShiftRegisterService.Results[Tail & (SHIFTREGISTER_SERVICE_QUEUESIZE-1)];
+  __dmb();
+  ShiftRegisterService.ResultTail=Tail+1;
+  __sev();  // Wake the worker if it waits for room in the result ring.
+  return(true);
+}
+
+
+// Number of requests submitted but not yet handled by the worker.
+uint32_t ShiftRegisterServicePending(void)
+{
+  return(ShiftRegisterService.RequestHead-ShiftRegisterService.RequestTail);
+}
+
+
+// Start the worker on core1. Core1 must not be in use by the application.
+void ShiftRegisterServiceStart(void)
+{
+  if(ShiftRegisterService.Running)
+    return;
+  ShiftRegisterService.RequestHead=ShiftRegisterService.RequestTail=0;
+  ShiftRegisterService.ResultHead=ShiftRegisterService.ResultTail=0;
+  ShiftRegisterService.Running=true;
+  multicore_launch_core1(ShiftRegisterServiceWorker);
+}
+
+
+// Stop the worker after all submitted requests have been handled. Results not yet polled are discarded.
+void ShiftRegisterServiceStop(void)
+{
+  if(!ShiftRegisterService.Running)
+    return;
+  ShiftRegisterService.Running=false;
+  while(ShiftRegisterServicePending()>0)
+  {
+    ShiftRegisterService.ResultTail=ShiftRegisterService.ResultHead;  // Make room for the remaining results.
+    __sev();
+  }
+  multicore_reset_core1();
+}
+
+#endif
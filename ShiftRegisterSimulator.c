@@ -0,0 +1,149 @@
+/*
+
+  Simulator transport for the ShiftRegister library. Instead of driving GPIO ports, the transport clocks the bits straight
+  into cascaded 74HC595 (SIPO) and 74HC165 (PISO) chips, without ports and without time. This allows the protocol (Write,
+  Read, ReadWrite, Fill, double buffering, skipping unchanged writes etc.) to be tested and transports to be compared by the
+  number of clock and latch pulses.
+
+  The chips are the chains of the host simulator (ShiftRegisterHostSimulator.c), so the transport runs on Linux only and
+  behaves exactly like the chips on the simulated ports; the chains are just not connected to any port. Build with the stub
+  headers in front of the include path (cc -Ihost -pthread); this file includes the simulator and the library.
+
+  Create the model with ShiftRegisterSimulatorCreate() and attach it to a register with
+  ShiftRegisterSetTransport(Register, &ShiftRegisterSimulatorTransport, Simulator). As with the chips:
+  - Every clock pulse shifts the SIPO chain one bit (the data line enters at the chip nearest to the controller) and, while
+    the latch line is high, the PISO chain one bit (the data line reads the chip nearest to the controller).
+  - While the latch line is low the PISO chain loads Inputs; the rising edge of the latch line freezes them in the shift
+    stages and copies the SIPO shift stages to Outputs.
+  Both Outputs and Inputs use the layout of the register buffers; octet 0 is the first octet shifted out/in. The PISO chain
+  can read the SIPO outputs with ShiftRegisterHostLoopback(&Simulator->PISO, &Simulator->SIPO).
+
+  Clocks and Latches count the clock pulses and latch pulses, so the cost of an operation can be compared.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterSimulator
+#define MyHardwareShiftRegisterSimulator
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+
+
+typedef struct
+{
+  // The SIPO and PISO chains; a chain of 0 octets is not set up.
+  ShiftRegisterHostChain SIPO, PISO;
+
+  // Parallel outputs of the SIPO chips and parallel inputs of the PISO chips, as the application sees them.
+  uint8_t *Outputs, *Inputs;
+
+  // State of the latch line.
+  bool LatchHigh;
+
+  // Statistics.
+  uint32_t Clocks, Latches;
+} ShiftRegisterSimulator;
+
+
+// Rising edge of the clock; shift both chains one bit.
+void ShiftRegisterSimulatorClock(ShiftRegisterSimulator *Simulator, bool DataOut)
+{
+  if(Simulator->SIPO.SizeInOctets>0)
+    ShiftRegisterHostShift(&Simulator->SIPO, DataOut);
+  if((Simulator->PISO.SizeInOctets>0) && Simulator->LatchHigh)
+    ShiftRegisterHost165Clock(&Simulator->PISO);
+  Simulator->Clocks++;
+}
+
+
+// Level of the data line read by the controller; the serial output of the PISO chain.
+bool ShiftRegisterSimulatorDataIn(ShiftRegisterSimulator *Simulator)
+{
+  if(Simulator->PISO.SizeInOctets==0)
+    return(false);
+  if(!Simulator->LatchHigh)
+    ShiftRegisterHostLoad(&Simulator->PISO);
+  return(ShiftRegisterHostSerialOut(&Simulator->PISO));
+}
+
+
+void ShiftRegisterSimulatorShiftOut(ShiftRegister *Register, uint32_t Value, uint8_t Bits)
+{
+  ShiftRegisterSimulator *Simulator=(ShiftRegisterSimulator *)Register->TransportData;
+
+  for(uint32_t WriteMask=(1u << (Bits-1)); WriteMask>0; WriteMask>>=1)
+    ShiftRegisterSimulatorClock(Simulator, (WriteMask & Value)>0);
+}
+
+
+uint32_t ShiftRegisterSimulatorShiftIn(ShiftRegister *Register, uint8_t Bits)
+{
+  ShiftRegisterSimulator *Simulator=(ShiftRegisterSimulator *)Register->TransportData;
+  uint32_t Value=0;
+
+  for(uint8_t counter=0; counter<Bits; counter++)
+  {
+    Value=(Value<<1) | (ShiftRegisterSimulatorDataIn(Simulator)?1:0);
+    ShiftRegisterSimulatorClock(Simulator, false);
+  }
+  return(Value);
+}
+
+
+void ShiftRegisterSimulatorLatch(ShiftRegister *Register, bool High)
+{
+  ShiftRegisterSimulator *Simulator=(ShiftRegisterSimulator *)Register->TransportData;
+
+  // The PISO chips load their inputs on every change; on the rising edge they do so before the new outputs of the SIPO
+  // chips appear.
+  if(High==Simulator->LatchHigh)
+    return;
+  if(Simulator->PISO.SizeInOctets>0)
+    ShiftRegisterHostLoad(&Simulator->PISO);
+  if(High)
+  {
+    if(Simulator->SIPO.SizeInOctets>0)
+      ShiftRegisterHost595Latch(&Simulator->SIPO);
+    Simulator->Latches++;
+  }
+  Simulator->LatchHigh=High;
+}
+
+
+const ShiftRegisterTransport ShiftRegisterSimulatorTransport={ShiftRegisterSimulatorShiftOut, ShiftRegisterSimulatorShiftIn, ShiftRegisterSimulatorLatch, NULL};
+
+
+void ShiftRegisterSimulatorDestroy(ShiftRegisterSimulator *Simulator)
+{
+  free(Simulator->SIPO.Shift);
+  free(Simulator->PISO.Shift);
+  free(Simulator);
+}
+
+
+// Create the model of a chain with SIPOOctets SIPO chips and PISOOctets PISO chips; all outputs and inputs are 0. Returns
+// NULL if no memory is available.
+ShiftRegisterSimulator *ShiftRegisterSimulatorCreate(uint16_t SIPOOctets, uint16_t PISOOctets)
+{
+  ShiftRegisterSimulator *Simulator=(ShiftRegisterSimulator *)calloc(1, sizeof(ShiftRegisterSimulator));
+
+  if(Simulator==NULL)
+    return(NULL);
+  if(((SIPOOctets>0) && (!ShiftRegisterHostInitChain(&Simulator->SIPO, SHIFTREGISTER_HOST_595, SHIFTREGISTER_HOST_NOPIN,
+                                                     SHIFTREGISTER_HOST_NOPIN, SHIFTREGISTER_HOST_NOPIN, SHIFTREGISTER_HOST_NOPIN, SIPOOctets))) ||
+     ((PISOOctets>0) && (!ShiftRegisterHostInitChain(&Simulator->PISO, SHIFTREGISTER_HOST_165, SHIFTREGISTER_HOST_NOPIN,
+                                                     SHIFTREGISTER_HOST_NOPIN, SHIFTREGISTER_HOST_NOPIN, SHIFTREGISTER_HOST_NOPIN, PISOOctets))))
+  {
+    ShiftRegisterSimulatorDestroy(Simulator);
+    return(NULL);
+  }
+  Simulator->Outputs=Simulator->SIPO.Parallel;
+  Simulator->Inputs=Simulator->PISO.Parallel;
+  return(Simulator);
+}
+
+#endif
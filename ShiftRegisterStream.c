@@ -0,0 +1,274 @@
+/*
+
+  Continuous output streaming for SHIFTREGISTER_OUTPUT chains using the PIO backend and DMA. The application hands over a
+  ring of pre-formatted frames; at a fixed frame rate a DMA channel feeds the next frame into the TX FIFO of the state machine
+  and a second DMA channel collects the completion token, raising an interrupt that advances the ring and calls the (optional)
+  completion callback. The CPU only needs to touch the ring when a frame has to change.
+
+  Usage:
+  - Define SHIFTREGISTER_ENABLE_PIO, include this file and link hardware_pio, hardware_dma and hardware_irq.
+  - Create the register and enable the PIO backend with ShiftRegisterEnablePIO().
+  - Create the stream with ShiftRegisterStreamCreate(), fill the frames with ShiftRegisterStreamSetFrame() (or
+    ShiftRegisterStreamSetFrameOctets() for chains longer than 32 bits) and call
+    ShiftRegisterStreamStart().
+
+  Frames are paced by a repeating timer; the timer interrupt only re-arms the DMA channels. If a frame is still being shifted
+  when the next one is due, the frame is skipped and counted in Overruns. ShiftRegisterUpdate() and ShiftRegisterFill() must
+  not be used on the register while the stream is running.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterStream
+#define MyHardwareShiftRegisterStream
+
+#ifndef SHIFTREGISTER_ENABLE_PIO
+#define SHIFTREGISTER_ENABLE_PIO
+#endif
+
+#include "ShiftRegister.c"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+
+typedef struct ShiftRegisterStream ShiftRegisterStream;
+typedef void (*ShiftRegisterStreamCallback)(ShiftRegisterStream *Stream, uint16_t FrameIndex);
+
+struct ShiftRegisterStream
+{
+  // The register (using the PIO backend) the frames are streamed to.
+  ShiftRegister *Register;
+
+  // Ring of frames; every frame consists of WordsPerFrame words, formatted as expected by the PIO program.
+  uint32_t *Frames;
+  uint16_t FrameCount, WordsPerFrame;
+  volatile uint16_t CurrentFrame;
+
+  // DMA channels feeding the TX FIFO and collecting the completion token from the RX FIFO.
+  uint8_t TxChannel, RxChannel;
+  uint32_t CompletionToken;
+
+  // Pacing of the frames.
+  repeating_timer_t Timer;
+  volatile bool Running, Busy;
+  volatile uint32_t FramesSent, Overruns;
+
+  // Called from the DMA interrupt after a frame has been latched.
+  ShiftRegisterStreamCallback Callback;
+  void *UserData;
+};
+
+
+// Lookup of the stream by the DMA channel that raised the interrupt.
+static ShiftRegisterStream *ShiftRegisterStreams[NUM_DMA_CHANNELS];
+static uint8_t ShiftRegisterStreamsActive=0;
+
+
+// Format a frame in the ring with the specified octets (SizeInOctets octets, octet 0 is shifted first). Can be called while
+// the stream is running.
+void ShiftRegisterStreamSetFrameOctets(ShiftRegisterStream *Stream, uint16_t FrameIndex, const uint8_t *Octets)
+{
+  ShiftRegister *Register=Stream->Register;
+  uint32_t *Frame=&Stream->Frames[FrameIndex*Stream->WordsPerFrame];
+  uint8_t Octet;
+
+  // First the number of bits, followed by the octets (MSB first) in bits 31..24.
+  Frame[0]=(Register->SizeInOctets*8u)-1;
+  for(uint16_t counter=0; counter<Register->SizeInOctets; counter++)
+  {
+    Octet=Octets[counter];
+    if(Register->InvertOutput)  // Do we need to invert the output?
+      Octet=~Octet;
+    Frame[counter+1]=((uint32_t)Octet)<<24;
+  }
+}
+
+
+// Format a frame in the ring with the specified value, for chains upto MAX_SIZEINOCTETS.
+void ShiftRegisterStreamSetFrame(ShiftRegisterStream *Stream, uint16_t FrameIndex, uint32_t Value)
+{
+  uint8_t Octets[MAX_SIZEINOCTETS];
+  uint16_t SizeInOctets=Stream->Register->SizeInOctets;
+
+  for(uint16_t counter=0; counter<SizeInOctets; counter++)
+    Octets[counter]=(uint8_t)(Value>>((SizeInOctets-1-counter)*8));
+  ShiftRegisterStreamSetFrameOctets(Stream, FrameIndex, Octets);
+}
+
+
+// Direct access to the words of a frame, for applications that format the frames themselves.
+uint32_t *ShiftRegisterStreamFrame(ShiftRegisterStream *Stream, uint16_t FrameIndex)
+{
+  return(&Stream->Frames[FrameIndex*Stream->WordsPerFrame]);
+}
+
+
+// DMA interrupt; a frame has been shifted and latched. Advance the ring and call the callback.
+void ShiftRegisterStreamIRQHandler(void)
+{
+  ShiftRegisterStream *Stream;
+  uint16_t FrameIndex;
+
+  for(uint8_t Channel=0; Channel<NUM_DMA_CHANNELS; Channel++)
+  {
+    Stream=ShiftRegisterStreams[Channel];
+    if((Stream==NULL) || (!dma_channel_get_irq0_status(Channel)))
+      continue;
+    dma_channel_acknowledge_irq0(Channel);
+    FrameIndex=Stream->CurrentFrame;
+    Stream->CurrentFrame=(FrameIndex+1<Stream->FrameCount?FrameIndex+1:0);
+    Stream->FramesSent++;
+    Stream->Busy=false;
+    if(Stream->Callback!=NULL)
+      Stream->Callback(Stream, FrameIndex);
+  }
+}
+
+
+// Timer interrupt; start shifting the next frame unless the previous one is still busy.
+bool ShiftRegisterStreamTimerCallback(repeating_timer_t *Timer)
+{
+  ShiftRegisterStream *Stream=(ShiftRegisterStream *)Timer->user_data;
+
+  if(!Stream->Running)
+    return(false);
+  if(Stream->Busy)
+  {
+    Stream->Overruns++;
+    return(true);
+  }
+  Stream->Busy=true;
+  dma_channel_set_write_addr(Stream->RxChannel, &Stream->CompletionToken, true);
+  dma_channel_set_read_addr(Stream->TxChannel, &Stream->Frames[Stream->CurrentFrame*Stream->WordsPerFrame], true);
+  return(true);
+}
+
+
+// Create a stream of FrameCount frames for the register, updated at FrameRateHz. All frames are initialized with the current
+// output (OutputBuffer or OutputOctets). Returns NULL if the register is not an output register using the PIO backend, or no DMA channels or memory are
+// available.
+ShiftRegisterStream *ShiftRegisterStreamCreate(ShiftRegister *Register, uint16_t FrameCount, uint32_t FrameRateHz, ShiftRegisterStreamCallback Callback, void *UserData)
+{
+  ShiftRegisterStream *Stream;
+  dma_channel_config Config;
+  PIO PIOInstance=Register->PIOInstance;
+  uint StateMachine=Register->PIOStateMachine;
+  int TxChannel, RxChannel;
+
+  // Check if streaming is possible for this register.
+  if((Register->Type!=SHIFTREGISTER_OUTPUT) || (Register->Backend!=SHIFTREGISTER_BACKEND_PIO) || (FrameCount==0) || (FrameRateHz==0))
+    return(NULL);
+  TxChannel=dma_claim_unused_channel(false);
+  RxChannel=dma_claim_unused_channel(false);
+  if((TxChannel<0) || (RxChannel<0))
+  {
+    if(TxChannel>=0)
+      dma_channel_unclaim(TxChannel);
+    if(RxChannel>=0)
+      dma_channel_unclaim(RxChannel);
+    return(NULL);
+  }
+
+  // Create the struct and the ring of frames; without memory the channels are released again.
+  Stream=(ShiftRegisterStream *)malloc(sizeof(ShiftRegisterStream));
+  if(Stream!=NULL)
+  {
+    Stream->WordsPerFrame=Register->SizeInOctets+1;
+    Stream->Frames=(uint32_t *)malloc(FrameCount*Stream->WordsPerFrame*sizeof(uint32_t));
+  }
+  if((Stream==NULL) || (Stream->Frames==NULL))
+  {
+    free(Stream);
+    dma_channel_unclaim(TxChannel);
+    dma_channel_unclaim(RxChannel);
+    return(NULL);
+  }
+  Stream->Register=Register;
+  Stream->FrameCount=FrameCount;
+  Stream->CurrentFrame=0;
+  Stream->TxChannel=(uint8_t)TxChannel;
+  Stream->RxChannel=(uint8_t)RxChannel;
+  Stream->Timer.delay_us=-(int64_t)(1000000/FrameRateHz);  // Negative; the delay is between the starts of the frames.
+  Stream->Running=false;
+  Stream->Busy=false;
+  Stream->FramesSent=0;
+  Stream->Overruns=0;
+  Stream->Callback=Callback;
+  Stream->UserData=UserData;
+  for(uint16_t counter=0; counter<FrameCount; counter++)
+    if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+      ShiftRegisterStreamSetFrameOctets(Stream, counter, Register->OutputOctets);
+    else
+      ShiftRegisterStreamSetFrame(Stream, counter, Register->OutputBuffer);
+
+  // TX channel; copies a frame into the TX FIFO, paced by the state machine.
+  Config=dma_channel_get_default_config(TxChannel);
+  channel_config_set_transfer_data_size(&Config, DMA_SIZE_32);
+  channel_config_set_read_increment(&Config, true);
+  channel_config_set_write_increment(&Config, false);
+  channel_config_set_dreq(&Config, pio_get_dreq(PIOInstance, StateMachine, true));
+  dma_channel_configure(TxChannel, &Config, &PIOInstance->txf[StateMachine], Stream->Frames, Stream->WordsPerFrame, false);
+
+  // RX channel; collects the completion token after the latch and raises the interrupt.
+  Config=dma_channel_get_default_config(RxChannel);
+  channel_config_set_transfer_data_size(&Config, DMA_SIZE_32);
+  channel_config_set_read_increment(&Config, false);
+  channel_config_set_write_increment(&Config, false);
+  channel_config_set_dreq(&Config, pio_get_dreq(PIOInstance, StateMachine, false));
+  dma_channel_configure(RxChannel, &Config, &Stream->CompletionToken, &PIOInstance->rxf[StateMachine], 1, false);
+
+  ShiftRegisterStreams[RxChannel]=Stream;
+  dma_channel_set_irq0_enabled(RxChannel, true);
+  if(ShiftRegisterStreamsActive++==0)
+  {
+    irq_add_shared_handler(DMA_IRQ_0, ShiftRegisterStreamIRQHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+  }
+  return(Stream);
+}
+
+
+// Start streaming the frames, beginning with the current frame.
+bool ShiftRegisterStreamStart(ShiftRegisterStream *Stream)
+{
+  if(Stream->Running)
+    return(true);
+  Stream->Running=true;
+  if(!add_repeating_timer_us(Stream->Timer.delay_us, ShiftRegisterStreamTimerCallback, Stream, &Stream->Timer))
+    Stream->Running=false;
+  return(Stream->Running);
+}
+
+
+// Stop streaming; the frame being shifted is completed first. The frames were latched outside the SkipUnchanged shadow, so
+// the next write is always performed.
+void ShiftRegisterStreamStop(ShiftRegisterStream *Stream)
+{
+  if(!Stream->Running)
+    return;
+  Stream->Running=false;
+  cancel_repeating_timer(&Stream->Timer);
+  while(Stream->Busy)
+    tight_loop_contents();
+  Stream->Register->LastOutputValid=false;
+}
+
+
+// Stop the stream and release the DMA channels and memory.
+void ShiftRegisterStreamDestroy(ShiftRegisterStream *Stream)
+{
+  ShiftRegisterStreamStop(Stream);
+  dma_channel_set_irq0_enabled(Stream->RxChannel, false);
+  ShiftRegisterStreams[Stream->RxChannel]=NULL;
+  if(--ShiftRegisterStreamsActive==0)
+    irq_remove_handler(DMA_IRQ_0, ShiftRegisterStreamIRQHandler);
+  dma_channel_unclaim(Stream->TxChannel);
+  dma_channel_unclaim(Stream->RxChannel);
+  free(Stream->Frames);
+  free(Stream);
+}
+
+#endif
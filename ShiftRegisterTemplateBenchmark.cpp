@@ -0,0 +1,81 @@
+/*
+
+  Benchmark comparing the cycles per bit of the C API (ShiftRegister.c) and the compile-time specialized C++ template
+  (ShiftRegister.hpp) when writing to and reading from a register. Both run without delays, so only the overhead of the
+  library itself is measured. Cycles are counted with the SysTick timer of the Cortex-M0+, running at clk_sys.
+
+  Connect a 74HC595 (or nothing; the ports are only toggled) to the ports below, build with pico_stdlib and check the output
+  on the serial console / USB.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include <stdio.h>
+#include "hardware/structs/systick.h"
+#include "ShiftRegister.c"
+#include "ShiftRegister.hpp"
+
+
+#define BENCHMARK_CLOCK_GPIO     2
+#define BENCHMARK_DATAOUT_GPIO   3
+#define BENCHMARK_LATCH_GPIO     4
+#define BENCHMARK_DATAIN_GPIO    5
+#define BENCHMARK_BITS           32
+#define BENCHMARK_ROUNDS         100
+
+
+// Start SysTick as a free running 24 bits down counter at the processor clock.
+void BenchmarkStartCycleCounter()
+{
+  systick_hw->csr=0;
+  systick_hw->rvr=0x00ffffff;
+  systick_hw->cvr=0;
+  systick_hw->csr=0x5;  // Enable, processor clock, no interrupt.
+}
+
+
+// Return the number of cycles used by a single call, averaged over BENCHMARK_ROUNDS.
+template<typename Function>
+uint32_t BenchmarkCycles(Function Call)
+{
+  uint32_t Start, Total=0;
+
+  for(uint16_t counter=0; counter<BENCHMARK_ROUNDS; counter++)
+  {
+    Start=systick_hw->cvr;
+    Call();
+    Total+=((Start-systick_hw->cvr) & 0x00ffffff);
+  }
+  return(Total/BENCHMARK_ROUNDS);
+}
+
+
+int main()
+{
+  stdio_init_all();
+  sleep_ms(2000);
+  BenchmarkStartCycleCounter();
+
+  // The C API, without delays.
+  ShiftRegister *Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, BENCHMARK_CLOCK_GPIO, BENCHMARK_DATAIN_GPIO, BENCHMARK_DATAOUT_GPIO,
+                                              BENCHMARK_LATCH_GPIO, 0xa5a5a5a5, BENCHMARK_BITS/8);
+  Register->ClockDelayUS=0;
+  Register->LatchDelayUS=0;
+  uint32_t CWrite=BenchmarkCycles([&]() { ShiftRegisterWrite(Register); });
+  uint32_t CRead=BenchmarkCycles([&]() { ShiftRegisterRead(Register); });
+  ShiftRegisterDestroy(Register);
+
+  // The template, without delays.
+  ShiftRegisterTemplate::ShiftRegister<SHIFTREGISTER_HYBRID, BENCHMARK_CLOCK_GPIO, BENCHMARK_DATAIN_GPIO, BENCHMARK_DATAOUT_GPIO,
+                                       BENCHMARK_LATCH_GPIO, BENCHMARK_BITS, false, 0, 0> Template(0xa5a5a5a5);
+  uint32_t TWrite=BenchmarkCycles([&]() { Template.Write(); });
+  uint32_t TRead=BenchmarkCycles([&]() { Template.Read(); });
+
+  printf("Cycles per bit (%d bits)   write   read\n", BENCHMARK_BITS);
+  printf("C API                      %5lu  %5lu\n", (unsigned long)(CWrite/BENCHMARK_BITS), (unsigned long)(CRead/BENCHMARK_BITS));
+  printf("C++ template               %5lu  %5lu\n", (unsigned long)(TWrite/BENCHMARK_BITS), (unsigned long)(TRead/BENCHMARK_BITS));
+  while(true)
+    tight_loop_contents();
+}
@@ -0,0 +1,175 @@
+/*
+
+  GPIO trace recorder for the ShiftRegister library; a logic analyzer for debugging the timing of chains. When
+  SHIFTREGISTER_ENABLE_TRACE is defined before including ShiftRegister.c, every gpio_put/gpio_get issued by the GPIO transport
+  (clock pulses, latch pulses and the data lines) is recorded with a timestamp in CPU cycles into a ring of
+  SHIFTREGISTER_TRACE_SIZE events. The ring is allocated statically, so recording never allocates memory; when it is full the
+  oldest events are overwritten.
+
+  Recording runs between ShiftRegisterTraceStart() and ShiftRegisterTraceStop(). ShiftRegisterTraceExportVCD() writes the
+  recorded events as a VCD file (Value Change Dump), which can be opened in GTKWave; on the Pico pass stdout to dump it to the
+  serial console / USB. Every GPIO port used gets a signal named gpio<n>; values read are shown on the port they were read
+  from.
+
+  On the Pico the cycles are counted with the SysTick timer at clk_sys (started by ShiftRegisterTraceStart()); gaps between
+  two events longer than 2^24 cycles (134 msec at 125 MHz) are shortened. On the host (SHIFTREGISTER_HOST) the virtual time of
+  ShiftRegisterHostSimulator.c is used. Only the GPIO transport is traced.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterTrace
+#define MyHardwareShiftRegisterTrace
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#ifndef SHIFTREGISTER_HOST
+#include "hardware/structs/systick.h"
+#endif
+
+
+#ifndef SHIFTREGISTER_TRACE_SIZE
+#define SHIFTREGISTER_TRACE_SIZE           4096  // Number of events in the ring; must be a power of 2.
+#endif
+#define SHIFTREGISTER_TRACE_GPIOS          30
+
+
+typedef struct
+{
+  uint32_t Cycles;  // Timestamp; the lower 32 bits of the cycle counter.
+  uint8_t GPIO;
+  bool Level, Read;
+} ShiftRegisterTraceEvent;
+
+typedef struct
+{
+  ShiftRegisterTraceEvent Events[SHIFTREGISTER_TRACE_SIZE];
+  uint32_t Head;  // Number of events recorded since the start.
+  uint32_t Cycles, LastSysTick;
+  bool Enabled;
+} ShiftRegisterTraceState;
+
+
+static ShiftRegisterTraceState ShiftRegisterTrace;
+
+
+// Current time in cycles.
+uint32_t ShiftRegisterTraceCycles(void)
+{
+#ifdef SHIFTREGISTER_HOST
+  return((uint32_t)((ShiftRegisterHostTimeNS()*(clock_get_hz(clk_sys)/1000000u))/1000u));
+#else
+  uint32_t SysTick=systick_hw->cvr;
+
+  ShiftRegisterTrace.Cycles+=((ShiftRegisterTrace.LastSysTick-SysTick) & 0x00ffffff);
+  ShiftRegisterTrace.LastSysTick=SysTick;
+  return(ShiftRegisterTrace.Cycles);
+#endif
+}
+
+
+void ShiftRegisterTraceRecord(uint8_t GPIO, bool Level, bool Read)
+{
+  ShiftRegisterTraceEvent *Event;
+
+  if(!ShiftRegisterTrace.Enabled)
+    return;
+  Event=&ShiftRegisterTrace.Events[ShiftRegisterTrace.Head & (SHIFTREGISTER_TRACE_SIZE-1)];
+  Event->Cycles=ShiftRegisterTraceCycles();
+  Event->GPIO=GPIO;
+  Event->Level=Level;
+  Event->Read=Read;
+  ShiftRegisterTrace.Head++;
+}
+
+
+// gpio_put() and gpio_get(), recording the event.
+void ShiftRegisterTracePut(uint GPIO, bool Level)
+{
+  gpio_put(GPIO, Level);
+  ShiftRegisterTraceRecord((uint8_t)GPIO, Level, false);
+}
+
+
+bool ShiftRegisterTraceGet(uint GPIO)
+{
+  bool Level=gpio_get(GPIO);
+
+  ShiftRegisterTraceRecord((uint8_t)GPIO, Level, true);
+  return(Level);
+}
+
+
+// Clear the ring and start recording.
+void ShiftRegisterTraceStart(void)
+{
+#ifndef SHIFTREGISTER_HOST
+  // Start SysTick as a free running 24 bits down counter at the processor clock.
+  systick_hw->csr=0;
+  systick_hw->rvr=0x00ffffff;
+  systick_hw->cvr=0;
+  systick_hw->csr=0x5;  // Enable, processor clock, no interrupt.
+  ShiftRegisterTrace.LastSysTick=systick_hw->cvr;
+#endif
+  ShiftRegisterTrace.Head=0;
+  ShiftRegisterTrace.Cycles=0;
+  ShiftRegisterTrace.Enabled=true;
+}
+
+
+void ShiftRegisterTraceStop(void)
+{
+  ShiftRegisterTrace.Enabled=false;
+}
+
+
+// Number of events available in the ring.
+uint32_t ShiftRegisterTraceCount(void)
+{
+  return(ShiftRegisterTrace.Head<SHIFTREGISTER_TRACE_SIZE?ShiftRegisterTrace.Head:SHIFTREGISTER_TRACE_SIZE);
+}
+
+
+// Write the recorded events to File as VCD, with timestamps in nanoseconds. Stop recording before exporting.
+void ShiftRegisterTraceExportVCD(FILE *File)
+{
+  ShiftRegisterTraceEvent *Event;
+  uint32_t Count=ShiftRegisterTraceCount(), First=ShiftRegisterTrace.Head-Count, Used=0, Previous=0;
+  uint32_t MHz=clock_get_hz(clk_sys)/1000000u;
+  uint64_t Cycles=0;
+  int8_t Level[SHIFTREGISTER_TRACE_GPIOS];
+
+  // Declare a signal for every GPIO port in the trace; the identifier is a printable character.
+  for(uint32_t counter=0; counter<Count; counter++)
+    Used|=(1u << ShiftRegisterTrace.Events[(First+counter) & (SHIFTREGISTER_TRACE_SIZE-1)].GPIO);
+  fprintf(File, "$timescale 1ns $end\n$scope module shiftregister $end\n");
+  for(uint8_t GPIO=0; GPIO<SHIFTREGISTER_TRACE_GPIOS; GPIO++)
+    if((Used & (1u << GPIO))>0)
+      fprintf(File, "$var wire 1 %c gpio%u $end\n", '!'+GPIO, GPIO);
+  fprintf(File, "$upscope $end\n$enddefinitions $end\n$dumpvars\n");
+  for(uint8_t GPIO=0; GPIO<SHIFTREGISTER_TRACE_GPIOS; GPIO++)
+  {
+    Level[GPIO]=-1;
+    if((Used & (1u << GPIO))>0)
+      fprintf(File, "x%c\n", '!'+GPIO);
+  }
+  fprintf(File, "$end\n");
+
+  // Dump the changes; the cycle counter is extended to 64 bits.
+  for(uint32_t counter=0; counter<Count; counter++)
+  {
+    Event=&ShiftRegisterTrace.Events[(First+counter) & (SHIFTREGISTER_TRACE_SIZE-1)];
+    Cycles+=(counter>0?(uint32_t)(Event->Cycles-Previous):0);
+    Previous=Event->Cycles;
+    if(Level[Event->GPIO]==(int8_t)Event->Level)
+      continue;
+    Level[Event->GPIO]=(int8_t)Event->Level;
+    fprintf(File, "#%llu\n%u%c\n", (unsigned long long)((Cycles*1000u)/MHz), (unsigned)Event->Level, '!'+Event->GPIO);
+  }
+}
+
+#endif
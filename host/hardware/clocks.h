@@ -0,0 +1,22 @@
+/*
+
+  Host stub of hardware/clocks.h; the frequency of clk_sys is set by the simulator.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_CLOCKS_H
+#define _HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index
+{
+  clk_sys=5
+};
+
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
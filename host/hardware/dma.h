@@ -0,0 +1,50 @@
+/*
+
+  Host stub of hardware/dma.h for building ShiftRegisterStream.c on Linux with the simulator in ShiftRegisterHostSimulator.c.
+  Only the functions used by the library are declared; they are implemented by the simulator, which moves the words between
+  memory and the FIFOs of the emulated PIO state machines, paced by the DREQ of the channel.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_DMA_H
+#define _HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS                   12
+#define DREQ_FORCE                         0x3f  // Unpaced; transfer as fast as possible.
+
+enum dma_channel_transfer_size
+{
+  DMA_SIZE_8=0,
+  DMA_SIZE_16=1,
+  DMA_SIZE_32=2
+};
+
+typedef struct
+{
+  enum dma_channel_transfer_size size;
+  bool read_increment, write_increment;
+  uint dreq;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr,
+                           uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+
+#endif
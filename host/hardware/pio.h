@@ -0,0 +1,78 @@
+/*
+
+  Host stub of hardware/pio.h for building the PIO backend of the ShiftRegister library on Linux with the simulator in
+  ShiftRegisterHostSimulator.c. Only the functions used by the library are declared; they are implemented by the simulator,
+  which runs the programs loaded into the state machines against the simulated GPIO ports. The configuration is kept in
+  plain fields instead of the register layout of the RP2040.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_PIO_H
+#define _HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+#include "hardware/pio_instructions.h"
+
+#define NUM_PIOS                           2
+#define NUM_PIO_STATE_MACHINES             4
+#define PIO_INSTRUCTION_COUNT              32
+
+// The FIFO registers of a PIO block; DMA channels transfer to and from these addresses.
+typedef struct
+{
+  volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+  volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t ShiftRegisterHostPIOBlocks[NUM_PIOS];
+
+#define pio0                               (&ShiftRegisterHostPIOBlocks[0])
+#define pio1                               (&ShiftRegisterHostPIOBlocks[1])
+
+typedef struct
+{
+  const uint16_t *instructions;
+  uint8_t length;
+  int8_t origin;
+} pio_program_t;
+
+typedef struct
+{
+  float clkdiv;
+  uint8_t wrap_target, wrap;
+  uint8_t sideset_bit_count, sideset_base, set_base, set_count, out_base, out_count, in_base;
+  bool sideset_optional, sideset_pindirs;
+  bool out_shift_right, autopull, in_shift_right, autopush;
+  uint8_t pull_threshold, push_threshold;
+} pio_sm_config;
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+pio_sm_config pio_get_default_sm_config(void);
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap);
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs);
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base);
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count);
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold);
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+void pio_sm_set_pindirs_with_mask(PIO pio, uint sm, uint32_t pin_dirs, uint32_t pin_mask);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get_blocking(PIO pio, uint sm);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+#endif
@@ -0,0 +1,92 @@
+/*
+
+  Host stub of hardware/pio_instructions.h; the instruction encoders used by the PIO backend of the ShiftRegister library,
+  producing the same machine code as the pico SDK.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_PIO_INSTRUCTIONS_H
+#define _HARDWARE_PIO_INSTRUCTIONS_H
+
+#include "pico/stdlib.h"
+
+enum pio_instr_bits
+{
+  pio_instr_bits_jmp=0x0000,
+  pio_instr_bits_wait=0x2000,
+  pio_instr_bits_in=0x4000,
+  pio_instr_bits_out=0x6000,
+  pio_instr_bits_push=0x8000,
+  pio_instr_bits_pull=0x8080,
+  pio_instr_bits_mov=0xa000,
+  pio_instr_bits_irq=0xc000,
+  pio_instr_bits_set=0xe000
+};
+
+// Sources and destinations; the value is the encoding in the instruction.
+enum pio_src_dest
+{
+  pio_pins=0,
+  pio_x=1,
+  pio_y=2,
+  pio_null=3,
+  pio_pindirs=4,
+  pio_pc=5,
+  pio_isr=6,
+  pio_osr=7
+};
+
+static inline uint pio_encode_delay(uint cycles)
+{
+  return(cycles << 8);
+}
+
+static inline uint pio_encode_sideset(uint sideset_bit_count, uint value)
+{
+  return(value << (13u-sideset_bit_count));
+}
+
+static inline uint pio_encode_jmp_x_dec(uint addr)
+{
+  return(pio_instr_bits_jmp | (2u << 5) | (addr & 0x1f));
+}
+
+static inline uint pio_encode_jmp_y_dec(uint addr)
+{
+  return(pio_instr_bits_jmp | (4u << 5) | (addr & 0x1f));
+}
+
+static inline uint pio_encode_in(enum pio_src_dest src, uint count)
+{
+  return(pio_instr_bits_in | ((uint)src << 5) | (count & 0x1f));
+}
+
+static inline uint pio_encode_out(enum pio_src_dest dest, uint count)
+{
+  return(pio_instr_bits_out | ((uint)dest << 5) | (count & 0x1f));
+}
+
+static inline uint pio_encode_push(bool if_full, bool block)
+{
+  return(pio_instr_bits_push | (if_full?0x40u:0) | (block?0x20u:0));
+}
+
+static inline uint pio_encode_pull(bool if_empty, bool block)
+{
+  return(pio_instr_bits_pull | (if_empty?0x40u:0) | (block?0x20u:0));
+}
+
+static inline uint pio_encode_mov(enum pio_src_dest dest, enum pio_src_dest src)
+{
+  return(pio_instr_bits_mov | ((uint)dest << 5) | (uint)src);
+}
+
+static inline uint pio_encode_set(enum pio_src_dest dest, uint value)
+{
+  return(pio_instr_bits_set | ((uint)dest << 5) | (value & 0x1f));
+}
+
+#endif
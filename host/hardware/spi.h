@@ -0,0 +1,61 @@
+/*
+
+  Host stub of hardware/spi.h for building the SPI backend of the ShiftRegister library on Linux with the simulator in
+  ShiftRegisterHostSimulator.c. Only the functions used by the library are declared; they are implemented by the simulator,
+  which clocks the octets out and in on the ports assigned to the peripheral with gpio_set_function(). The configuration is
+  kept in plain fields instead of the register layout of the RP2040.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_SPI_H
+#define _HARDWARE_SPI_H
+
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+typedef enum
+{
+  SPI_CPHA_0=0,
+  SPI_CPHA_1=1
+} spi_cpha_t;
+
+typedef enum
+{
+  SPI_CPOL_0=0,
+  SPI_CPOL_1=1
+} spi_cpol_t;
+
+typedef enum
+{
+  SPI_LSB_FIRST=0,
+  SPI_MSB_FIRST=1
+} spi_order_t;
+
+typedef struct
+{
+  bool Enabled;
+  uint32_t BaudHz;
+  uint8_t DataBits;
+  spi_cpol_t CPOL;
+  spi_cpha_t CPHA;
+  spi_order_t Order;
+
+  // Statistics.
+  uint32_t Octets;
+} spi_inst_t;
+
+extern spi_inst_t ShiftRegisterHostSPIs[2];
+
+#define spi0                               (&ShiftRegisterHostSPIs[0])
+#define spi1                               (&ShiftRegisterHostSPIs[1])
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+void spi_deinit(spi_inst_t *spi);
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+#endif
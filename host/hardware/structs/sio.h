@@ -0,0 +1,24 @@
+/*
+
+  Host stub of hardware/structs/sio.h. The registers are plain memory on the host; the simulator keeps gpio_out up to date
+  with the output levels set by the CPU. Stores to the ports go through gpio_set_mask(), gpio_clr_mask() and gpio_xor_mask()
+  (single stores to gpio_set/gpio_clr/gpio_togl on the RP2040), which the simulator records and applies to the ports.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_STRUCTS_SIO_H
+#define _HARDWARE_STRUCTS_SIO_H
+
+#include <stdint.h>
+
+typedef struct
+{
+  volatile uint32_t cpuid, gpio_in, gpio_hi_in, _pad0, gpio_out, gpio_set, gpio_clr, gpio_togl, gpio_oe, gpio_oe_set, gpio_oe_clr, gpio_oe_togl;
+} sio_hw_t;
+
+extern sio_hw_t *sio_hw;
+
+#endif
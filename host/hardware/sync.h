@@ -0,0 +1,19 @@
+/*
+
+  Host stub of hardware/sync.h; the memory barrier and the event functions. __sev() sets the event shared by both cores,
+  __wfe() waits for it and clears it, so a SEV sent before the WFE is not lost.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _HARDWARE_SYNC_H
+#define _HARDWARE_SYNC_H
+
+#define __dmb()                            __sync_synchronize()
+
+void __wfe(void);
+void __sev(void);
+
+#endif
@@ -0,0 +1,17 @@
+/*
+
+  Host stub of pico/multicore.h. Core1 is a thread; the simulator must only be used by one of the cores at a time (e.g. only
+  by core1 while a service runs on it).
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _PICO_MULTICORE_H
+#define _PICO_MULTICORE_H
+
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1(void);
+
+#endif
@@ -0,0 +1,61 @@
+/*
+
+  Host stub of pico/stdlib.h for building the ShiftRegister library on Linux with the simulator in
+  ShiftRegisterHostSimulator.c. Only the functions used by the library are declared; they are implemented by the simulator.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+
+#define GPIO_OUT                           1
+#define GPIO_IN                            0
+
+enum gpio_function
+{
+  GPIO_FUNC_SPI=1,
+  GPIO_FUNC_SIO=5,
+  GPIO_FUNC_PIO0=6,
+  GPIO_FUNC_PIO1=7
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_mask(uint32_t mask);
+void gpio_clr_mask(uint32_t mask);
+void gpio_xor_mask(uint32_t mask);
+uint32_t gpio_get_all(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_at_least_cycles(uint32_t cycles);
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void tight_loop_contents(void);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+struct repeating_timer
+{
+  int64_t delay_us;
+  repeating_timer_callback_t callback;
+  void *user_data;
+};
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+
+  Host stub of pico/sync.h. The simulator itself runs single-threaded, but the code committing frames may run in other
+  threads (standing in for the other core), so critical sections are POSIX mutexes. Build with -pthread.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#ifndef _PICO_SYNC_H
+#define _PICO_SYNC_H
+
+#include <pthread.h>
+#include "pico/stdlib.h"
+
+typedef struct
+{
+  pthread_mutex_t Mutex;
+} critical_section_t;
+
+void critical_section_init(critical_section_t *crit_sec);
+void critical_section_enter_blocking(critical_section_t *crit_sec);
+void critical_section_exit(critical_section_t *crit_sec);
+void critical_section_deinit(critical_section_t *crit_sec);
+
+#endif
@@ -0,0 +1,186 @@
+/*
+
+  Host test of ShiftRegisterAsync.c: the transfers are stepped by the emulated repeating timer. Checks the outputs, the
+  inputs and a hybrid chain looped back, the rules while a transfer is running (the output is copied at the start, only one
+  transfer at a time, the input is updated in one go), SkipUnchanged after a transfer, creating the struct without memory or
+  timers and starting a transfer after another backend was selected.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+
+// Allocations fail once FailAfter reaches 0; -1 never fails.
+static int FailAfter=-1;
+
+void *TestMalloc(size_t Size)
+{
+  if((FailAfter>=0) && (FailAfter--==0))
+    return(NULL);
+  return(malloc(Size));
+}
+
+#define malloc(Size) TestMalloc(Size)
+#include "ShiftRegisterAsync.c"
+#undef malloc
+#include "tests/ShiftRegisterCheck.c"
+
+
+static uint32_t Completions, InputAtCompletion;
+
+
+void Completed(ShiftRegisterAsync *Async)
+{
+  Completions++;
+  InputAtCompletion=Async->Register->InputBuffer;
+}
+
+
+uint32_t Violations(ShiftRegisterHostChain *Chain)
+{
+  return(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations+Chain->PropagationViolations);
+}
+
+
+void TestOutput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  ShiftRegisterAsync *Async;
+  uint32_t Latches;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  Async=ShiftRegisterAsyncCreate(Register);
+  SHIFTREGISTER_CHECK(Async!=NULL);
+  if(Async==NULL)
+    return;
+
+  // The output is copied at the start; changes made while busy are written by the next transfer.
+  Completions=0;
+  Latches=Chain->Latches;
+  Register->OutputBuffer=0xbeef;
+  SHIFTREGISTER_CHECK(ShiftRegisterUpdateAsync(Async, Completed, NULL));
+  Register->OutputBuffer=0x1234;
+  SHIFTREGISTER_CHECK(ShiftRegisterAsyncBusy(Async) && !ShiftRegisterUpdateAsync(Async, Completed, NULL));
+  SHIFTREGISTER_CHECK(Chain->Latches==Latches);
+  while(ShiftRegisterAsyncBusy(Async))
+    tight_loop_contents();
+  SHIFTREGISTER_CHECK((Completions==1) && (Async->Status==SHIFTREGISTER_ASYNC_DONE));
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xbe) && (Chain->Parallel[1]==0xef) && (Chain->Latches==Latches+1));
+
+  // A half clock period of ClockDelayUS per step.
+  SHIFTREGISTER_CHECK(ShiftRegisterUpdateAsync(Async, NULL, NULL));
+  sleep_us(Register->ClockDelayUS*(2*16+4));
+  SHIFTREGISTER_CHECK((Completions==1) && (!ShiftRegisterAsyncBusy(Async)));
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x12) && (Chain->Parallel[1]==0x34));
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+
+  // With SkipUnchanged, a write of the last value written before an asynchronous transfer is not skipped.
+  Register->SkipUnchanged=true;
+  Register->OutputBuffer=0xa5a5;
+  ShiftRegisterWrite(Register);
+  Register->OutputBuffer=0x1111;
+  ShiftRegisterUpdateAsync(Async, NULL, NULL);
+  while(ShiftRegisterAsyncBusy(Async))
+    tight_loop_contents();
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x11) && (Chain->Parallel[1]==0x11));
+  Register->OutputBuffer=0xa5a5;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xa5) && (Chain->Parallel[1]==0xa5) && (Register->TransfersSkipped==0));
+  ShiftRegisterAsyncDestroy(Async);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestInput(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+  ShiftRegisterAsync *Async;
+
+  // The input buffer only changes when the transfer has completed.
+  ShiftRegisterHostReset();
+  Chain165=ShiftRegisterHostAdd165(6, 7, 8, 2);
+  Chain165->Parallel[0]=0xc3;
+  Chain165->Parallel[1]=0x5a;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 6, 7, 0, 8, 0, 2);
+  Async=ShiftRegisterAsyncCreate(Register);
+  Register->InputBuffer=0xffff;
+  Completions=0;
+  ShiftRegisterUpdateAsync(Async, Completed, NULL);
+  sleep_us(10);
+  SHIFTREGISTER_CHECK(ShiftRegisterAsyncBusy(Async) && (Register->InputBuffer==0xffff));
+  sleep_us(Register->ClockDelayUS*(2*16+4));
+  SHIFTREGISTER_CHECK((Completions==1) && (InputAtCompletion==0xc35a) && (Register->InputBuffer==0xc35a));
+  SHIFTREGISTER_CHECK(Violations(Chain165)==0);
+  ShiftRegisterAsyncDestroy(Async);
+  ShiftRegisterDestroy(Register);
+
+  // Hybrid chain looped back; the second transfer reads what the first one wrote.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 3);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, 3);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0, 3);
+  Register->Backend=SHIFTREGISTER_BACKEND_SIO;
+  Async=ShiftRegisterAsyncCreate(Register);
+  Register->OutputBuffer=0xa5c381;
+  for(uint8_t counter=0; counter<2; counter++)
+  {
+    ShiftRegisterUpdateAsync(Async, NULL, NULL);
+    while(ShiftRegisterAsyncBusy(Async))
+      tight_loop_contents();
+  }
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xa5c381);
+  SHIFTREGISTER_CHECK((Violations(Chain595)==0) && (Violations(Chain165)==0));
+  ShiftRegisterAsyncDestroy(Async);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestCreate(void)
+{
+  ShiftRegister *Register;
+  ShiftRegisterAsync *Async;
+  repeating_timer_t Timers[SHIFTREGISTER_HOST_MAXTIMERS];
+
+  ShiftRegisterHostReset();
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+
+  // Without memory for the struct or for the buffers.
+  for(int counter=0; counter<2; counter++)
+  {
+    FailAfter=counter;
+    SHIFTREGISTER_CHECK(ShiftRegisterAsyncCreate(Register)==NULL);
+    FailAfter=-1;
+  }
+
+  // Without a free timer the transfer is not started and the struct is not left busy.
+  Async=ShiftRegisterAsyncCreate(Register);
+  SHIFTREGISTER_CHECK(Async!=NULL);
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXTIMERS; counter++)
+    add_repeating_timer_us(1000000, NULL, NULL, &Timers[counter]);
+  SHIFTREGISTER_CHECK(!ShiftRegisterUpdateAsync(Async, NULL, NULL) && !ShiftRegisterAsyncBusy(Async));
+  for(uint8_t counter=0; counter<SHIFTREGISTER_HOST_MAXTIMERS; counter++)
+    cancel_repeating_timer(&Timers[counter]);
+
+  // Other backends are not supported, also when selected after creating the struct.
+  Register->Backend=SHIFTREGISTER_BACKEND_CUSTOM;
+  SHIFTREGISTER_CHECK(!ShiftRegisterUpdateAsync(Async, NULL, NULL) && !ShiftRegisterAsyncBusy(Async));
+  SHIFTREGISTER_CHECK(ShiftRegisterAsyncCreate(Register)==NULL);
+  ShiftRegisterAsyncDestroy(Async);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestOutput();
+  TestInput();
+  TestCreate();
+  return(ShiftRegisterTestResult("ShiftRegisterAsyncTest"));
+}
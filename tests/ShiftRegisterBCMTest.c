@@ -0,0 +1,127 @@
+/*
+
+  Host test of ShiftRegisterBCM.c on the GPIO and PIO backends. The engine runs from its repeating timer while the test
+  sleeps in steps of a microsecond; the on-time of every output of the simulated 74HC595 chain is integrated in virtual time
+  over whole cycles and compared to the requested duty (Intensity/255). Also checks that a commit is only shown from the
+  start of a cycle, that a later commit within the cycle replaces it and that the outputs keep the last plane after
+  ShiftRegisterBCMStop().
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#define SHIFTREGISTER_ENABLE_PIO
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterBCM.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define OCTETS                             2
+#define OUTPUTS                            (OCTETS*8)
+#define BASEUS                             8
+#define CYCLEUS                            (255*BASEUS)
+#define CYCLES                             4
+
+
+static const uint8_t Intensities[OUTPUTS]={0, 1, 2, 3, 15, 16, 64, 100, 127, 128, 129, 200, 240, 253, 254, 255};
+
+
+// Sleep for the given time in steps of a microsecond and add per output the time of the steps it was on at the end. The
+// interrupts take time as well, so a step can be longer than a microsecond.
+void Integrate(ShiftRegisterHostChain *Chain, uint32_t US, uint64_t *OnNS)
+{
+  uint64_t EndNS=ShiftRegisterHostTimeNS()+US*1000ull, PreviousNS;
+
+  memset(OnNS, 0, OUTPUTS*sizeof(uint64_t));
+  while(ShiftRegisterHostTimeNS()<EndNS)
+  {
+    PreviousNS=ShiftRegisterHostTimeNS();
+    sleep_us(1);
+    for(uint16_t Output=0; Output<OUTPUTS; Output++)
+      if((Chain->Parallel[Output/8] & (0x80 >> (Output%8)))>0)
+        OnNS[Output]+=ShiftRegisterHostTimeNS()-PreviousNS;
+  }
+}
+
+
+// The measured on-time is within a step per latch pulse of the requested one.
+bool MatchesDuty(const uint64_t *OnNS, const uint8_t *Requested, uint32_t Cycles)
+{
+  int64_t Expected, Tolerance=(int64_t)Cycles*SHIFTREGISTER_BCM_PLANES*1000;
+  bool Matches=true;
+
+  for(uint16_t Output=0; Output<OUTPUTS; Output++)
+  {
+    Expected=(int64_t)Requested[Output]*BASEUS*Cycles*1000;
+    Matches&=((int64_t)OnNS[Output]>=Expected-Tolerance) && ((int64_t)OnNS[Output]<=Expected+Tolerance);
+  }
+  return(Matches);
+}
+
+
+void TestDuty(bool UsePIO)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  ShiftRegisterBCM *BCM;
+  uint64_t OnNS[OUTPUTS];
+  uint8_t Inverted[OUTPUTS];
+  uint8_t Latched[OCTETS];
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, OCTETS);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, OCTETS);
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  if(UsePIO)
+    SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 10000000));
+  BCM=ShiftRegisterBCMCreate(Register, BASEUS);
+  SHIFTREGISTER_CHECK(BCM!=NULL);
+  if(BCM==NULL)
+    return;
+  for(uint16_t Output=0; Output<OUTPUTS; Output++)
+    ShiftRegisterBCMSetIntensity(BCM, Output, Intensities[Output]);
+  ShiftRegisterBCMSetIntensity(BCM, OUTPUTS, 255);  // Out of range; ignored.
+  ShiftRegisterBCMCommit(BCM);
+
+  // The timer starts at plane 0, so whole cycles are integrated from the start.
+  SHIFTREGISTER_CHECK(ShiftRegisterBCMStart(BCM) && (!ShiftRegisterBCMStart(BCM)));
+  Integrate(Chain, CYCLES*CYCLEUS, OnNS);
+  SHIFTREGISTER_CHECK(MatchesDuty(OnNS, Intensities, CYCLES));
+  SHIFTREGISTER_CHECK((OnNS[0]==0) && (OnNS[OUTPUTS-1]>=CYCLES*CYCLEUS*1000ull));
+
+  // A commit before the last plane is shown from the start of the next cycle; the rest of the cycle keeps the old
+  // intensities. A second commit within the cycle replaces the first one.
+  sleep_us(CYCLEUS/4);
+  for(uint16_t Output=0; Output<OUTPUTS; Output++)
+    ShiftRegisterBCMSetIntensity(BCM, Output, 255);
+  ShiftRegisterBCMCommit(BCM);
+  for(uint16_t Output=0; Output<OUTPUTS; Output++)
+  {
+    Inverted[Output]=(uint8_t)(255-Intensities[Output]);
+    ShiftRegisterBCMSetIntensity(BCM, Output, Inverted[Output]);
+  }
+  ShiftRegisterBCMCommit(BCM);
+  Integrate(Chain, CYCLEUS-CYCLEUS/4-10, OnNS);
+  SHIFTREGISTER_CHECK((OnNS[0]==0) && (OnNS[OUTPUTS-1]>=(CYCLEUS-CYCLEUS/4-10)*1000ull));
+  sleep_us(10);
+  Integrate(Chain, CYCLES*CYCLEUS, OnNS);
+  SHIFTREGISTER_CHECK(MatchesDuty(OnNS, Inverted, CYCLES));
+  SHIFTREGISTER_CHECK((OnNS[0]>=CYCLES*CYCLEUS*1000ull) && (OnNS[OUTPUTS-1]==0));
+  SHIFTREGISTER_CHECK(Chain->SetupViolations+Chain->HoldViolations==0);
+
+  // After stopping, the outputs keep the last plane.
+  ShiftRegisterBCMStop(BCM);
+  memcpy(Latched, Chain->Parallel, OCTETS);
+  sleep_us(CYCLEUS);
+  SHIFTREGISTER_CHECK(memcmp(Latched, Chain->Parallel, OCTETS)==0);
+  ShiftRegisterBCMDestroy(BCM);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestDuty(false);
+  TestDuty(true);
+  return(ShiftRegisterTestResult("ShiftRegisterBCMTest"));
+}
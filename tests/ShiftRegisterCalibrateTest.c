@@ -0,0 +1,117 @@
+/*
+
+  Host test of ShiftRegisterCalibrate.c: a hybrid chain is looped back in the simulator, with the setup time of the 74HC595
+  and the propagation delay of the 74HC165 set to slow values. Checks that the calibrated delay reads the patterns back
+  without timing violations, that the next step down fails, that slower chips get a longer delay and that the output and the
+  original delays are restored.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterCalibrate.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+static ShiftRegisterHostChain *Chain595, *Chain165;
+
+
+uint32_t Violations(void)
+{
+  return(Chain595->SetupViolations+Chain595->HoldViolations+Chain595->PulseWidthViolations+Chain165->SetupViolations+
+         Chain165->PropagationViolations);
+}
+
+
+// Create a looped back hybrid chain of 3 octets with the specified setup time and propagation delay.
+ShiftRegister *Create(uint8_t Backend, uint32_t SetupNS, uint32_t PropagationNS)
+{
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 3);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, 3);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Chain595->SetupNS=SetupNS;
+  Chain165->PropagationNS=PropagationNS;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0, 3);
+  Register->Backend=Backend;
+  return(Register);
+}
+
+
+// Calibrate and check the result against the timing of the chips. Returns the calibrated delay.
+uint32_t Calibrate(uint8_t Backend, uint32_t SetupNS, uint32_t PropagationNS)
+{
+  ShiftRegister *Register=Create(Backend, SetupNS, PropagationNS);
+  uint32_t DelayNS, FastestNS;
+
+  Register->OutputBuffer=0x123456;
+  SHIFTREGISTER_CHECK(ShiftRegisterCalibrate(Register, 2000, 25));
+  DelayNS=Register->ClockDelayNS;
+  FastestNS=(DelayNS*100)/125;
+  SHIFTREGISTER_CHECK((Register->LatchDelayNS==DelayNS) && (DelayNS<2000));
+
+  // The output is restored and written.
+  SHIFTREGISTER_CHECK((Register->OutputBuffer==0x123456) && (Chain595->Parallel[0]==0x12) && (Chain595->Parallel[2]==0x56));
+
+  // The calibrated delay works without violations; the fastest delay still reads back and the next step does not.
+  Chain595->SetupViolations=Chain595->HoldViolations=Chain595->PulseWidthViolations=0;
+  Chain165->SetupViolations=Chain165->PropagationViolations=0;
+  SHIFTREGISTER_CHECK(ShiftRegisterCalibrateCheck(Register) && (Violations()==0));
+  ShiftRegisterSetDelayNS(Register, FastestNS, FastestNS);
+  SHIFTREGISTER_CHECK(ShiftRegisterCalibrateCheck(Register));
+  ShiftRegisterSetDelayNS(Register, (FastestNS*SHIFTREGISTER_CALIBRATE_STEP)/100, (FastestNS*SHIFTREGISTER_CALIBRATE_STEP)/100);
+  SHIFTREGISTER_CHECK(!ShiftRegisterCalibrateCheck(Register));
+  ShiftRegisterDestroy(Register);
+  return(DelayNS);
+}
+
+
+void TestCalibrate(void)
+{
+  uint32_t Fast, Slow, Setup;
+
+  // With SIO stores of one cycle (8 nsec) a bit is read two delays and two stores after the rising edge of the clock, so the
+  // fastest delay (without the margin) has to cover the propagation delay of the 74HC165 in that time.
+  Fast=(Calibrate(SHIFTREGISTER_BACKEND_SIO, 20, 100)*100)/125;
+  Slow=(Calibrate(SHIFTREGISTER_BACKEND_SIO, 20, 400)*100)/125;
+  SHIFTREGISTER_CHECK((Fast*2+16>=100) && (Slow*2+16>=400) && (Slow>Fast));
+
+  // The data line changes with the falling edge of the clock, one delay and one store before the rising edge; that has to
+  // cover the setup time of the 74HC595.
+  Setup=(Calibrate(SHIFTREGISTER_BACKEND_SIO, 300, 20)*100)/125;
+  SHIFTREGISTER_CHECK((Setup+8>=300) && (Setup>Slow));
+
+  // Each GPIO call takes time of its own, so the GPIO backend never needs a longer delay.
+  SHIFTREGISTER_CHECK((Calibrate(SHIFTREGISTER_BACKEND_GPIO, 20, 400)*100)/125<=Slow);
+}
+
+
+void TestFailures(void)
+{
+  ShiftRegister *Register;
+
+  // Chips slower than the start delay; the original delays are kept.
+  Register=Create(SHIFTREGISTER_BACKEND_SIO, 20, 5000);
+  ShiftRegisterSetDelayNS(Register, 3000, 4000);
+  SHIFTREGISTER_CHECK(!ShiftRegisterCalibrate(Register, 2000, 25));
+  SHIFTREGISTER_CHECK((Register->ClockDelayNS==3000) && (Register->LatchDelayNS==4000));
+  ShiftRegisterDestroy(Register);
+
+  // Only hybrid chains on the GPIO or SIO backend can be calibrated.
+  Register=Create(SHIFTREGISTER_BACKEND_SIO, 20, 20);
+  Register->Type=SHIFTREGISTER_OUTPUT;
+  SHIFTREGISTER_CHECK(!ShiftRegisterCalibrate(Register, 2000, 25));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestCalibrate();
+  TestFailures();
+  return(ShiftRegisterTestResult("ShiftRegisterCalibrateTest"));
+}
@@ -0,0 +1,97 @@
+/*
+
+  Host test of chains longer than MAX_SIZEINOCTETS (ShiftRegisterCreateChain()): 128 and 131 octets (the last word holding 3
+  octets) written to 74HC595 chains, read from 74HC165 chains and looped back through a hybrid chain, with caller provided
+  and library allocated octet arrays.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define MAXOCTETS                          131
+
+
+// A pattern that differs per octet and per size.
+void Pattern(uint8_t *Octets, uint16_t SizeInOctets, uint8_t Seed)
+{
+  for(uint16_t counter=0; counter<SizeInOctets; counter++)
+    Octets[counter]=(uint8_t)(counter*29+Seed+SizeInOctets);
+}
+
+
+void TestWrite(uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint8_t Output[MAXOCTETS];
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, SizeInOctets);
+  SHIFTREGISTER_CHECK(Chain!=NULL);
+  Pattern(Output, SizeInOctets, 1);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, SizeInOctets, NULL, Output);
+  SHIFTREGISTER_CHECK(memcmp(Chain->Parallel, Output, SizeInOctets)==0);
+  Output[SizeInOctets-1]^=0x81;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK(memcmp(Chain->Parallel, Output, SizeInOctets)==0);
+  SHIFTREGISTER_CHECK(Chain->Clocks==SizeInOctets*16u);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestRead(uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(6, 7, 8, SizeInOctets);
+  Pattern(Chain->Parallel, SizeInOctets, 2);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_INPUT, 6, 7, 0, 8, SizeInOctets, NULL, NULL);
+  SHIFTREGISTER_CHECK(memcmp(Register->InputOctets, Chain->Parallel, SizeInOctets)==0);
+  Chain->Parallel[0]=0x5a;
+  Chain->Parallel[SizeInOctets-1]=0xa5;
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK(memcmp(Register->InputOctets, Chain->Parallel, SizeInOctets)==0);
+  SHIFTREGISTER_CHECK(Chain->PropagationViolations==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestLoopback(uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+  uint8_t Input[MAXOCTETS], Output[MAXOCTETS];
+
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(10, 11, 12, SHIFTREGISTER_HOST_NOPIN, SizeInOctets);
+  Chain165=ShiftRegisterHostAdd165(10, 13, 12, SizeInOctets);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Pattern(Output, SizeInOctets, 3);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_HYBRID, 10, 13, 11, 12, SizeInOctets, Input, Output);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(memcmp(Input, Output, SizeInOctets)==0);
+  Output[SizeInOctets/2]=0;
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(memcmp(Input, Output, SizeInOctets)==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestWrite(128);
+  TestWrite(131);
+  TestRead(128);
+  TestRead(131);
+  TestLoopback(128);
+  TestLoopback(131);
+  return(ShiftRegisterTestResult("ShiftRegisterChainTest"));
+}
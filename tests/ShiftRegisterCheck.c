@@ -0,0 +1,48 @@
+/*
+
+  Support for the host tests of the ShiftRegister library. Every test is a small program that includes
+  ShiftRegisterHostSimulator.c, the parts of the library it tests and this file, checks the results with
+  SHIFTREGISTER_CHECK() and returns ShiftRegisterTestResult() from main(). Failed checks are reported with their file and
+  line, so a run of tests/run.sh shows where a change broke the library.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+
+#ifndef MyHardwareShiftRegisterCheck
+#define MyHardwareShiftRegisterCheck
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#define SHIFTREGISTER_CHECK(Condition)     ShiftRegisterTestCheck((Condition), #Condition, __FILE__, __LINE__)
+
+
+static uint32_t ShiftRegisterTestChecks=0, ShiftRegisterTestFailures=0;
+
+
+// Count a check and report it when it failed. Returns Passed, so tests can skip checks that depend on it.
+bool ShiftRegisterTestCheck(bool Passed, const char *Condition, const char *File, int Line)
+{
+  ShiftRegisterTestChecks++;
+  if(!Passed)
+  {
+    ShiftRegisterTestFailures++;
+    printf("%s:%d: check failed: %s\n", File, Line, Condition);
+  }
+  return(Passed);
+}
+
+
+// Print the summary of the test; returns the exit code of the test program.
+int ShiftRegisterTestResult(const char *Name)
+{
+  printf("%s: %lu checks, %lu failed\n", Name, (unsigned long)ShiftRegisterTestChecks, (unsigned long)ShiftRegisterTestFailures);
+  return(ShiftRegisterTestFailures>0?1:0);
+}
+
+#endif
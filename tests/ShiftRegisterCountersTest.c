@@ -0,0 +1,94 @@
+/*
+
+  Host test of the instrumentation counters (SHIFTREGISTER_ENABLE_COUNTERS) on the GPIO and PIO backends. Checks that only
+  the transfers performed are counted (skipped writes are not, on either backend), the bits shifted per type of transfer,
+  the time spent and that a frame committed to a register on the PIO backend is taken over once.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#define SHIFTREGISTER_ENABLE_COUNTERS
+#define SHIFTREGISTER_ENABLE_PIO
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+// Write the same output three times with SkipUnchanged on the backend; only the first write is performed and counted.
+void TestSkipped(bool UsePIO)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  ShiftRegisterCounters Counters;
+  uint32_t Latches, Performed;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  if(UsePIO)
+    SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 1000000));
+  Register->SkipUnchanged=true;
+  ShiftRegisterResetCounters(Register);
+  Latches=Chain->Latches;
+  Performed=Register->TransfersPerformed;
+  Register->OutputBuffer=0xbeef;
+  for(uint8_t counter=0; counter<3; counter++)
+    ShiftRegisterWrite(Register);
+  ShiftRegisterGetCounters(Register, &Counters);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xbe) && (Chain->Parallel[1]==0xef) && (Chain->Latches==Latches+1));
+  SHIFTREGISTER_CHECK((Counters.Writes==1) && (Counters.BitsOut==16) && (Counters.BitsIn==0));
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==Performed+1) && (Register->TransfersSkipped==2));
+
+  // Fills are always performed.
+  ShiftRegisterFill(Register, 0);
+  ShiftRegisterGetCounters(Register, &Counters);
+  SHIFTREGISTER_CHECK((Counters.Fills==1) && (Counters.BitsOut==32) && (Chain->Parallel[0]==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestTypes(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+  ShiftRegisterCounters Counters;
+  uint8_t Frame[3]={0x12, 0x34, 0x56};
+
+  // A looped back hybrid chain of 3 octets on the PIO backend.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 3);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, 3);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0, 3);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 1000000));
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableDoubleBuffer(Register));
+  ShiftRegisterResetCounters(Register);
+
+  // The committed frame is written by the next transfer, and read back by the one after.
+  ShiftRegisterCommitFrame(Register, Frame);
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK((Register->OutputBuffer==0x123456) && (Chain595->Parallel[2]==0x56) && (Register->InputBuffer==0x123456));
+  ShiftRegisterRead(Register);
+  ShiftRegisterGetCounters(Register, &Counters);
+  SHIFTREGISTER_CHECK((Counters.ReadWrites==2) && (Counters.Reads==1) && (Counters.Writes==0) && (Counters.Fills==0));
+  SHIFTREGISTER_CHECK((Counters.BitsOut==48) && (Counters.BitsIn==72));
+
+  // 24 bits at 1 MHz take at least 24 usec per transfer.
+  SHIFTREGISTER_CHECK((Counters.TransferNS>=3*24000) && (Counters.MaxLatencyNS>=24000));
+  ShiftRegisterResetCounters(Register);
+  ShiftRegisterGetCounters(Register, &Counters);
+  SHIFTREGISTER_CHECK((Counters.ReadWrites==0) && (Counters.BitsOut==0) && (Counters.TransferNS==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestSkipped(false);
+  TestSkipped(true);
+  TestTypes();
+  return(ShiftRegisterTestResult("ShiftRegisterCountersTest"));
+}
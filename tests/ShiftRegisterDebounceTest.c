@@ -0,0 +1,184 @@
+/*
+
+  Host test of ShiftRegisterDebounce.c against a scalar reference (one counter per input) on a chain of 3 octets (word 0 is
+  InputBuffer) and a chain of 10 octets (3 words, the last one of 2 octets) of simulated 74HC165 chips. Every input follows
+  a bouncing waveform: the level changes at random moments and then bounces for a few samples. After every read the
+  debounced levels and the changed inputs must match the reference, also when the thresholds are changed while inputs are
+  counting.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterDebounce.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define MAXINPUTS                          80
+#define SAMPLES                            2000
+
+
+typedef struct
+{
+  // The reference: debounced level and number of consecutive samples at the other level, per input.
+  bool Stable[MAXINPUTS];
+  uint8_t Count[MAXINPUTS];
+  uint8_t PressThreshold, ReleaseThreshold;
+
+  // The waveform: the level the input settles at and the samples it still bounces.
+  bool Level[MAXINPUTS];
+  uint8_t Bouncing[MAXINPUTS];
+} Reference;
+
+
+static uint32_t Seed=11;
+
+
+uint32_t Random(uint32_t Range)
+{
+  Seed=Seed*1664525u+1013904223u;
+  return((Seed>>16) % Range);
+}
+
+
+// Next sample of an input: the settled level changes now and then, and bounces for upto 8 samples after a change.
+bool Waveform(Reference *Model, uint16_t Pin)
+{
+  if((Model->Bouncing[Pin]==0) && (Random(40)==0))
+  {
+    Model->Level[Pin]=!Model->Level[Pin];
+    Model->Bouncing[Pin]=(uint8_t)Random(9);
+  }
+  if(Model->Bouncing[Pin]>0)
+  {
+    Model->Bouncing[Pin]--;
+    return(Random(2)>0);
+  }
+  return(Model->Level[Pin]);
+}
+
+
+// The scalar reference; returns true if the debounced level changed.
+bool Debounce(Reference *Model, uint16_t Pin, bool Sample)
+{
+  if(Sample==Model->Stable[Pin])
+  {
+    Model->Count[Pin]=0;
+    return(false);
+  }
+  Model->Count[Pin]++;
+  if(Model->Count[Pin]<(Sample?Model->PressThreshold:Model->ReleaseThreshold))
+    return(false);
+  Model->Stable[Pin]=Sample;
+  Model->Count[Pin]=0;
+  return(true);
+}
+
+
+void SetThresholds(ShiftRegisterDebounce *Debouncer, Reference *Model, uint8_t PressThreshold, uint8_t ReleaseThreshold)
+{
+  ShiftRegisterDebounceSetThresholds(Debouncer, PressThreshold, ReleaseThreshold);
+  Model->PressThreshold=Debouncer->PressThreshold;
+  Model->ReleaseThreshold=Debouncer->ReleaseThreshold;
+  memset(Model->Count, 0, sizeof(Model->Count));
+}
+
+
+void TestWaveforms(uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register, *Output;
+  ShiftRegisterDebounce *Debouncer;
+  Reference Model;
+  uint16_t Inputs=SizeInOctets*8, Word;
+  uint32_t Changes=0, Bounces=0, Samples;
+  bool Sample, Matches=true, Changed;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(2, 5, 4, SizeInOctets);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_INPUT, 2, 5, 0, 4, SizeInOctets, NULL, NULL);
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  Output=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 10, 0, 11, 12, 0, 1);
+  SHIFTREGISTER_CHECK(ShiftRegisterDebounceCreate(Output, 3, 3)==NULL);
+  ShiftRegisterDestroy(Output);
+  Debouncer=ShiftRegisterDebounceCreate(Register, 0, 40);
+  SHIFTREGISTER_CHECK((Debouncer!=NULL) && (Debouncer->Words==(SizeInOctets+3)/4));
+  if(Debouncer==NULL)
+    return;
+  SHIFTREGISTER_CHECK((Debouncer->PressThreshold==1) && (Debouncer->ReleaseThreshold==SHIFTREGISTER_DEBOUNCE_MAXTHRESHOLD));
+  memset(&Model, 0, sizeof(Model));
+  SetThresholds(Debouncer, &Model, 4, 6);
+
+  // The first update takes the sample as the debounced level.
+  for(uint16_t Pin=0; Pin<Inputs; Pin++)
+    Model.Stable[Pin]=Model.Level[Pin]=(Random(2)>0);
+  for(uint16_t Pin=0; Pin<Inputs; Pin++)
+    Chain->Parallel[Pin/8]=(uint8_t)((Chain->Parallel[Pin/8] & ~(0x80 >> (Pin%8))) | (Model.Level[Pin]?(0x80 >> (Pin%8)):0));
+  ShiftRegisterRead(Register);
+  ShiftRegisterDebounceUpdate(Debouncer);
+  for(uint16_t Pin=0; Pin<Inputs; Pin++)
+    Matches&=(ShiftRegisterDebounceGet(Debouncer, Pin)==Model.Stable[Pin]);
+  SHIFTREGISTER_CHECK(Matches && (!ShiftRegisterDebounceGet(Debouncer, Inputs)));
+
+  // Thresholds are changed while inputs are counting: lowered halfway, raised again at three quarters.
+  for(Samples=0; Samples<SAMPLES; Samples++)
+  {
+    if(Samples==SAMPLES/2)
+      SetThresholds(Debouncer, &Model, 2, 1);
+    if(Samples==SAMPLES*3/4)
+      SetThresholds(Debouncer, &Model, 9, 15);
+    for(uint16_t Pin=0; Pin<Inputs; Pin++)
+    {
+      Sample=Waveform(&Model, Pin);
+      Bounces+=(Model.Bouncing[Pin]>0);
+      if(Sample)
+        Chain->Parallel[Pin/8]|=(0x80 >> (Pin%8));
+      else
+        Chain->Parallel[Pin/8]&=~(0x80 >> (Pin%8));
+    }
+    ShiftRegisterRead(Register);
+    ShiftRegisterDebounceUpdate(Debouncer);
+    for(uint16_t Pin=0; Pin<Inputs; Pin++)
+    {
+      Changed=Debounce(&Model, Pin, (Chain->Parallel[Pin/8] & (0x80 >> (Pin%8)))>0);
+      Changes+=Changed;
+      Word=Pin/32;
+      Matches&=(ShiftRegisterDebounceGet(Debouncer, Pin)==Model.Stable[Pin]);
+      Matches&=(((Debouncer->Changed[Word]>>(ShiftRegisterInputWordBits(Register, Word)-1-(Pin%32))) & 1)==Changed);
+    }
+  }
+  SHIFTREGISTER_CHECK(Matches);
+  SHIFTREGISTER_CHECK((Changes>Inputs*SAMPLES/100) && (Bounces>Inputs*SAMPLES/100));
+
+  // A change counted upto 10 samples against a threshold of 15 is accepted after 3 more samples when the threshold is
+  // lowered to 3.
+  SetThresholds(Debouncer, &Model, 15, 15);
+  Chain->Parallel[0]=(uint8_t)((Chain->Parallel[0] & 0x7f) | (ShiftRegisterDebounceGet(Debouncer, 0)?0x80:0));
+  ShiftRegisterRead(Register);
+  ShiftRegisterDebounceUpdate(Debouncer);
+  Chain->Parallel[0]^=0x80;
+  for(uint8_t counter=0; counter<10; counter++)
+  {
+    ShiftRegisterRead(Register);
+    ShiftRegisterDebounceUpdate(Debouncer);
+  }
+  SHIFTREGISTER_CHECK(ShiftRegisterDebounceGet(Debouncer, 0)!=((Chain->Parallel[0] & 0x80)>0));
+  ShiftRegisterDebounceSetThresholds(Debouncer, 3, 3);
+  for(uint8_t counter=0; counter<3; counter++)
+  {
+    ShiftRegisterRead(Register);
+    ShiftRegisterDebounceUpdate(Debouncer);
+  }
+  SHIFTREGISTER_CHECK(ShiftRegisterDebounceGet(Debouncer, 0)==((Chain->Parallel[0] & 0x80)>0));
+  ShiftRegisterDebounceDestroy(Debouncer);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestWaveforms(3);
+  TestWaveforms(10);
+  return(ShiftRegisterTestResult("ShiftRegisterDebounceTest"));
+}
@@ -0,0 +1,79 @@
+/*
+
+  Host test of the delays in nanoseconds: the conversion to cycles is rounded up at several clk_sys frequencies, and the
+  clock and latch delays measured in the simulator are never shorter than requested.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+static const uint32_t Clocks[]={48000000, 125000000, 133000000, 200000000, 250000000};
+
+
+void TestConversion(void)
+{
+  bool AtLeast=true, Tight=true;
+  uint32_t Cycles;
+
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(0, 125000000)==0);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(1, 125000000)==1);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(8, 125000000)==1);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(9, 125000000)==2);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(100, 133000000)==14);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(7, 200000000)==2);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(1000, 48000000)==48);
+  SHIFTREGISTER_CHECK(ShiftRegisterNSToCycles(4000000000u, 250000000)==1000000000u);
+
+  // The cycles cover the delay, and one cycle less does not.
+  for(uint8_t counter=0; counter<sizeof(Clocks)/sizeof(Clocks[0]); counter++)
+    for(uint32_t DelayNS=1; DelayNS<=1000; DelayNS++)
+    {
+      Cycles=ShiftRegisterNSToCycles(DelayNS, Clocks[counter]);
+      AtLeast&=((uint64_t)Cycles*1000000000u>=(uint64_t)DelayNS*Clocks[counter]);
+      Tight&=((uint64_t)(Cycles-1)*1000000000u<(uint64_t)DelayNS*Clocks[counter]);
+    }
+  SHIFTREGISTER_CHECK(AtLeast);
+  SHIFTREGISTER_CHECK(Tight);
+}
+
+
+void TestDelays(void)
+{
+  ShiftRegister *Register;
+  bool AtLeast=true;
+  uint64_t Start;
+
+  // The busy-wait of the simulator takes the cycles at clk_sys; the clock and latch delays take at least the delay set.
+  for(uint8_t counter=0; counter<sizeof(Clocks)/sizeof(Clocks[0]); counter++)
+  {
+    ShiftRegisterHostReset();
+    ShiftRegisterHost.ClockHz=Clocks[counter];
+    Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 1);
+    for(uint32_t DelayNS=1; DelayNS<=100; DelayNS++)
+    {
+      ShiftRegisterSetDelayNS(Register, DelayNS, DelayNS+1);
+      Start=ShiftRegisterHostTimeNS();
+      ShiftRegisterClockDelay(Register);
+      AtLeast&=(ShiftRegisterHostTimeNS()-Start>=DelayNS);
+      Start=ShiftRegisterHostTimeNS();
+      ShiftRegisterLatchDelay(Register);
+      AtLeast&=(ShiftRegisterHostTimeNS()-Start>=DelayNS+1);
+    }
+    ShiftRegisterDestroy(Register);
+  }
+  SHIFTREGISTER_CHECK(AtLeast);
+}
+
+
+int main()
+{
+  TestConversion();
+  TestDelays();
+  return(ShiftRegisterTestResult("ShiftRegisterDelayTest"));
+}
@@ -0,0 +1,136 @@
+/*
+
+  Host test of double buffering: a second thread (standing in for the other core) commits frames as fast as it can while
+  the main thread takes them over and writes them to a 74HC595 chain. Every frame consists of a single value repeated over all octets, so a
+  frame committed while it was being taken over shows up as a frame with different octets. Also checks that the latest
+  commit wins and that transfers without a commit keep the last frame.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define OCTETS                             256
+#define WRITES                             1000000
+#define SWAPSPERWRITE                      1000
+
+
+static ShiftRegister *Register;
+static uint8_t Output[OCTETS];
+static volatile bool Stop;
+static volatile uint32_t Commits;
+
+
+// Commit frames of increasing values until stopped.
+void *Committer(void *Argument)
+{
+  uint8_t Frame[OCTETS];
+
+  (void)Argument;
+  while(!Stop)
+  {
+    memset(Frame, (uint8_t)Commits, sizeof(Frame));
+    ShiftRegisterCommitFrame(Register, Frame);
+    Commits++;
+  }
+  return(NULL);
+}
+
+
+// Returns true if all octets of the frame are the same.
+bool Complete(const uint8_t *Frame)
+{
+  for(uint16_t counter=1; counter<OCTETS; counter++)
+    if(Frame[counter]!=Frame[0])
+      return(false);
+  return(true);
+}
+
+
+void TestCommits(void)
+{
+  ShiftRegisterHostChain *Chain;
+  pthread_t Thread;
+  uint32_t Torn=0, Changes=0;
+  uint8_t Previous=0;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, OCTETS);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, OCTETS, NULL, Output);
+  Register->Backend=SHIFTREGISTER_BACKEND_SIO;
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableDoubleBuffer(Register));
+
+  // The simulator is only used by this thread; the other one only commits.
+  Stop=false;
+  Commits=0;
+  SHIFTREGISTER_CHECK(pthread_create(&Thread, NULL, Committer, NULL)==0);
+  for(uint32_t counter=0; counter<WRITES; counter++)
+  {
+    // Mostly take over frames only, to hit the commits as often as possible; every so often write one to the chain.
+    if((counter%SWAPSPERWRITE)>0)
+      ShiftRegisterSwapFrame(Register);
+    else
+    {
+      ShiftRegisterWrite(Register);
+      if(!Complete(Chain->Parallel))
+        Torn++;
+    }
+    if(!Complete(Output))
+      Torn++;
+    if(Output[0]!=Previous)
+      Changes++;
+    Previous=Output[0];
+  }
+  Stop=true;
+  pthread_join(Thread, NULL);
+  SHIFTREGISTER_CHECK(Torn==0);
+  SHIFTREGISTER_CHECK((Commits>0) && (Changes>0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestLatest(void)
+{
+  ShiftRegisterHostChain *Chain;
+  uint8_t *Back;
+  uint8_t Frame[2]={0x12, 0x34};
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  Register->OutputBuffer=0xa5a5;
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableDoubleBuffer(Register));
+
+  // The back buffer starts with the current output; only the last commit before a transfer is written.
+  Back=ShiftRegisterBackBuffer(Register);
+  SHIFTREGISTER_CHECK((Back[0]==0xa5) && (Back[1]==0xa5));
+  Back[0]=0x01;
+  Back[1]=0x02;
+  ShiftRegisterCommit(Register);
+  Back[1]=0x03;
+  SHIFTREGISTER_CHECK(Register->OutputBuffer==0xa5a5);
+  ShiftRegisterCommitFrame(Register, Frame);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->OutputBuffer==0x1234) && (Chain->Parallel[0]==0x12) && (Chain->Parallel[1]==0x34));
+
+  // Without a new commit the frame stays.
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->OutputBuffer==0x1234) && (Chain->Parallel[1]==0x34));
+  ShiftRegisterCommit(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x01) && (Chain->Parallel[1]==0x03));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestCommits();
+  TestLatest();
+  return(ShiftRegisterTestResult("ShiftRegisterDoubleBufferTest"));
+}
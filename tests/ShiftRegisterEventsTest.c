@@ -0,0 +1,182 @@
+/*
+
+  Host test of ShiftRegisterEvents.c on a chain of 320 inputs (40 simulated 74HC165 chips, 10 words) read once per msec of
+  virtual time. A scripted sequence of presses and releases on inputs spread over the words must produce exactly the
+  expected press, release, long press and repeat events, with their times and durations, in order. Also checks an input
+  held from the first update, the time held, a full queue and inputs that are active low on a chain of 3 octets.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterEvents.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define OCTETS                             40
+#define LONGPRESSMS                        500
+#define REPEATMS                           100
+#define DURATIONMS                         1700
+
+
+typedef struct
+{
+  uint32_t TimeMS;
+  uint16_t Pin;
+  bool Level;
+} Change;
+
+// The presses and releases, in msec from the start; pin 319 is held from the first update.
+static const Change Script[]=
+{
+  {100, 5, true}, {250, 5, false},
+  {400, 300, true}, {1230, 300, false},
+  {700, 319, false},
+  {950, 160, true}, {1500, 160, false},
+  {1600, 33, true}, {1600, 200, true}, {1650, 33, false}, {1650, 200, false}
+};
+
+// The events expected, in order.
+static const ShiftRegisterEvent Expected[]=
+{
+  {5, SHIFTREGISTER_EVENT_PRESS, 100, 0},
+  {5, SHIFTREGISTER_EVENT_RELEASE, 250, 150},
+  {300, SHIFTREGISTER_EVENT_PRESS, 400, 0},
+  {319, SHIFTREGISTER_EVENT_RELEASE, 700, 700},
+  {300, SHIFTREGISTER_EVENT_LONGPRESS, 900, 500},
+  {160, SHIFTREGISTER_EVENT_PRESS, 950, 0},
+  {300, SHIFTREGISTER_EVENT_REPEAT, 1000, 600},
+  {300, SHIFTREGISTER_EVENT_REPEAT, 1100, 700},
+  {300, SHIFTREGISTER_EVENT_REPEAT, 1200, 800},
+  {300, SHIFTREGISTER_EVENT_RELEASE, 1230, 830},
+  {160, SHIFTREGISTER_EVENT_LONGPRESS, 1450, 500},
+  {160, SHIFTREGISTER_EVENT_RELEASE, 1500, 550},
+  {33, SHIFTREGISTER_EVENT_PRESS, 1600, 0},
+  {200, SHIFTREGISTER_EVENT_PRESS, 1600, 0},
+  {33, SHIFTREGISTER_EVENT_RELEASE, 1650, 50},
+  {200, SHIFTREGISTER_EVENT_RELEASE, 1650, 50}
+};
+
+
+void SetPin(ShiftRegisterHostChain *Chain, uint16_t Pin, bool Level)
+{
+  if(Level)
+    Chain->Parallel[Pin/8]|=(0x80 >> (Pin%8));
+  else
+    Chain->Parallel[Pin/8]&=~(0x80 >> (Pin%8));
+}
+
+
+// Wait until the start of the next msec, so the updates are at whole msecs. Returns the time in msec.
+uint32_t AlignMS(void)
+{
+  sleep_us(1000-time_us_64()%1000);
+  return((uint32_t)(time_us_64()/1000));
+}
+
+
+void TestScript(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  ShiftRegisterEvents *Events;
+  ShiftRegisterEvent Event;
+  uint32_t StartMS, Index=0, HeldMS=0;
+  bool Matches=true;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(2, 5, 4, OCTETS);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_INPUT, 2, 5, 0, 4, OCTETS, NULL, NULL);
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  Events=ShiftRegisterEventsCreate(Register, LONGPRESSMS, REPEATMS);
+  SHIFTREGISTER_CHECK((Events!=NULL) && (Events->Words==10));
+  if(Events==NULL)
+    return;
+  SetPin(Chain, 319, true);
+
+  // One read and update per msec; the events of every update are compared with the expected ones.
+  StartMS=AlignMS();
+  for(uint32_t TimeMS=0; TimeMS<=DURATIONMS; TimeMS++)
+  {
+    if(time_us_64()<(StartMS+TimeMS)*1000ull)
+      sleep_us((StartMS+TimeMS)*1000ull-time_us_64());
+    for(uint8_t counter=0; counter<sizeof(Script)/sizeof(Change); counter++)
+      if(Script[counter].TimeMS==TimeMS)
+        SetPin(Chain, Script[counter].Pin, Script[counter].Level);
+    ShiftRegisterRead(Register);
+    ShiftRegisterEventsUpdate(Events, NULL);
+    if(TimeMS==1000)
+      HeldMS=ShiftRegisterEventsHeldMS(Events, 300);
+    while(ShiftRegisterEventsPoll(Events, &Event))
+    {
+      Matches&=(Index<sizeof(Expected)/sizeof(ShiftRegisterEvent));
+      if(!Matches)
+        break;
+      Matches&=(Event.Pin==Expected[Index].Pin) && (Event.Type==Expected[Index].Type);
+      Matches&=(Event.TimeMS-StartMS==Expected[Index].TimeMS) && (Event.DurationMS==Expected[Index].DurationMS);
+      Index++;
+    }
+  }
+  SHIFTREGISTER_CHECK(Matches && (Index==sizeof(Expected)/sizeof(ShiftRegisterEvent)));
+  SHIFTREGISTER_CHECK((HeldMS==600) && (ShiftRegisterEventsHeldMS(Events, 300)==0) && (ShiftRegisterEventsHeldMS(Events, OCTETS*8)==0));
+  SHIFTREGISTER_CHECK(Events->Dropped==0);
+
+  // Pressing 40 inputs at once posts 40 events; the queue holds SHIFTREGISTER_EVENTS_QUEUESIZE of them.
+  for(uint16_t Pin=0; Pin<OCTETS*8; Pin+=8)
+    SetPin(Chain, Pin, true);
+  ShiftRegisterRead(Register);
+  ShiftRegisterEventsUpdate(Events, NULL);
+  SHIFTREGISTER_CHECK(Events->Dropped==OCTETS-SHIFTREGISTER_EVENTS_QUEUESIZE);
+  SHIFTREGISTER_CHECK(ShiftRegisterEventsPoll(Events, &Event) && (Event.Pin==0) && (Event.Type==SHIFTREGISTER_EVENT_PRESS));
+  ShiftRegisterEventsDestroy(Events);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestActiveLow(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  ShiftRegisterEvents *Events;
+  ShiftRegisterEvent Event;
+  uint32_t StartMS;
+
+  // Buttons with pull-up resistors on a chain of 3 octets (InputBuffer); all inputs are high and inactive.
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(2, 5, 4, 3);
+  memset(Chain->Parallel, 0xff, 3);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 2, 5, 0, 4, 0, 3);
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  Events=ShiftRegisterEventsCreate(Register, 0, 0);
+  Events->ActiveLow=true;
+  StartMS=AlignMS();
+  ShiftRegisterRead(Register);
+  ShiftRegisterEventsUpdate(Events, NULL);
+  SHIFTREGISTER_CHECK(!ShiftRegisterEventsPoll(Events, &Event));
+
+  // Pin 23 is pulled low for 2 seconds; without long presses only the press and the release are posted.
+  SetPin(Chain, 23, false);
+  ShiftRegisterRead(Register);
+  ShiftRegisterEventsUpdate(Events, NULL);
+  SHIFTREGISTER_CHECK(ShiftRegisterEventsPoll(Events, &Event) && (Event.Pin==23) && (Event.Type==SHIFTREGISTER_EVENT_PRESS));
+  sleep_ms(2000);
+  ShiftRegisterRead(Register);
+  ShiftRegisterEventsUpdate(Events, NULL);
+  SHIFTREGISTER_CHECK(!ShiftRegisterEventsPoll(Events, &Event));
+  SetPin(Chain, 23, true);
+  ShiftRegisterRead(Register);
+  ShiftRegisterEventsUpdate(Events, NULL);
+  SHIFTREGISTER_CHECK(ShiftRegisterEventsPoll(Events, &Event) && (Event.Pin==23) && (Event.Type==SHIFTREGISTER_EVENT_RELEASE));
+  SHIFTREGISTER_CHECK((Event.TimeMS-StartMS==2000) && (Event.DurationMS==2000) && (!ShiftRegisterEventsPoll(Events, &Event)));
+  ShiftRegisterEventsDestroy(Events);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestScript();
+  TestActiveLow();
+  return(ShiftRegisterTestResult("ShiftRegisterEventsTest"));
+}
@@ -0,0 +1,82 @@
+/*
+
+  Host test of ShiftRegisterWriteFrames() on the GPIO and PIO backends, with SkipUnchanged on and counters enabled. Checks
+  that every frame is latched and counted once (also identical frames in a row), that a frame committed for double
+  buffering does not replace the frames of the sequence, that the next write is not skipped and the pacing of the latches.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#define SHIFTREGISTER_ENABLE_COUNTERS
+#define SHIFTREGISTER_ENABLE_PIO
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define FRAMES                             6
+#define INTERVALUS                         50
+
+
+// Frames of 2 octets; frames 1 and 2 and frames 3 and 4 are the same.
+static const uint8_t Frames[FRAMES*2]={0x01, 0x02, 0x11, 0x22, 0x11, 0x22, 0x33, 0x44, 0x33, 0x44, 0xa5, 0x5a};
+
+
+void TestFrames(bool UsePIO)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  ShiftRegisterCounters Counters;
+  uint32_t Latches, Performed, Skipped;
+  uint8_t Committed[2]={0xde, 0xad};
+  uint64_t StartNS;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  if(UsePIO)
+    SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 1000000));
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableDoubleBuffer(Register));
+  Register->SkipUnchanged=true;
+  Register->OutputBuffer=0x0102;
+  ShiftRegisterWrite(Register);
+
+  // Every frame is latched and counted once, the first one (equal to the last write) and the repeated ones included.
+  ShiftRegisterCommitFrame(Register, Committed);
+  ShiftRegisterResetCounters(Register);
+  Latches=Chain->Latches;
+  Performed=Register->TransfersPerformed;
+  Skipped=Register->TransfersSkipped;
+  ShiftRegisterWriteFrames(Register, Frames, FRAMES, 0);
+  ShiftRegisterGetCounters(Register, &Counters);
+  SHIFTREGISTER_CHECK(Chain->Latches-Latches==FRAMES);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed-Performed==FRAMES) && (Register->TransfersSkipped==Skipped));
+  SHIFTREGISTER_CHECK((Counters.Writes==FRAMES) && (Counters.BitsOut==FRAMES*16));
+
+  // The last frame stays, not the committed one; that is written by the next write, which is not skipped.
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xa5) && (Chain->Parallel[1]==0x5a) && (Register->OutputBuffer==0xa55a));
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xde) && (Chain->Parallel[1]==0xad) && (Chain->Latches-Latches==FRAMES+1));
+  ShiftRegisterLoadFrame(Register, Frames+(FRAMES-1)*2);
+  ShiftRegisterWriteFrames(Register, Frames+(FRAMES-1)*2, 1, 0);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Latches-Latches==FRAMES+3) && (Register->TransfersSkipped==Skipped));
+
+  // Paced; the latches are the interval apart, the first one right away. The frames have to fit in the interval.
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  StartNS=ShiftRegisterHostTimeNS();
+  ShiftRegisterWriteFrames(Register, Frames, FRAMES, INTERVALUS);
+  SHIFTREGISTER_CHECK(ShiftRegisterHostTimeNS()-StartNS>=(FRAMES-1)*INTERVALUS*1000u);
+  SHIFTREGISTER_CHECK(ShiftRegisterHostTimeNS()-StartNS<FRAMES*INTERVALUS*1000u);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xa5) && (Chain->SetupViolations+Chain->HoldViolations==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestFrames(false);
+  TestFrames(true);
+  return(ShiftRegisterTestResult("ShiftRegisterFramesTest"));
+}
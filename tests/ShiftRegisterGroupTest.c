@@ -0,0 +1,219 @@
+/*
+
+  Host test of ShiftRegisterGroup.c. The SIO stores recorded by the simulator are replayed per pin: at every rising edge of
+  the shared clock the level of every data line is collected and the time since it last changed is checked against the
+  clock delay (setup time). Checks the waveforms of chains of different lengths (shorter chains get leading zeroes), the
+  latch after the last clock pulse, the inputs read by the group, the sliced update on consecutive data lines and the 32x32
+  transpose used by it.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterGroup.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define CLOCK                              2
+#define LATCH                              4
+#define DELAYNS                            40
+#define MAXEDGES                           64
+
+
+// The waveform replayed from the SIO stores.
+static uint32_t Samples[MAXEDGES], Edges;
+static uint64_t MinSetupNS, LastFallNS, LatchRiseNS;
+
+
+// Replay the stores since the last reset of the log, starting with the levels in Levels. Collects the levels of the ports
+// at every rising edge of the clock, the shortest time between a change of a port in DataMask and the next rising edge, and
+// the last falling edge of the clock before the latch goes high.
+void Replay(uint32_t Levels, uint32_t DataMask)
+{
+  ShiftRegisterHostStore *Store;
+  uint64_t ChangedNS[SHIFTREGISTER_HOST_GPIOS];
+  uint32_t Previous;
+
+  Edges=0;
+  MinSetupNS=UINT64_MAX;
+  LastFallNS=0;
+  LatchRiseNS=0;
+  for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+    ChangedNS[gpio]=0;
+  for(uint32_t counter=0; counter<ShiftRegisterHostStoreCount; counter++)
+  {
+    Store=&ShiftRegisterHostStores[counter];
+    Previous=Levels;
+    if(Store->Register==SHIFTREGISTER_HOST_SIO_SET)
+      Levels|=Store->Mask;
+    else if(Store->Register==SHIFTREGISTER_HOST_SIO_CLR)
+      Levels&=~Store->Mask;
+    else
+      Levels^=Store->Mask;
+    for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+      if(((Levels ^ Previous)>>gpio) & 1)
+        ChangedNS[gpio]=Store->TimeNS;
+    if(((Levels & ~Previous)>>CLOCK) & 1)
+    {
+      if(Edges<MAXEDGES)
+        Samples[Edges]=Levels;
+      Edges++;
+      for(uint8_t gpio=0; gpio<SHIFTREGISTER_HOST_GPIOS; gpio++)
+        if((((DataMask>>gpio) & 1)>0) && (ChangedNS[gpio]>0) && (Store->TimeNS-ChangedNS[gpio]<MinSetupNS))
+          MinSetupNS=Store->TimeNS-ChangedNS[gpio];
+    }
+    if((((~Levels & Previous)>>CLOCK) & 1) && (LatchRiseNS==0))
+      LastFallNS=Store->TimeNS;
+    if((((Levels & ~Previous)>>LATCH) & 1) && (LatchRiseNS==0))
+      LatchRiseNS=Store->TimeNS;
+  }
+}
+
+
+// Check the level of a data line at every rising edge against the output of a chain of Octets octets, written during the
+// last clock pulses of a group of MaxOctets octets.
+bool Waveform(uint8_t GPIO, uint32_t Value, uint8_t Octets, uint8_t MaxOctets)
+{
+  uint32_t Leading=(MaxOctets-Octets)*8u, Bits=Octets*8u;
+  bool Expected;
+
+  if(Edges<MaxOctets*8u)
+    return(false);
+  for(uint32_t Edge=0; Edge<MaxOctets*8u; Edge++)
+  {
+    Expected=(Edge>=Leading) && (((Value>>(Bits-1-(Edge-Leading))) & 1)>0);
+    if((((Samples[Edge]>>GPIO) & 1)>0)!=Expected)
+      return(false);
+  }
+  return(true);
+}
+
+
+uint32_t Violations(ShiftRegisterHostChain *Chain)
+{
+  return(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations+Chain->PropagationViolations);
+}
+
+
+void TestUpdate(void)
+{
+  ShiftRegisterHostChain *Chains[4];
+  ShiftRegister *Registers[4];
+  uint32_t Levels;
+
+  // Three output chains of 1, 3 and 2 octets and an input chain of 2 octets on the same clock and latch lines. The chips
+  // need more setup time than a single store.
+  ShiftRegisterHostReset();
+  Chains[0]=ShiftRegisterHostAdd595(CLOCK, 5, LATCH, SHIFTREGISTER_HOST_NOPIN, 1);
+  Chains[1]=ShiftRegisterHostAdd595(CLOCK, 6, LATCH, SHIFTREGISTER_HOST_NOPIN, 3);
+  Chains[2]=ShiftRegisterHostAdd595(CLOCK, 9, LATCH, SHIFTREGISTER_HOST_NOPIN, 2);
+  Chains[3]=ShiftRegisterHostAdd165(CLOCK, 10, LATCH, 2);
+  Chains[3]->Parallel[0]=0x81;
+  Chains[3]->Parallel[1]=0x3c;
+  for(uint8_t counter=0; counter<3; counter++)
+    Chains[counter]->SetupNS=DELAYNS-10;
+  Registers[0]=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, CLOCK, 0, 5, LATCH, 0, 1);
+  Registers[1]=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, CLOCK, 0, 6, LATCH, 0, 3);
+  Registers[2]=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, CLOCK, 0, 9, LATCH, 0, 2);
+  Registers[3]=ShiftRegisterCreate(SHIFTREGISTER_INPUT, CLOCK, 10, 0, LATCH, 0, 2);
+  for(uint8_t counter=0; counter<4; counter++)
+  {
+    ShiftRegisterSetDelayNS(Registers[counter], DELAYNS, DELAYNS);
+    Registers[counter]->Backend=SHIFTREGISTER_BACKEND_SIO;
+  }
+  Registers[0]->OutputBuffer=0xa5;
+  Registers[1]->OutputBuffer=0x123456;
+  Registers[2]->OutputBuffer=0xf00f;
+
+  Levels=sio_hw->gpio_out;
+  ShiftRegisterHostStoreCount=0;
+  SHIFTREGISTER_CHECK(ShiftRegisterGroupUpdate(Registers, 4));
+  Replay(Levels, (1u << 5) | (1u << 6) | (1u << 9));
+
+  // 24 clock pulses for the outputs, then 16 for the input; every data line is stable for the clock delay before the
+  // rising edge and the latch follows the last falling edge of the outputs.
+  SHIFTREGISTER_CHECK(Edges==24+16);
+  SHIFTREGISTER_CHECK(Waveform(5, 0xa5, 1, 3) && Waveform(6, 0x123456, 3, 3) && Waveform(9, 0xf00f, 2, 3));
+  SHIFTREGISTER_CHECK(MinSetupNS>=DELAYNS);
+  SHIFTREGISTER_CHECK((LatchRiseNS>0) && (LatchRiseNS-LastFallNS>=DELAYNS));
+  SHIFTREGISTER_CHECK((Chains[0]->Parallel[0]==0xa5) && (Chains[1]->Parallel[0]==0x12) && (Chains[1]->Parallel[2]==0x56) &&
+                      (Chains[2]->Parallel[0]==0xf0) && (Chains[2]->Parallel[1]==0x0f));
+  SHIFTREGISTER_CHECK(Registers[3]->InputBuffer==0x813c);
+  SHIFTREGISTER_CHECK(Violations(Chains[0])+Violations(Chains[1])+Violations(Chains[2])+Violations(Chains[3])==0);
+
+  // Groups that can not be updated.
+  SHIFTREGISTER_CHECK(!ShiftRegisterGroupUpdate(NULL, 0));
+  Registers[2]->Backend=SHIFTREGISTER_BACKEND_CUSTOM;
+  SHIFTREGISTER_CHECK(!ShiftRegisterGroupUpdate(Registers, 4));
+  for(uint8_t counter=0; counter<4; counter++)
+    ShiftRegisterDestroy(Registers[counter]);
+}
+
+
+void TestSliced(void)
+{
+  ShiftRegisterHostChain *Chains[3];
+  ShiftRegister *Registers[3];
+  static const uint32_t Values[3]={0xbeef, 0x0ff0, 0x8001};
+  uint32_t Levels;
+
+  // Three output chains of 2 octets on consecutive data lines.
+  ShiftRegisterHostReset();
+  for(uint8_t counter=0; counter<3; counter++)
+  {
+    Chains[counter]=ShiftRegisterHostAdd595(CLOCK, 5+counter, LATCH, SHIFTREGISTER_HOST_NOPIN, 2);
+    Chains[counter]->SetupNS=DELAYNS-10;
+    Registers[counter]=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, CLOCK, 0, 5+counter, LATCH, 0, 2);
+    ShiftRegisterSetDelayNS(Registers[counter], DELAYNS, DELAYNS);
+    Registers[counter]->OutputBuffer=Values[counter];
+  }
+  Levels=sio_hw->gpio_out;
+  ShiftRegisterHostStoreCount=0;
+  SHIFTREGISTER_CHECK(ShiftRegisterGroupUpdateSliced(Registers, 3));
+  Replay(Levels, 7u << 5);
+  SHIFTREGISTER_CHECK(Edges==16);
+  SHIFTREGISTER_CHECK(Waveform(5, Values[0], 2, 2) && Waveform(6, Values[1], 2, 2) && Waveform(7, Values[2], 2, 2));
+  SHIFTREGISTER_CHECK((MinSetupNS>=DELAYNS) && (LatchRiseNS-LastFallNS>=DELAYNS));
+  for(uint8_t counter=0; counter<3; counter++)
+    SHIFTREGISTER_CHECK((Chains[counter]->Parallel[0]==(uint8_t)(Values[counter]>>8)) &&
+                        (Chains[counter]->Parallel[1]==(uint8_t)Values[counter]) && (Violations(Chains[counter])==0));
+
+  // Data lines that are not consecutive.
+  SHIFTREGISTER_CHECK(!ShiftRegisterGroupUpdateSliced(NULL, 0));
+  Registers[1]->DataOutGPIO=9;
+  SHIFTREGISTER_CHECK(!ShiftRegisterGroupUpdateSliced(Registers, 3));
+  for(uint8_t counter=0; counter<3; counter++)
+    ShiftRegisterDestroy(Registers[counter]);
+}
+
+
+void TestTranspose(void)
+{
+  uint32_t Matrix[32], Original[32], Seed=1;
+  bool Matches=true;
+
+  // Bit (31-k) of Matrix[r] holds the original bit (31-r) of Matrix[k], for random matrices.
+  for(uint8_t round=0; round<100; round++)
+  {
+    for(uint8_t Row=0; Row<32; Row++)
+    {
+      Seed=Seed*1664525u+1013904223u;
+      Matrix[Row]=Original[Row]=Seed;
+    }
+    ShiftRegisterTranspose32(Matrix);
+    for(uint8_t Row=0; Row<32; Row++)
+      for(uint8_t Column=0; Column<32; Column++)
+        Matches&=(((Matrix[Row]>>(31-Column)) & 1)==((Original[Column]>>(31-Row)) & 1));
+  }
+  SHIFTREGISTER_CHECK(Matches);
+}
+
+
+int main()
+{
+  TestUpdate();
+  TestSliced();
+  TestTranspose();
+  return(ShiftRegisterTestResult("ShiftRegisterGroupTest"));
+}
@@ -0,0 +1,121 @@
+/*
+
+  Host test of the simulator and the GPIO transport: outputs of 74HC595 chains, inputs of 74HC165 chains, a hybrid chain
+  looped back, the virtual time consumed by a write and the detection of timing violations.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+void TestOutput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint64_t Start;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0xa55a, 2);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xa5) && (Chain->Parallel[1]==0x5a));
+  SHIFTREGISTER_CHECK((Chain->Clocks==16) && (Chain->Latches==1));
+
+  // Every bit: data, delay, clock high, delay, clock low; then the latch pulse.
+  Register->OutputBuffer=0x0180;
+  Start=ShiftRegisterHostTimeNS();
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK(ShiftRegisterHostTimeNS()-Start==16*(3*SHIFTREGISTER_HOST_GPIONS+2*5000)+2*SHIFTREGISTER_HOST_GPIONS+5000);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x01) && (Chain->Parallel[1]==0x80));
+  SHIFTREGISTER_CHECK(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations==0);
+
+  Register->InvertOutput=true;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xfe) && (Chain->Parallel[1]==0x7f));
+  ShiftRegisterFill(Register, 0);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x00) && (Chain->Parallel[1]==0x00));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestInput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(6, 7, 8, 3);
+  Chain->Parallel[0]=0x12;
+  Chain->Parallel[1]=0x34;
+  Chain->Parallel[2]=0x56;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 6, 7, 0, 8, 0, 3);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0x123456);
+  Chain->Parallel[2]=0xff;
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0x1234ff);
+  SHIFTREGISTER_CHECK(Chain->PropagationViolations+Chain->SetupViolations==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestLoopback(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 4);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, 4);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0xdeadbeef, 4);
+
+  // The inputs are loaded while the latch is low, so the second transfer reads the output of the first.
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xdeadbeef);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestViolations(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Output, *Input;
+
+  // Without delays the clock rises one port access (GPIONS) after the data changed.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 1);
+  Output=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 1);
+  ShiftRegisterSetDelayNS(Output, 0, 0);
+  Output->OutputBuffer=0x55;
+  ShiftRegisterWrite(Output);
+  SHIFTREGISTER_CHECK((Chain595->SetupViolations==0) && (Chain595->Parallel[0]==0x55));
+  Chain595->SetupNS=SHIFTREGISTER_HOST_GPIONS+1;
+  ShiftRegisterWrite(Output);
+  SHIFTREGISTER_CHECK(Chain595->SetupViolations==8);
+  SHIFTREGISTER_CHECK(Chain595->Parallel[0]!=0x55);
+  ShiftRegisterDestroy(Output);
+
+  // The data line of a 74HC165 is read one port access after the clock; too early for a slow chip.
+  Chain165=ShiftRegisterHostAdd165(6, 7, 8, 1);
+  Chain165->Parallel[0]=0x0f;
+  Chain165->PropagationNS=2*SHIFTREGISTER_HOST_GPIONS+1;
+  Input=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 6, 7, 0, 8, 0, 1);
+  ShiftRegisterSetDelayNS(Input, 0, 0);
+  ShiftRegisterRead(Input);
+  SHIFTREGISTER_CHECK(Chain165->PropagationViolations>0);
+  ShiftRegisterDestroy(Input);
+}
+
+
+int main()
+{
+  TestOutput();
+  TestInput();
+  TestLoopback();
+  TestViolations();
+  return(ShiftRegisterTestResult("ShiftRegisterHostSimulatorTest"));
+}
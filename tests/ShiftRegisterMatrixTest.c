@@ -0,0 +1,184 @@
+/*
+
+  Host test of ShiftRegisterMatrix.c on a matrix of 8 rows by 12 columns behind a chain of 3 simulated 74HC595 chips. The
+  latch pulses are recorded through a transport wrapping the GPIO transport, to check the frame of every row, the order of
+  the rows and the blanking around the row change (with and without output-enable line, active high and active low drivers).
+  The on-time of every pixel is integrated in virtual time while the driver scans from its timer: lit pixels are on for
+  their share of the refresh and unlit pixels never.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterMatrix.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define ROWS                               8
+#define COLUMNS                            12
+#define OCTETS                             3
+#define ENABLE                             6
+#define REFRESHHZ                          1000
+#define REFRESHES                          5
+#define MAXLATCHES                         64
+
+
+// The frames latched and whether the outputs were enabled at the latch pulse.
+static ShiftRegisterHostChain *Chain;
+static uint8_t Latched[MAXLATCHES][OCTETS];
+static bool LatchedEnabled[MAXLATCHES];
+static uint32_t LatchCount;
+
+
+void RecorderLatch(ShiftRegister *Register, bool High)
+{
+  ShiftRegisterGPIOTransport.Latch(Register, High);
+  if(High && (LatchCount<MAXLATCHES))
+  {
+    memcpy(Latched[LatchCount], Chain->Parallel, OCTETS);
+    LatchedEnabled[LatchCount]=ShiftRegisterHostOutputsEnabled(Chain);
+    LatchCount++;
+  }
+}
+
+
+const ShiftRegisterTransport RecorderTransport={ShiftRegisterGPIOShiftOut, ShiftRegisterGPIOShiftIn, RecorderLatch, NULL};
+
+
+// Pixel (Row, Column) is lit if it is on the diagonal or in column 11.
+bool Lit(uint16_t Row, uint16_t Column)
+{
+  return((Row==Column) || (Column==COLUMNS-1));
+}
+
+
+// The frame of a row as the drivers see it: the lit columns and the row output on, or all off for SHIFTREGISTER_MATRIX_NOROW.
+bool IsFrame(const uint8_t *Frame, uint16_t Row, bool RowActiveLow, bool ColumnActiveLow)
+{
+  uint8_t Expected[OCTETS]={0};
+
+  if(Row!=SHIFTREGISTER_MATRIX_NOROW)
+  {
+    for(uint16_t Column=0; Column<COLUMNS; Column++)
+      if(Lit(Row, Column))
+        Expected[Column/8]|=(0x80 >> (Column%8));
+    Expected[2]=(0x80 >> Row);
+  }
+  Expected[0]^=(ColumnActiveLow?0xff:0x00);
+  Expected[1]^=(ColumnActiveLow?0xff:0x00);
+  Expected[2]^=(RowActiveLow?0xff:0x00);
+  return(memcmp(Frame, Expected, OCTETS)==0);
+}
+
+
+// Scan the rows twice with ShiftRegisterMatrixStep() and check the frames latched.
+bool CheckScan(ShiftRegisterMatrix *Matrix, bool UseEnable, bool ActiveLow)
+{
+  bool Valid=true;
+  uint32_t Index=0;
+
+  LatchCount=0;
+  for(uint16_t counter=0; counter<2*ROWS; counter++)
+    ShiftRegisterMatrixStep(Matrix);
+
+  // With the output-enable line every row is latched while the outputs are disabled; without it an all-off frame is
+  // latched before every row, so a row is never followed directly by the next one.
+  Valid&=(LatchCount==(UseEnable?2:4)*ROWS);
+  for(uint16_t counter=0; (counter<2*ROWS) && Valid; counter++)
+  {
+    if(!UseEnable)
+    {
+      Valid&=IsFrame(Latched[Index], SHIFTREGISTER_MATRIX_NOROW, ActiveLow, ActiveLow) && LatchedEnabled[Index];
+      Index++;
+    }
+    Valid&=IsFrame(Latched[Index], counter%ROWS, ActiveLow, ActiveLow) && (LatchedEnabled[Index]!=UseEnable);
+    Index++;
+  }
+  return(Valid && ShiftRegisterHostOutputsEnabled(Chain));
+}
+
+
+// Scan from the timer for a number of refreshes and integrate the on-time of every pixel; a pixel is on if the outputs are
+// enabled and both its row and its column output are switched on.
+void Integrate(bool ActiveLow, uint64_t OnNS[ROWS][COLUMNS])
+{
+  uint64_t EndNS=ShiftRegisterHostTimeNS()+REFRESHES*1000000000ull/REFRESHHZ, PreviousNS;
+  uint8_t Invert=(ActiveLow?0xff:0x00);
+  bool RowOn, ColumnOn;
+
+  memset(OnNS, 0, ROWS*COLUMNS*sizeof(uint64_t));
+  while(ShiftRegisterHostTimeNS()<EndNS)
+  {
+    PreviousNS=ShiftRegisterHostTimeNS();
+    sleep_us(1);
+    if(!ShiftRegisterHostOutputsEnabled(Chain))
+      continue;
+    for(uint16_t Row=0; Row<ROWS; Row++)
+    {
+      RowOn=(((Chain->Parallel[2] ^ Invert) & (0x80 >> Row))>0);
+      for(uint16_t Column=0; (Column<COLUMNS) && RowOn; Column++)
+      {
+        ColumnOn=(((Chain->Parallel[Column/8] ^ Invert) & (0x80 >> (Column%8)))>0);
+        if(ColumnOn)
+          OnNS[Row][Column]+=ShiftRegisterHostTimeNS()-PreviousNS;
+      }
+    }
+  }
+}
+
+
+void TestMatrix(bool UseEnable, bool ActiveLow)
+{
+  ShiftRegister *Register;
+  ShiftRegisterMatrix *Matrix;
+  uint64_t OnNS[ROWS][COLUMNS], ShareNS=1000000000ull/REFRESHHZ/ROWS*REFRESHES;
+  bool Matches=true;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, (UseEnable?ENABLE:SHIFTREGISTER_HOST_NOPIN), OCTETS);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, OCTETS);
+  ShiftRegisterSetDelayNS(Register, 0, 0);
+  ShiftRegisterSetTransport(Register, &RecorderTransport, NULL);
+  SHIFTREGISTER_CHECK(ShiftRegisterMatrixCreate(Register, ROWS, 17, SHIFTREGISTER_MATRIX_NOPIN)==NULL);
+  Matrix=ShiftRegisterMatrixCreate(Register, ROWS, COLUMNS, (UseEnable?ENABLE:SHIFTREGISTER_MATRIX_NOPIN));
+  SHIFTREGISTER_CHECK(Matrix!=NULL);
+  if(Matrix==NULL)
+    return;
+  Matrix->RowActiveLow=Matrix->ColumnActiveLow=ActiveLow;
+  for(uint16_t Row=0; Row<ROWS; Row++)
+    for(uint16_t Column=0; Column<COLUMNS; Column++)
+      ShiftRegisterMatrixSetPixel(Matrix, Row, Column, Lit(Row, Column));
+  ShiftRegisterMatrixSetPixel(Matrix, ROWS, 0, true);  // Out of range; ignored.
+  SHIFTREGISTER_CHECK(ShiftRegisterMatrixGetPixel(Matrix, 3, 3) && (!ShiftRegisterMatrixGetPixel(Matrix, 3, 4)));
+
+  // The frames and the blanking, stepped by hand.
+  SHIFTREGISTER_CHECK(ShiftRegisterMatrixStart(Matrix, REFRESHHZ) && (!ShiftRegisterMatrixStart(Matrix, REFRESHHZ)));
+  SHIFTREGISTER_CHECK(Matrix->RowPeriodUS==1000000/(REFRESHHZ*ROWS));
+  SHIFTREGISTER_CHECK(CheckScan(Matrix, UseEnable, ActiveLow));
+
+  // Scanned from the timer; a lit pixel is on for its row's share of the refresh minus the row change, an unlit one never.
+  Integrate(ActiveLow, OnNS);
+  for(uint16_t Row=0; Row<ROWS; Row++)
+    for(uint16_t Column=0; Column<COLUMNS; Column++)
+      Matches&=(Lit(Row, Column)?(OnNS[Row][Column]>=ShareNS*95/100) && (OnNS[Row][Column]<=ShareNS+REFRESHES*1000):
+                                 OnNS[Row][Column]==0);
+  SHIFTREGISTER_CHECK(Matches);
+  SHIFTREGISTER_CHECK(Chain->SetupViolations+Chain->HoldViolations==0);
+
+  // Stopping switches all outputs off.
+  ShiftRegisterMatrixStop(Matrix);
+  SHIFTREGISTER_CHECK(IsFrame(Chain->Parallel, SHIFTREGISTER_MATRIX_NOROW, ActiveLow, ActiveLow));
+  ShiftRegisterMatrixDestroy(Matrix);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestMatrix(false, false);
+  TestMatrix(true, false);
+  TestMatrix(false, true);
+  TestMatrix(true, true);
+  return(ShiftRegisterTestResult("ShiftRegisterMatrixTest"));
+}
@@ -0,0 +1,167 @@
+/*
+
+  Host test of the PIO backend: the generated programs run on the emulated state machines of the simulator and move the
+  octets through the TX and RX FIFOs to 74HC595 and 74HC165 chains. Checks the outputs, the inputs, a hybrid chain looped
+  back (longer than the FIFOs), the timing at the highest bit rate, the instruction memory limits and the return to the
+  GPIO backend.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#define SHIFTREGISTER_ENABLE_PIO
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+uint32_t Violations(ShiftRegisterHostChain *Chain)
+{
+  return(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations+Chain->PropagationViolations);
+}
+
+
+void TestOutput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint64_t Start;
+  uint32_t Clocks, Latches;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 3);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 3);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 1000000));
+  SHIFTREGISTER_CHECK(Register->Backend==SHIFTREGISTER_BACKEND_PIO);
+
+  // 24 bits of 4 cycles at 1 MHz, plus the latch; the CPU waits for the completion token.
+  Register->OutputBuffer=0x123456;
+  Start=ShiftRegisterHostTimeNS();
+  Clocks=Chain->Clocks;
+  Latches=Chain->Latches;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x12) && (Chain->Parallel[1]==0x34) && (Chain->Parallel[2]==0x56));
+  SHIFTREGISTER_CHECK((Chain->Clocks-Clocks==24) && (Chain->Latches-Latches==1));
+  SHIFTREGISTER_CHECK(ShiftRegisterHostTimeNS()-Start>=24000);
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+
+  Register->InvertOutput=true;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xed) && (Chain->Parallel[1]==0xcb) && (Chain->Parallel[2]==0xa9));
+  ShiftRegisterFill(Register, 0xff);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xff) && (Chain->Parallel[1]==0xff) && (Chain->Parallel[2]==0xff));
+  SHIFTREGISTER_CHECK(ShiftRegisterHostGetStateMachine(pio0, Register->PIOStateMachine)->Stalls>0);
+
+  // Back to the GPIO backend; the ports are driven by the CPU again.
+  ShiftRegisterDisablePIO(Register);
+  Register->InvertOutput=false;
+  Register->OutputBuffer=0x0f0f0f;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->Backend==SHIFTREGISTER_BACKEND_GPIO) && (Chain->Parallel[2]==0x0f));
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestInput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(6, 7, 8, 2);
+  Chain->Parallel[0]=0xc3;
+  Chain->Parallel[1]=0x5a;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 6, 7, 0, 8, 0, 2);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio1, 2000000));
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xc35a);
+  Chain->Parallel[1]=0x01;
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xc301);
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestLoopback(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+  uint8_t Input[10], Output[10];
+
+  // 10 octets; more than the TX and RX FIFOs hold, so the CPU and the state machine take turns.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(10, 11, 12, SHIFTREGISTER_HOST_NOPIN, sizeof(Output));
+  Chain165=ShiftRegisterHostAdd165(10, 13, 12, sizeof(Input));
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  for(uint8_t counter=0; counter<sizeof(Output); counter++)
+    Output[counter]=(uint8_t)(counter*37+1);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_HYBRID, 10, 13, 11, 12, sizeof(Output), Input, Output);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 5000000));
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(memcmp(Input, Output, sizeof(Output))==0);
+  SHIFTREGISTER_CHECK(memcmp(Chain595->Parallel, Output, sizeof(Output))==0);
+  SHIFTREGISTER_CHECK((Violations(Chain595)==0) && (Violations(Chain165)==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestFullSpeed(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+
+  // The highest bit rate runs the state machine at clk_sys: 2 cycles (16 nsec) of setup time and of propagation time.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 4);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, 4);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0, 4);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 100000000));
+  Register->OutputBuffer=0xcafef00d;
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xcafef00d);
+  SHIFTREGISTER_CHECK((Violations(Chain595)==0) && (Violations(Chain165)==0));
+
+  // A slower 74HC165 reads the previous bit.
+  Chain165->PropagationNS=17;
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK((Chain165->PropagationViolations>0) && (Register->InputBuffer!=0xcafef00d));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestResources(void)
+{
+  ShiftRegister *Registers[3];
+
+  // Two hybrid programs fit in the 32 instructions of a block; the third register keeps the GPIO backend.
+  ShiftRegisterHostReset();
+  for(uint8_t counter=0; counter<3; counter++)
+    Registers[counter]=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2+counter*4, 3+counter*4, 4+counter*4, 5+counter*4, 0, 1);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Registers[0], pio0, 1000000));
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Registers[1], pio0, 1000000));
+  SHIFTREGISTER_CHECK(!ShiftRegisterEnablePIO(Registers[2], pio0, 1000000));
+  SHIFTREGISTER_CHECK(Registers[2]->Backend==SHIFTREGISTER_BACKEND_GPIO);
+
+  // Freeing a program and its state machine makes room again.
+  ShiftRegisterDisablePIO(Registers[0]);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Registers[2], pio0, 1000000));
+  for(uint8_t counter=0; counter<3; counter++)
+    ShiftRegisterDestroy(Registers[counter]);
+}
+
+
+int main()
+{
+  TestOutput();
+  TestInput();
+  TestLoopback();
+  TestFullSpeed();
+  TestResources();
+  return(ShiftRegisterTestResult("ShiftRegisterPIOTest"));
+}
@@ -0,0 +1,129 @@
+/*
+
+  Host test of the SIO backend: the stores to gpio_set, gpio_clr and gpio_togl are recorded by the simulator. Checks the
+  sequence of stores of a write, the setup time of the first bit, and reading a 74HC165 chain and a hybrid chain looped
+  back through the SIO registers.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define CLOCK                              (1u << 2)
+#define DATA                               (1u << 3)
+#define LATCH                              (1u << 4)
+
+
+uint32_t Violations(ShiftRegisterHostChain *Chain)
+{
+  return(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations+Chain->PropagationViolations);
+}
+
+
+// Check the store at Index and move to the next one.
+bool Store(uint32_t *Index, uint8_t Register, uint32_t Mask)
+{
+  ShiftRegisterHostStore *Entry=&ShiftRegisterHostStores[*Index];
+
+  (*Index)++;
+  return((Entry->Register==Register) && (Entry->Mask==Mask));
+}
+
+
+void TestSequence(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint32_t Index=0, Expected=0xa5;
+  bool InOrder=true, Current=false, Next;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 1);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 1);
+  Register->Backend=SHIFTREGISTER_BACKEND_SIO;
+  ShiftRegisterSetDelayNS(Register, 40, 40);
+  ShiftRegisterHostStoreCount=0;
+  Register->OutputBuffer=Expected;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK(Chain->Parallel[0]==0xa5);
+
+  // The first bit (1) is put on the data line, then per bit the clock goes high and low together with the next bit (if it
+  // differs); the last falling edge leaves the data line alone. Then the latch pulse.
+  InOrder&=Store(&Index, SHIFTREGISTER_HOST_SIO_TOGL, DATA);
+  for(int8_t Bit=7; Bit>=0; Bit--)
+  {
+    InOrder&=Store(&Index, SHIFTREGISTER_HOST_SIO_SET, CLOCK);
+    Current=((Expected>>Bit) & 1)>0;
+    Next=(Bit>0?((Expected>>(Bit-1)) & 1)>0:Current);
+    InOrder&=Store(&Index, SHIFTREGISTER_HOST_SIO_TOGL, (Next!=Current?CLOCK|DATA:CLOCK));
+  }
+  InOrder&=Store(&Index, SHIFTREGISTER_HOST_SIO_SET, LATCH);
+  InOrder&=Store(&Index, SHIFTREGISTER_HOST_SIO_CLR, LATCH);
+  SHIFTREGISTER_CHECK(InOrder);
+  SHIFTREGISTER_CHECK(ShiftRegisterHostStoreCount==Index);
+
+  // The first rising edge follows the first bit after the clock delay, not in the next cycle.
+  SHIFTREGISTER_CHECK(ShiftRegisterHostStores[1].TimeNS-ShiftRegisterHostStores[0].TimeNS>=40);
+  SHIFTREGISTER_CHECK((sio_hw->gpio_out & (CLOCK|LATCH))==0);
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+
+  // A chip needing more setup time than a single store still sees the first bit in time.
+  Chain->SetupNS=30;
+  Register->OutputBuffer=0x5a;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x5a) && (Violations(Chain)==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestInput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(6, 7, 8, 2);
+  Chain->Parallel[0]=0xc3;
+  Chain->Parallel[1]=0x5a;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 6, 7, 0, 8, 0, 2);
+  Register->Backend=SHIFTREGISTER_BACKEND_SIO;
+  ShiftRegisterSetDelayNS(Register, 40, 40);
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xc35a);
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestLoopback(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 4);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, 4);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0, 4);
+  Register->Backend=SHIFTREGISTER_BACKEND_SIO;
+  ShiftRegisterSetDelayNS(Register, 40, 40);
+  Register->OutputBuffer=0xcafef00d;
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xcafef00d);
+  SHIFTREGISTER_CHECK((Violations(Chain595)==0) && (Violations(Chain165)==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestSequence();
+  TestInput();
+  TestLoopback();
+  return(ShiftRegisterTestResult("ShiftRegisterSIOTest"));
+}
@@ -0,0 +1,149 @@
+/*
+
+  Host test of ShiftRegisterSPI.c: the SPI peripherals are emulated by the simulator on the ports assigned to them. Checks
+  the pin mapping (valid and invalid combinations of SCK, TX and RX on both peripherals), writing, reading and a hybrid chain
+  looped back through SPI, the bit rate, the setup time at a high bit rate and returning the pins to the GPIO backend.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#define SHIFTREGISTER_ENABLE_SPI
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+uint32_t Violations(ShiftRegisterHostChain *Chain)
+{
+  return(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations+Chain->PropagationViolations);
+}
+
+
+void TestMapping(void)
+{
+  ShiftRegister *Register;
+
+  // The peripheral follows bit 3 of the GPIO number, the function the GPIO number modulo 4.
+  SHIFTREGISTER_CHECK((ShiftRegisterSPIInstance(2, SHIFTREGISTER_SPI_SCK)==spi0) &&
+                      (ShiftRegisterSPIInstance(10, SHIFTREGISTER_SPI_SCK)==spi1) &&
+                      (ShiftRegisterSPIInstance(18, SHIFTREGISTER_SPI_SCK)==spi0) &&
+                      (ShiftRegisterSPIInstance(26, SHIFTREGISTER_SPI_SCK)==spi1));
+  SHIFTREGISTER_CHECK((ShiftRegisterSPIInstance(3, SHIFTREGISTER_SPI_TX)==spi0) &&
+                      (ShiftRegisterSPIInstance(12, SHIFTREGISTER_SPI_RX)==spi1) &&
+                      (ShiftRegisterSPIInstance(28, SHIFTREGISTER_SPI_RX)==spi1));
+  SHIFTREGISTER_CHECK((ShiftRegisterSPIInstance(3, SHIFTREGISTER_SPI_SCK)==NULL) &&
+                      (ShiftRegisterSPIInstance(1, SHIFTREGISTER_SPI_RX)==NULL) &&
+                      (ShiftRegisterSPIInstance(30, SHIFTREGISTER_SPI_SCK)==NULL));
+
+  // Pins of different peripherals, pins without the right function or no bit rate; the register keeps its backend and
+  // the pins stay on SIO.
+  ShiftRegisterHostReset();
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 11, 5, 0, 1);
+  SHIFTREGISTER_CHECK(!ShiftRegisterEnableSPI(Register, 1000000) && (Register->Backend==SHIFTREGISTER_BACKEND_GPIO));
+  Register->DataOutGPIO=4;
+  SHIFTREGISTER_CHECK(!ShiftRegisterEnableSPI(Register, 1000000));
+  Register->DataOutGPIO=3;
+  SHIFTREGISTER_CHECK(!ShiftRegisterEnableSPI(Register, 0));
+  Register->ClockGPIO=1;
+  SHIFTREGISTER_CHECK(!ShiftRegisterEnableSPI(Register, 1000000));
+  SHIFTREGISTER_CHECK((ShiftRegisterHost.Peripheral[1]==0) && (ShiftRegisterHost.Peripheral[3]==0) && !spi0->Enabled);
+  ShiftRegisterDestroy(Register);
+
+  // Only the data lines used by the type of register are checked.
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 10, 12, 0, 5, 0, 1);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableSPI(Register, 1000000) && spi1->Enabled && !spi0->Enabled);
+  SHIFTREGISTER_CHECK((ShiftRegisterHost.Peripheral[10]==GPIO_FUNC_SPI) && (ShiftRegisterHost.Peripheral[12]==GPIO_FUNC_SPI));
+  ShiftRegisterDestroy(Register);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 8, 3, 5, 0, 1);
+  SHIFTREGISTER_CHECK(!ShiftRegisterEnableSPI(Register, 1000000));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestOutput(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint64_t StartNS;
+  uint32_t Clocks;
+
+  // Two octets on spi1 at 1 MHz (an even divider of 126 gives 992 kHz); 16 bit periods of about 1 usec.
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(10, 11, 5, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 10, 0, 11, 5, 0, 2);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableSPI(Register, 1000000) && (Register->Backend==SHIFTREGISTER_BACKEND_SPI));
+  SHIFTREGISTER_CHECK((spi1->BaudHz==125000000/126) && (spi1->DataBits==8) && (spi1->CPOL==SPI_CPOL_0) &&
+                      (spi1->CPHA==SPI_CPHA_0) && (spi1->Order==SPI_MSB_FIRST));
+  Register->OutputBuffer=0xbeef;
+  StartNS=ShiftRegisterHostTimeNS();
+  Clocks=Chain->Clocks;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xbe) && (Chain->Parallel[1]==0xef) && (Chain->Clocks==Clocks+16));
+  SHIFTREGISTER_CHECK((spi1->Octets==2) && (ShiftRegisterHostTimeNS()-StartNS>=16000));
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+
+  // The bit rate is rounded down to an even divider of clk_sys; at 62.5 MHz a chip with a slow setup time misses bits.
+  ShiftRegisterDisableSPI(Register);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableSPI(Register, 40000000) && (spi1->BaudHz==31250000));
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableSPI(Register, 100000000) && (spi1->BaudHz==62500000));
+  Chain->SetupNS=20;
+  Register->OutputBuffer=0x1234;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK(Chain->SetupViolations>0);
+
+  // Back on the GPIO backend the pins are driven by the CPU again.
+  ShiftRegisterDisableSPI(Register);
+  SHIFTREGISTER_CHECK((Register->Backend==SHIFTREGISTER_BACKEND_GPIO) && !spi1->Enabled);
+  SHIFTREGISTER_CHECK((ShiftRegisterHost.Peripheral[10]==0) && (ShiftRegisterHost.Peripheral[11]==0));
+  Chain->SetupNS=SHIFTREGISTER_HOST_SETUPNS;
+  Chain->SetupViolations=0;
+  Register->OutputBuffer=0xa55a;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xa5) && (Chain->Parallel[1]==0x5a) && (spi1->Octets==4));
+  SHIFTREGISTER_CHECK(Violations(Chain)==0);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestInput(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Register;
+
+  // A 74HC165 chain on spi0.
+  ShiftRegisterHostReset();
+  Chain165=ShiftRegisterHostAdd165(2, 4, 6, 2);
+  Chain165->Parallel[0]=0xc3;
+  Chain165->Parallel[1]=0x5a;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 2, 4, 0, 6, 0, 2);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableSPI(Register, 4000000));
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK((Register->InputBuffer==0xc35a) && (Violations(Chain165)==0));
+  ShiftRegisterDestroy(Register);
+
+  // A hybrid chain looped back; the second transfer reads what the first one wrote.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(18, 19, 6, SHIFTREGISTER_HOST_NOPIN, 3);
+  Chain165=ShiftRegisterHostAdd165(18, 20, 6, 3);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 18, 20, 19, 6, 0, 3);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnableSPI(Register, 10000000));
+  Register->OutputBuffer=0xa5c381;
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK((Register->InputBuffer==0xa5c381) && (spi0->Octets==12));
+  SHIFTREGISTER_CHECK((Violations(Chain595)==0) && (Violations(Chain165)==0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestMapping();
+  TestOutput();
+  TestInput();
+  return(ShiftRegisterTestResult("ShiftRegisterSPITest"));
+}
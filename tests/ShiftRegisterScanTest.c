@@ -0,0 +1,147 @@
+/*
+
+  Host test of ShiftRegisterScan.c with a chain of 2 octets (compared as one word) and a chain of 6 octets (compared 4 and
+  2 octets at a time) on simulated 74HC165 chips. A scripted sequence changes random inputs of both chains while the scan
+  runs from its timer; the events polled must be exactly the changes of every step (register, pin, level, in the order of
+  the pins) with the time of the first scan after the change. Also checks that scans without changes post nothing, that a
+  change undone before the next scan is not seen and that events are dropped and counted when the queue is full.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterScan.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define PERIODUS                           100
+#define STEPS                              40
+#define SHORTOCTETS                        2
+#define LONGOCTETS                         6
+
+
+static ShiftRegisterHostChain *Chains[2];
+static ShiftRegister *Registers[2];
+static const uint16_t Sizes[2]={SHORTOCTETS, LONGOCTETS};
+
+
+bool PinLevel(const uint8_t *Octets, uint16_t Pin)
+{
+  return((Octets[Pin/8] & (0x80 >> (Pin%8)))>0);
+}
+
+
+// Poll the events of a step and compare them with the differences between the inputs before and after it: register by
+// register in the order they were added, pin by pin.
+bool CheckEvents(ShiftRegisterScan *Scan, uint8_t Before[2][LONGOCTETS], uint64_t ChangedUS)
+{
+  ShiftRegisterScanEvent Event;
+  bool Matches=true;
+
+  for(uint8_t Number=0; Number<2; Number++)
+    for(uint16_t Pin=0; Pin<Sizes[Number]*8; Pin++)
+      if(PinLevel(Before[Number], Pin)!=PinLevel(Chains[Number]->Parallel, Pin))
+      {
+        Matches&=ShiftRegisterScanPoll(Scan, &Event);
+        Matches&=(Event.Register==Registers[Number]) && (Event.Pin==Pin) && (Event.Level==PinLevel(Chains[Number]->Parallel, Pin));
+        Matches&=(Event.TimeUS>=ChangedUS) && (Event.TimeUS<=ChangedUS+PERIODUS);
+      }
+  return(Matches && (!ShiftRegisterScanPoll(Scan, &Event)));
+}
+
+
+void TestScan(void)
+{
+  ShiftRegisterScan *Scan;
+  ShiftRegister *Output;
+  ShiftRegisterScanEvent Event;
+  uint8_t Before[2][LONGOCTETS];
+  uint32_t Seed=7, Changes=0;
+  uint64_t ChangedUS;
+  bool Matches=true;
+  uint16_t Pin;
+
+  ShiftRegisterHostReset();
+  Chains[0]=ShiftRegisterHostAdd165(2, 5, 4, SHORTOCTETS);
+  Chains[1]=ShiftRegisterHostAdd165(7, 8, 9, LONGOCTETS);
+  Chains[0]->Parallel[1]=0x81;
+  Chains[1]->Parallel[5]=0x3c;
+  Registers[0]=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 2, 5, 0, 4, 0, SHORTOCTETS);
+  Registers[1]=ShiftRegisterCreateChain(SHIFTREGISTER_INPUT, 7, 8, 0, 9, LONGOCTETS, NULL, NULL);
+  ShiftRegisterSetDelayNS(Registers[0], 0, 0);
+  ShiftRegisterSetDelayNS(Registers[1], 0, 0);
+  Output=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 10, 0, 11, 12, 0, 1);
+  Scan=ShiftRegisterScanCreate(PERIODUS);
+  SHIFTREGISTER_CHECK(Scan!=NULL);
+  if(Scan==NULL)
+    return;
+  SHIFTREGISTER_CHECK((!ShiftRegisterScanAdd(Scan, Output)) && ShiftRegisterScanAdd(Scan, Registers[0]) && ShiftRegisterScanAdd(Scan, Registers[1]));
+
+  // The first scan only records the levels; scans without changes post nothing.
+  SHIFTREGISTER_CHECK(ShiftRegisterScanStart(Scan) && (!ShiftRegisterScanStart(Scan)) && (!ShiftRegisterScanAdd(Scan, Registers[0])));
+  sleep_us(10*PERIODUS);
+  SHIFTREGISTER_CHECK((!ShiftRegisterScanPoll(Scan, &Event)) && (Registers[1]->InputOctets[5]==0x3c));
+
+  // Every step changes upto 6 random inputs of either chain, in the middle of a scan period.
+  sleep_us(PERIODUS/2);
+  for(uint32_t Step=0; Step<STEPS; Step++)
+  {
+    memcpy(Before[0], Chains[0]->Parallel, SHORTOCTETS);
+    memcpy(Before[1], Chains[1]->Parallel, LONGOCTETS);
+    Seed=Seed*1664525u+1013904223u;
+    for(uint8_t counter=0; counter<((Seed>>28) % 7); counter++)
+    {
+      Seed=Seed*1664525u+1013904223u;
+      Pin=(uint16_t)((Seed>>16) % ((SHORTOCTETS+LONGOCTETS)*8));
+      if(Pin<SHORTOCTETS*8)
+        Chains[0]->Parallel[Pin/8]^=(0x80 >> (Pin%8));
+      else
+        Chains[1]->Parallel[(Pin-SHORTOCTETS*8)/8]^=(0x80 >> (Pin%8));
+      Changes++;
+    }
+    ChangedUS=time_us_64();
+    sleep_us(2*PERIODUS);
+    Matches&=CheckEvents(Scan, Before, ChangedUS);
+  }
+  SHIFTREGISTER_CHECK(Matches && (Changes>STEPS) && (Scan->Dropped==0));
+
+  // A change undone before the next scan is not seen.
+  Chains[1]->Parallel[2]^=0x10;
+  sleep_us(PERIODUS/4);
+  Chains[1]->Parallel[2]^=0x10;
+  sleep_us(2*PERIODUS);
+  SHIFTREGISTER_CHECK(!ShiftRegisterScanPoll(Scan, &Event));
+
+  // Inverting all 64 inputs twice posts 128 events; the queue holds 64 of them and the rest is dropped.
+  for(uint8_t Round=0; Round<2; Round++)
+  {
+    for(uint8_t Number=0; Number<2; Number++)
+      for(uint16_t counter=0; counter<Sizes[Number]; counter++)
+        Chains[Number]->Parallel[counter]^=0xff;
+    sleep_us(PERIODUS);
+  }
+  SHIFTREGISTER_CHECK(Scan->Dropped==128-SHIFTREGISTER_SCAN_QUEUESIZE);
+  for(uint32_t counter=0; counter<SHIFTREGISTER_SCAN_QUEUESIZE; counter++)
+    Matches&=ShiftRegisterScanPoll(Scan, &Event);
+  SHIFTREGISTER_CHECK(Matches && (!ShiftRegisterScanPoll(Scan, &Event)));
+
+  // The input buffers have the latest levels; after stopping, no more scans are done.
+  SHIFTREGISTER_CHECK((Registers[0]->InputBuffer==(((uint32_t)Chains[0]->Parallel[0]<<8) | Chains[0]->Parallel[1])));
+  SHIFTREGISTER_CHECK(memcmp(Registers[1]->InputOctets, Chains[1]->Parallel, LONGOCTETS)==0);
+  ShiftRegisterScanStop(Scan);
+  Chains[0]->Parallel[0]^=0x01;
+  sleep_us(2*PERIODUS);
+  SHIFTREGISTER_CHECK(!ShiftRegisterScanPoll(Scan, &Event));
+  ShiftRegisterScanDestroy(Scan);
+  ShiftRegisterDestroy(Registers[0]);
+  ShiftRegisterDestroy(Registers[1]);
+  ShiftRegisterDestroy(Output);
+}
+
+
+int main()
+{
+  TestScan();
+  return(ShiftRegisterTestResult("ShiftRegisterScanTest"));
+}
@@ -0,0 +1,115 @@
+/*
+
+  Host test of ShiftRegisterService.c: the worker runs on core1 (a thread) and handles all traffic to the simulator; this
+  thread (core0) only submits requests and polls results, so it never touches the simulator while the service runs. Checks
+  the order of the results, the tickets, more requests than the rings hold, the inputs returned and the requests refused.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include <sched.h>
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegisterService.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define REQUESTS                           100
+
+
+// Wait until the worker has handled all requests.
+void WaitForWorker(void)
+{
+  while(ShiftRegisterServicePending()>0)
+    sched_yield();
+}
+
+
+void TestService(void)
+{
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Output, *Input, *Other;
+  ShiftRegisterServiceResult Result;
+  uint32_t Submitted=0, Received=0, Refused=0;
+  bool InOrder=true;
+
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Chain165=ShiftRegisterHostAdd165(6, 7, 8, 2);
+  Chain165->Parallel[0]=0xc3;
+  Chain165->Parallel[1]=0x5a;
+  Output=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  Input=ShiftRegisterCreate(SHIFTREGISTER_INPUT, 6, 7, 0, 8, 0, 2);
+  Other=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 10, 0, 11, 12, 0, 1);
+  SHIFTREGISTER_CHECK(ShiftRegisterServiceAdd(Output) && ShiftRegisterServiceAdd(Input));
+
+  // Nothing is accepted before the service runs, or for registers that are not registered.
+  SHIFTREGISTER_CHECK(!ShiftRegisterServiceUpdate(Output, 0));
+  ShiftRegisterServiceStart();
+  SHIFTREGISTER_CHECK(!ShiftRegisterServiceUpdate(Other, 0));
+
+  // More requests than both rings hold; a full request ring refuses the request until results are taken.
+  while(Received<REQUESTS)
+  {
+    if(Submitted<REQUESTS)
+    {
+      if(ShiftRegisterServiceWrite(Output, Submitted, Submitted))
+        Submitted++;
+      else
+        Refused++;
+    }
+    if((Submitted==REQUESTS) || (Refused>0))
+      while(ShiftRegisterServicePoll(&Result))
+      {
+        InOrder&=((Result.Ticket==Received) && (Result.Register==Output) && (Result.Operation==SHIFTREGISTER_SERVICE_WRITE));
+        Received++;
+      }
+    sched_yield();
+  }
+  SHIFTREGISTER_CHECK(InOrder);
+  SHIFTREGISTER_CHECK((Submitted==REQUESTS) && (Refused>0));
+
+  // The worker waits for room in the result ring; the results of all requests arrive once they are taken.
+  for(uint32_t counter=0; counter<SHIFTREGISTER_SERVICE_QUEUESIZE*2; counter++)
+    while(!ShiftRegisterServiceFill(Output, 0xff, counter))
+      sched_yield();
+  while(ShiftRegisterServicePending()!=SHIFTREGISTER_SERVICE_QUEUESIZE)
+    sched_yield();
+  Received=0;
+  InOrder=true;
+  while(Received<SHIFTREGISTER_SERVICE_QUEUESIZE*2)
+    if(ShiftRegisterServicePoll(&Result))
+      InOrder&=(Result.Ticket==Received++);
+  SHIFTREGISTER_CHECK(InOrder && (ShiftRegisterServicePending()==0));
+
+  // The input read by the worker is returned in the result.
+  SHIFTREGISTER_CHECK(ShiftRegisterServiceUpdate(Input, 1234));
+  WaitForWorker();
+  SHIFTREGISTER_CHECK(ShiftRegisterServicePoll(&Result) && (Result.Ticket==1234) && (Result.InputBuffer==0xc35a));
+  SHIFTREGISTER_CHECK(!ShiftRegisterServicePoll(&Result));
+
+  // Stopping handles the requests still pending; after that nothing is accepted.
+  ShiftRegisterServiceWrite(Output, 0xbeef, 0);
+  ShiftRegisterServiceStop();
+  SHIFTREGISTER_CHECK(!ShiftRegisterServiceWrite(Output, 0, 0));
+  SHIFTREGISTER_CHECK((Chain595->Parallel[0]==0xbe) && (Chain595->Parallel[1]==0xef));
+  SHIFTREGISTER_CHECK(Chain595->SetupViolations+Chain595->HoldViolations+Chain595->PulseWidthViolations==0);
+
+  // The service can be started again.
+  ShiftRegisterServiceStart();
+  SHIFTREGISTER_CHECK(ShiftRegisterServiceWrite(Output, 0x1234, 7));
+  WaitForWorker();
+  SHIFTREGISTER_CHECK(ShiftRegisterServicePoll(&Result) && (Result.Ticket==7));
+  ShiftRegisterServiceStop();
+  SHIFTREGISTER_CHECK(Chain595->Parallel[1]==0x34);
+  ShiftRegisterDestroy(Output);
+  ShiftRegisterDestroy(Input);
+  ShiftRegisterDestroy(Other);
+}
+
+
+int main()
+{
+  TestService();
+  return(ShiftRegisterTestResult("ShiftRegisterServiceTest"));
+}
@@ -0,0 +1,132 @@
+/*
+
+  Host test of ShiftRegisterSimulator.c used as the transport of a register. Checks writing, reading and the pulses counted,
+  that the inputs are loaded while the latch line is low, that skipped writes cost no pulses, that ShiftRegisterPulseLatch()
+  uses the transport, and that a long hybrid chain looped back through the transport ends up in the same state as the same
+  chips on the simulated ports driven by the GPIO backend.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterSimulator.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define OCTETS                             6
+#define ROUNDS                             50
+
+
+void TestTransport(void)
+{
+  ShiftRegisterSimulator *Simulator;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Simulator=ShiftRegisterSimulatorCreate(2, 2);
+  SHIFTREGISTER_CHECK(Simulator!=NULL);
+  if(Simulator==NULL)
+    return;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, 0, 2);
+  ShiftRegisterSetTransport(Register, &ShiftRegisterSimulatorTransport, Simulator);
+
+  // A write costs a clock pulse per bit and one latch pulse.
+  Register->OutputBuffer=0xbeef;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Simulator->Outputs[0]==0xbe) && (Simulator->Outputs[1]==0xef));
+  SHIFTREGISTER_CHECK((Simulator->Clocks==16) && (Simulator->Latches==1));
+
+  // The inputs are loaded while the latch line is low, so changes before the read are seen.
+  Simulator->Inputs[0]=0xc3;
+  Simulator->Inputs[1]=0x5a;
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK(Register->InputBuffer==0xc35a);
+  Simulator->Inputs[1]=0x81;
+  ShiftRegisterRead(Register);
+  SHIFTREGISTER_CHECK((Register->InputBuffer==0xc381) && (Simulator->Clocks==48) && (Simulator->Latches==3));
+
+  // Unchanged writes are skipped without any pulses; a fill is always performed.
+  Register->SkipUnchanged=true;
+  ShiftRegisterWrite(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Simulator->Clocks==64) && (Simulator->Latches==4));
+  ShiftRegisterFill(Register, 1);
+  SHIFTREGISTER_CHECK((Simulator->Outputs[0]==0xff) && (Simulator->Outputs[1]==0xff) && (Simulator->Clocks==80));
+
+  // ShiftRegisterPulseLatch() pulses the latch line through the transport of the register.
+  ShiftRegisterPulseLatch(Register);
+  SHIFTREGISTER_CHECK((Simulator->Clocks==80) && (Simulator->Latches==6));
+
+  // The chains are not connected to the ports.
+  SHIFTREGISTER_CHECK((Simulator->SIPO.SetupViolations==0) && (Simulator->PISO.PropagationViolations==0));
+  ShiftRegisterDestroy(Register);
+  ShiftRegisterSimulatorDestroy(Simulator);
+
+  // Output only.
+  Simulator=ShiftRegisterSimulatorCreate(1, 0);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 1);
+  ShiftRegisterSetTransport(Register, &ShiftRegisterSimulatorTransport, Simulator);
+  Register->OutputBuffer=0x42;
+  ShiftRegisterUpdate(Register);
+  SHIFTREGISTER_CHECK((Simulator->Outputs[0]==0x42) && (Simulator->Inputs==NULL));
+  ShiftRegisterDestroy(Register);
+  ShiftRegisterSimulatorDestroy(Simulator);
+}
+
+
+void TestMatchesPorts(void)
+{
+  ShiftRegisterSimulator *Simulator;
+  ShiftRegisterHostChain *Chain595, *Chain165;
+  ShiftRegister *Simulated, *Wired;
+  uint32_t Seed=1, ClocksSimulated, ClocksWired;
+  bool Matches=true;
+
+  // The same looped back hybrid chain, once through the transport and once on the ports.
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, OCTETS);
+  Chain165=ShiftRegisterHostAdd165(2, 5, 4, OCTETS);
+  ShiftRegisterHostLoopback(Chain165, Chain595);
+  Wired=ShiftRegisterCreateChain(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, OCTETS, NULL, NULL);
+  Simulator=ShiftRegisterSimulatorCreate(OCTETS, OCTETS);
+  ShiftRegisterHostLoopback(&Simulator->PISO, &Simulator->SIPO);
+  Simulated=ShiftRegisterCreateChain(SHIFTREGISTER_HYBRID, 10, 13, 11, 12, OCTETS, NULL, NULL);
+  ShiftRegisterSetTransport(Simulated, &ShiftRegisterSimulatorTransport, Simulator);
+  ClocksSimulated=Simulator->Clocks;
+  ClocksWired=Chain595->Clocks;
+
+  for(uint8_t round=0; round<ROUNDS; round++)
+  {
+    for(uint8_t counter=0; counter<OCTETS; counter++)
+    {
+      Seed=Seed*1664525u+1013904223u;
+      Simulated->OutputOctets[counter]=Wired->OutputOctets[counter]=(uint8_t)(Seed>>24);
+    }
+    if((round%10)==9)
+    {
+      ShiftRegisterFill(Simulated, round & 1);
+      ShiftRegisterFill(Wired, round & 1);
+    }
+    else
+    {
+      ShiftRegisterReadWrite(Simulated);
+      ShiftRegisterReadWrite(Wired);
+    }
+    Matches&=(memcmp(Simulator->Outputs, Chain595->Parallel, OCTETS)==0);
+    Matches&=(memcmp(Simulated->InputOctets, Wired->InputOctets, OCTETS)==0);
+  }
+  SHIFTREGISTER_CHECK(Matches);
+  SHIFTREGISTER_CHECK(Simulator->Clocks-ClocksSimulated==Chain595->Clocks-ClocksWired);
+  SHIFTREGISTER_CHECK(Chain595->SetupViolations+Chain595->HoldViolations+Chain165->PropagationViolations==0);
+  ShiftRegisterDestroy(Simulated);
+  ShiftRegisterDestroy(Wired);
+  ShiftRegisterSimulatorDestroy(Simulator);
+}
+
+
+int main()
+{
+  TestTransport();
+  TestMatchesPorts();
+  return(ShiftRegisterTestResult("ShiftRegisterSimulatorTest"));
+}
@@ -0,0 +1,140 @@
+/*
+
+  Host test of SkipUnchanged: writes of an unchanged output are skipped and counted, changes of the output, of InvertOutput
+  and ForceUpdate are written, and without SkipUnchanged every write is performed without keeping the last value.
+  Checked on a chain in OutputBuffer and on a chain of more than 4 octets. On hybrid chains ShiftRegisterReadWrite() is
+  always performed and the next write is compared with the output it latched.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+
+void TestBuffer(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint32_t Latches;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  Latches=Chain->Latches;
+
+  // Without SkipUnchanged every write is performed and the last value is not kept.
+  Register->OutputBuffer=0x1234;
+  Register->TransfersPerformed=0;
+  ShiftRegisterWrite(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==2) && (Register->TransfersSkipped==0) && (Chain->Latches==Latches+2));
+  SHIFTREGISTER_CHECK((!Register->LastOutputValid) && (Register->LastOutputBuffer!=0x1234));
+
+  // The first write after enabling it is performed; the same output again is skipped.
+  Register->SkipUnchanged=true;
+  ShiftRegisterWrite(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==3) && (Register->TransfersSkipped==1) && (Chain->Latches==Latches+3));
+
+  // A changed output, InvertOutput or ForceUpdate is written.
+  Register->OutputBuffer=0x1235;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==4) && (Chain->Parallel[1]==0x35));
+  Register->InvertOutput=true;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==5) && (Chain->Parallel[1]==0xca));
+  Register->ForceUpdate=true;
+  ShiftRegisterWrite(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==6) && (Register->TransfersSkipped==2) && (!Register->ForceUpdate));
+
+  // Fill writes outside the shadow, so the next write is performed.
+  ShiftRegisterFill(Register, 0);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==7) && (Chain->Parallel[1]==0xca));
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestOctets(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint8_t Output[6]={1, 2, 3, 4, 5, 6};
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, sizeof(Output));
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, sizeof(Output), NULL, Output);
+
+  // Without SkipUnchanged the output is not copied.
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[5]==6) && (Register->LastOutputOctets[5]==0));
+
+  Register->SkipUnchanged=true;
+  Register->TransfersPerformed=0;
+  ShiftRegisterWrite(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==1) && (Register->TransfersSkipped==1) && (Register->LastOutputOctets[5]==6));
+  Output[5]=7;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==2) && (Chain->Parallel[5]==7));
+  ShiftRegisterDestroy(Register);
+}
+
+
+// Set the last octet shifted out, in OutputBuffer or OutputOctets.
+void SetLastOctet(ShiftRegister *Register, uint8_t Value)
+{
+  if(Register->SizeInOctets>MAX_SIZEINOCTETS)
+    Register->OutputOctets[Register->SizeInOctets-1]=Value;
+  else
+    Register->OutputBuffer=(Register->OutputBuffer & ~0xffu) | Value;
+}
+
+
+void TestHybrid(uint16_t SizeInOctets)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint32_t Performed, Skipped;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, SizeInOctets);
+  ShiftRegisterHostAdd165(2, 5, 4, SizeInOctets);
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_HYBRID, 2, 5, 3, 4, SizeInOctets, NULL, NULL);
+  Register->SkipUnchanged=true;
+  Performed=Register->TransfersPerformed;
+  Skipped=Register->TransfersSkipped;
+
+  // Write 0xa5, read-write 0x3c and write 0xa5 again; the last write is not skipped.
+  SetLastOctet(Register, 0xa5);
+  ShiftRegisterWrite(Register);
+  SetLastOctet(Register, 0x3c);
+  ShiftRegisterReadWrite(Register);
+  SHIFTREGISTER_CHECK(Chain->Parallel[SizeInOctets-1]==0x3c);
+  SetLastOctet(Register, 0xa5);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK(Chain->Parallel[SizeInOctets-1]==0xa5);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==Performed+3) && (Register->TransfersSkipped==Skipped));
+
+  // A read-write is always performed; a write of the output it latched is skipped.
+  ShiftRegisterReadWrite(Register);
+  ShiftRegisterUpdate(Register);
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Register->TransfersPerformed==Performed+5) && (Register->TransfersSkipped==Skipped+1));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestBuffer();
+  TestOctets();
+  TestHybrid(1);
+  TestHybrid(6);
+  return(ShiftRegisterTestResult("ShiftRegisterSkipTest"));
+}
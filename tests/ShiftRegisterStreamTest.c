@@ -0,0 +1,175 @@
+/*
+
+  Host test of ShiftRegisterStream.c: the frames are fed by the emulated DMA channels into the PIO state machine, paced by a
+  repeating timer, and completed by the DMA interrupt. Checks the frames latched by the chain, the ring order, the pacing,
+  overruns, the frames initialized with the output, SkipUnchanged after streaming and the release of the DMA channels when
+  the stream can not be created.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+
+// Allocations fail once FailAfter reaches 0; -1 never fails.
+static int FailAfter=-1;
+
+void *TestMalloc(size_t Size)
+{
+  if((FailAfter>=0) && (FailAfter--==0))
+    return(NULL);
+  return(malloc(Size));
+}
+
+#define malloc(Size) TestMalloc(Size)
+#include "ShiftRegisterStream.c"
+#undef malloc
+#include "tests/ShiftRegisterCheck.c"
+
+#define FRAMES                             4
+#define MAXCALLS                           16
+
+
+static ShiftRegisterHostChain *Chain;
+static uint16_t CallFrames[MAXCALLS];
+static uint8_t CallOctets[MAXCALLS][2];
+static uint64_t CallTimesNS[MAXCALLS];
+static uint8_t Calls;
+
+
+// Record the frame completed and the outputs of the chain at that moment.
+void Completed(ShiftRegisterStream *Stream, uint16_t FrameIndex)
+{
+  (void)Stream;
+  if(Calls>=MAXCALLS)
+    return;
+  CallFrames[Calls]=FrameIndex;
+  memcpy(CallOctets[Calls], Chain->Parallel, 2);
+  CallTimesNS[Calls]=ShiftRegisterHostTimeNS();
+  Calls++;
+}
+
+
+void TestStream(void)
+{
+  ShiftRegister *Register;
+  ShiftRegisterStream *Stream;
+  bool InOrder=true, Latched=true, Paced=true;
+  int64_t PeriodNS;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  SHIFTREGISTER_CHECK(ShiftRegisterEnablePIO(Register, pio0, 4000000));
+  Register->SkipUnchanged=true;
+  Register->OutputBuffer=0x0404;
+  ShiftRegisterWrite(Register);
+  Stream=ShiftRegisterStreamCreate(Register, FRAMES, 10000, Completed, NULL);
+  SHIFTREGISTER_CHECK(Stream!=NULL);
+  if(Stream==NULL)
+    return;
+  SHIFTREGISTER_CHECK((ShiftRegisterStreamFrame(Stream, FRAMES-1)[0]==15) && (ShiftRegisterStreamFrame(Stream, FRAMES-1)[2]==0x04000000));
+  for(uint16_t counter=0; counter<FRAMES; counter++)
+    ShiftRegisterStreamSetFrame(Stream, counter, 0x0101u*(counter+1));
+
+  // A frame every 100 usec; 10 frames in a msec, going round the ring.
+  Calls=0;
+  SHIFTREGISTER_CHECK(ShiftRegisterStreamStart(Stream));
+  sleep_us(1050);
+  ShiftRegisterStreamStop(Stream);
+  SHIFTREGISTER_CHECK((Stream->FramesSent==10) && (Calls==10) && (Stream->Overruns==0));
+  for(uint8_t counter=0; counter<Calls; counter++)
+  {
+    InOrder&=(CallFrames[counter]==counter%FRAMES);
+    Latched&=((CallOctets[counter][0]==(counter%FRAMES)+1) && (CallOctets[counter][1]==(counter%FRAMES)+1));
+    if(counter>0)
+    {
+      PeriodNS=(int64_t)(CallTimesNS[counter]-CallTimesNS[counter-1]);
+      Paced&=((PeriodNS>99900) && (PeriodNS<100100));
+    }
+  }
+  SHIFTREGISTER_CHECK(InOrder);
+  SHIFTREGISTER_CHECK(Latched);
+  SHIFTREGISTER_CHECK(Paced);
+  SHIFTREGISTER_CHECK(Chain->SetupViolations+Chain->HoldViolations+Chain->PulseWidthViolations==0);
+
+  // The frames were latched outside the SkipUnchanged shadow; the value written before the stream is written again.
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0x04) && (Chain->Parallel[1]==0x04) && (Register->TransfersSkipped==0));
+
+  // Frames changed while running are picked up by the next round.
+  ShiftRegisterStreamSetFrame(Stream, Stream->CurrentFrame, 0xbeef);
+  Calls=0;
+  ShiftRegisterStreamStart(Stream);
+  sleep_us(150);
+  ShiftRegisterStreamStop(Stream);
+  SHIFTREGISTER_CHECK((Calls>0) && (CallOctets[0][0]==0xbe) && (CallOctets[0][1]==0xef));
+  ShiftRegisterStreamDestroy(Stream);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestOverruns(void)
+{
+  ShiftRegister *Register;
+  ShiftRegisterStream *Stream;
+
+  // A frame of 16 bits at 1 MHz takes more than the 10 usec period; every other tick is skipped.
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  ShiftRegisterEnablePIO(Register, pio0, 1000000);
+  Stream=ShiftRegisterStreamCreate(Register, 2, 100000, NULL, NULL);
+  SHIFTREGISTER_CHECK(Stream!=NULL);
+  if(Stream==NULL)
+    return;
+  ShiftRegisterStreamStart(Stream);
+  sleep_us(1000);
+  ShiftRegisterStreamStop(Stream);
+  SHIFTREGISTER_CHECK((Stream->Overruns>0) && (Stream->FramesSent>0));
+  SHIFTREGISTER_CHECK(Stream->FramesSent+Stream->Overruns>=99);
+  ShiftRegisterStreamDestroy(Stream);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestCreate(void)
+{
+  ShiftRegister *Register;
+  int Channels[NUM_DMA_CHANNELS];
+  int Channel;
+
+  ShiftRegisterHostReset();
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0, 2);
+  SHIFTREGISTER_CHECK(ShiftRegisterStreamCreate(Register, 2, 1000, NULL, NULL)==NULL);  // Not using the PIO backend.
+  ShiftRegisterEnablePIO(Register, pio0, 1000000);
+
+  // Without memory the DMA channels are released again.
+  for(int counter=0; counter<2; counter++)
+  {
+    FailAfter=counter;
+    SHIFTREGISTER_CHECK(ShiftRegisterStreamCreate(Register, 2, 1000, NULL, NULL)==NULL);
+    FailAfter=-1;
+  }
+
+  // All channels are free again, so one is left after claiming the others; the first one claimed is released again.
+  for(int counter=0; counter<NUM_DMA_CHANNELS-1; counter++)
+    Channels[counter]=dma_claim_unused_channel(true);
+  SHIFTREGISTER_CHECK(ShiftRegisterStreamCreate(Register, 2, 1000, NULL, NULL)==NULL);
+  Channel=dma_claim_unused_channel(false);
+  SHIFTREGISTER_CHECK((Channel>=0) && (dma_claim_unused_channel(false)<0));
+  dma_channel_unclaim(Channel);
+  for(int counter=0; counter<NUM_DMA_CHANNELS-1; counter++)
+    dma_channel_unclaim(Channels[counter]);
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestStream();
+  TestOverruns();
+  TestCreate();
+  return(ShiftRegisterTestResult("ShiftRegisterStreamTest"));
+}
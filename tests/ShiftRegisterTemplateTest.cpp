@@ -0,0 +1,55 @@
+/*
+
+  Host test of the C++ template (ShiftRegister.hpp). The header is included in two translation units (this file and
+  ShiftRegisterTemplateTestUnit.cpp), which only link if it defines nothing but the template; the C API is included once,
+  here, and used alongside the template. Checks writes to a 74HC595 chain, reads from a 74HC165 chain and octet arrays.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "ShiftRegister.hpp"
+#include "tests/ShiftRegisterCheck.c"
+
+
+// Defined in ShiftRegisterTemplateTestUnit.cpp.
+uint16_t TemplateUnitRead();
+void TemplateUnitWrite(uint16_t Value);
+
+
+int main()
+{
+  ShiftRegisterHostChain *Chain595, *Chain165, *ChainOctets;
+  ShiftRegister *Register;
+
+  ShiftRegisterHostReset();
+  Chain595=ShiftRegisterHostAdd595(2, 3, 4, SHIFTREGISTER_HOST_NOPIN, 2);
+  Chain165=ShiftRegisterHostAdd165(6, 7, 8, 2);
+  ChainOctets=ShiftRegisterHostAdd595(10, 11, 12, SHIFTREGISTER_HOST_NOPIN, 9);
+
+  // The same instance of the template in both translation units.
+  ShiftRegisterTemplate::ShiftRegister<SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 16, false, 0, 0> Leds(0x1234);
+  SHIFTREGISTER_CHECK((Chain595->Parallel[0]==0x12) && (Chain595->Parallel[1]==0x34));
+  TemplateUnitWrite(0xa5c3);
+  SHIFTREGISTER_CHECK((Chain595->Parallel[0]==0xa5) && (Chain595->Parallel[1]==0xc3));
+
+  Chain165->Parallel[0]=0x0f;
+  Chain165->Parallel[1]=0xf1;
+  SHIFTREGISTER_CHECK(TemplateUnitRead()==0x0ff1);
+
+  // Octet arrays for chains longer than 64 bits, octet 0 shifted first.
+  ShiftRegisterTemplate::ShiftRegister<SHIFTREGISTER_OUTPUT, 10, 0, 11, 12, 72, true, 0, 0> Long;
+  for(uint8_t counter=0; counter<9; counter++)
+    Long.OutputBuffer[counter]=(uint8_t)(counter+1);
+  Long.Write();
+  SHIFTREGISTER_CHECK((ChainOctets->Parallel[0]==0xfe) && (ChainOctets->Parallel[8]==0xf6));
+
+  // The C API on the same chain.
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 0x0180, 2);
+  SHIFTREGISTER_CHECK((Chain595->Parallel[0]==0x01) && (Chain595->Parallel[1]==0x80));
+  ShiftRegisterDestroy(Register);
+  return(ShiftRegisterTestResult("ShiftRegisterTemplateTest"));
+}
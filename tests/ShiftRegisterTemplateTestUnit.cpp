@@ -0,0 +1,26 @@
+/*
+
+  Second translation unit of ShiftRegisterTemplateTest.cpp; includes the template without the simulator or the C API.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#include "ShiftRegister.hpp"
+
+
+uint16_t TemplateUnitRead()
+{
+  ShiftRegisterTemplate::ShiftRegister<SHIFTREGISTER_INPUT, 6, 7, 0, 8, 16, false, 0, 0> Buttons;
+
+  return(Buttons.InputBuffer);
+}
+
+
+void TemplateUnitWrite(uint16_t Value)
+{
+  ShiftRegisterTemplate::ShiftRegister<SHIFTREGISTER_OUTPUT, 2, 0, 3, 4, 16, false, 0, 0> Leds(Value);
+
+  Leds.Write();
+}
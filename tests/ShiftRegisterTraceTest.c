@@ -0,0 +1,213 @@
+/*
+
+  Host test of ShiftRegisterTrace.c: the VCD exported after transfers on the GPIO transport is parsed again. Checks the
+  header (one signal per port used), that the timestamps never go back and match the virtual time of the simulator, that the
+  value replayed from the data line at the rising edges of the clock is the value written and latched, that values read are
+  shown on the data input, and the export of a ring that has wrapped.
+
+  Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+  Distributed under the GPLv3 license
+
+*/
+
+#define SHIFTREGISTER_ENABLE_TRACE
+#define SHIFTREGISTER_TRACE_SIZE           256
+#include "ShiftRegisterHostSimulator.c"
+#include "ShiftRegister.c"
+#include "tests/ShiftRegisterCheck.c"
+
+#define CLOCK                              2
+#define DATAOUT                            3
+#define LATCH                              4
+#define DATAIN                             5
+#define MAXCHANGES                         1024
+
+
+typedef struct
+{
+  uint64_t TimeNS;
+  uint8_t GPIO;
+  bool Level;
+} Change;
+
+
+// The VCD parsed again: the ports declared and the changes in the order of the file.
+static uint32_t Declared, ChangeCount;
+static Change Changes[MAXCHANGES];
+static bool Monotonic;
+
+
+// Export the trace and parse it. Returns false if the file is not in the expected format.
+bool Parse(void)
+{
+  char *Text=NULL, *Line, Identifiers[128];
+  size_t Size=0;
+  FILE *File=open_memstream(&Text, &Size);
+  unsigned GPIO;
+  unsigned long long TimeNS=0, Previous=0;
+  bool Definitions=true, Valid=true;
+  char Identifier;
+
+  ShiftRegisterTraceExportVCD(File);
+  fclose(File);
+  Declared=ChangeCount=0;
+  Monotonic=true;
+  memset(Identifiers, 0xff, sizeof(Identifiers));
+  for(Line=strtok(Text, "\n"); Line!=NULL; Line=strtok(NULL, "\n"))
+  {
+    if(Definitions)
+    {
+      if(sscanf(Line, "$var wire 1 %c gpio%u $end", &Identifier, &GPIO)==2)
+      {
+        Valid&=(Identifier>0) && (GPIO<32);
+        Identifiers[(uint8_t)Identifier & 127]=(char)GPIO;
+        Declared|=(1u << GPIO);
+      }
+      Definitions=(strcmp(Line, "$end")!=0);
+    }
+    else if(Line[0]=='#')
+    {
+      Previous=TimeNS;
+      TimeNS=strtoull(Line+1, NULL, 10);
+      Monotonic&=(TimeNS>=Previous);
+    }
+    else if(((Line[0]=='0') || (Line[0]=='1')) && (Identifiers[(uint8_t)Line[1] & 127]!=(char)0xff) && (ChangeCount<MAXCHANGES))
+    {
+      Changes[ChangeCount].TimeNS=TimeNS;
+      Changes[ChangeCount].GPIO=(uint8_t)Identifiers[(uint8_t)Line[1] & 127];
+      Changes[ChangeCount].Level=(Line[0]=='1');
+      ChangeCount++;
+    }
+    else
+      Valid=false;
+  }
+  free(Text);
+  return(Valid);
+}
+
+
+// Replay the changes: the data line at every rising edge of the clock before the first rising edge of the latch, the time
+// between the first and the last change and the time of that latch edge.
+uint32_t Replay(uint8_t DataGPIO, uint32_t *Edges, uint64_t *SpanNS, uint64_t *LatchNS)
+{
+  bool Levels[32]={false}, Latched=false;
+  uint32_t Value=0;
+
+  *Edges=0;
+  *LatchNS=0;
+  for(uint32_t counter=0; counter<ChangeCount; counter++)
+  {
+    if((Changes[counter].GPIO==CLOCK) && Changes[counter].Level && (!Latched))
+    {
+      Value=(Value<<1) | Levels[DataGPIO];
+      (*Edges)++;
+    }
+    if((Changes[counter].GPIO==LATCH) && Changes[counter].Level && (!Latched))
+    {
+      *LatchNS=Changes[counter].TimeNS;
+      Latched=true;
+    }
+    Levels[Changes[counter].GPIO]=Changes[counter].Level;
+  }
+  *SpanNS=(ChangeCount>0?Changes[ChangeCount-1].TimeNS-Changes[0].TimeNS:0);
+  return(Value);
+}
+
+
+void TestWrite(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint64_t StartNS, SpanNS, LatchNS;
+  uint32_t Edges;
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd595(CLOCK, DATAOUT, LATCH, SHIFTREGISTER_HOST_NOPIN, 2);
+  Register=ShiftRegisterCreate(SHIFTREGISTER_OUTPUT, CLOCK, 0, DATAOUT, LATCH, 0, 2);
+  Register->OutputBuffer=0xa5c3;
+  ShiftRegisterTraceStart();
+  StartNS=ShiftRegisterHostTimeNS();
+  ShiftRegisterWrite(Register);
+  ShiftRegisterTraceStop();
+  SHIFTREGISTER_CHECK((Chain->Parallel[0]==0xa5) && (Chain->Parallel[1]==0xc3));
+
+  // Only the ports used are declared, and every event is in the file.
+  SHIFTREGISTER_CHECK(Parse());
+  SHIFTREGISTER_CHECK(Declared==((1u << CLOCK) | (1u << DATAOUT) | (1u << LATCH)));
+  SHIFTREGISTER_CHECK(Monotonic && (ShiftRegisterTraceCount()==ShiftRegisterTrace.Head) && (ChangeCount>16*2));
+
+  // The waveform holds the value written, followed by the latch; the timestamps follow the virtual time (in cycles).
+  SHIFTREGISTER_CHECK((Replay(DATAOUT, &Edges, &SpanNS, &LatchNS)==0xa5c3) && (Edges==16) && (LatchNS>0));
+  SHIFTREGISTER_CHECK(SpanNS+2*8>=ShiftRegisterHostTimeNS()-StartNS-2*SHIFTREGISTER_HOST_GPIONS);
+  SHIFTREGISTER_CHECK(SpanNS<=ShiftRegisterHostTimeNS()-StartNS);
+
+  // Nothing is recorded after the trace is stopped.
+  Edges=ShiftRegisterTrace.Head;
+  ShiftRegisterWrite(Register);
+  SHIFTREGISTER_CHECK(ShiftRegisterTrace.Head==Edges);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestRead(void)
+{
+  ShiftRegisterHostChain *Chain;
+  ShiftRegister *Register;
+  uint64_t SpanNS, LatchNS;
+  uint32_t Edges, Value=0;
+  bool Levels[32]={false};
+
+  ShiftRegisterHostReset();
+  Chain=ShiftRegisterHostAdd165(CLOCK, DATAIN, LATCH, 1);
+  Chain->Parallel[0]=0x96;
+  Register=ShiftRegisterCreate(SHIFTREGISTER_INPUT, CLOCK, DATAIN, 0, LATCH, 0, 1);
+  ShiftRegisterTraceStart();
+  ShiftRegisterRead(Register);
+  ShiftRegisterTraceStop();
+  SHIFTREGISTER_CHECK(Parse() && Monotonic && (Register->InputBuffer==0x96));
+  SHIFTREGISTER_CHECK((Declared & (1u << DATAIN))>0);
+
+  // The values read are on the data input, each before the rising edge that shifts to the next bit.
+  Replay(DATAIN, &Edges, &SpanNS, &LatchNS);
+  SHIFTREGISTER_CHECK(Edges==0);
+  for(uint32_t counter=0; counter<ChangeCount; counter++)
+  {
+    if((Changes[counter].GPIO==CLOCK) && Changes[counter].Level)
+      Value=(Value<<1) | Levels[DATAIN];
+    Levels[Changes[counter].GPIO]=Changes[counter].Level;
+  }
+  SHIFTREGISTER_CHECK(Value==0x96);
+  ShiftRegisterDestroy(Register);
+}
+
+
+void TestWrapped(void)
+{
+  ShiftRegister *Register;
+  uint64_t SpanNS, LatchNS;
+  uint32_t Edges;
+
+  // A chain of 32 octets needs more events than the ring holds; the oldest are dropped and the export still parses.
+  ShiftRegisterHostReset();
+  Register=ShiftRegisterCreateChain(SHIFTREGISTER_OUTPUT, CLOCK, 0, DATAOUT, LATCH, 32, NULL, NULL);
+  for(uint8_t counter=0; counter<32; counter++)
+    Register->OutputOctets[counter]=(uint8_t)(counter*37u);
+  ShiftRegisterTraceStart();
+  ShiftRegisterWrite(Register);
+  ShiftRegisterTraceStop();
+  SHIFTREGISTER_CHECK((ShiftRegisterTrace.Head>SHIFTREGISTER_TRACE_SIZE) && (ShiftRegisterTraceCount()==SHIFTREGISTER_TRACE_SIZE));
+  SHIFTREGISTER_CHECK(Parse() && Monotonic && (ChangeCount>0) && (Changes[0].TimeNS==0));
+
+  // The last octet written is at the end of the ring, just before the latch.
+  SHIFTREGISTER_CHECK((((uint8_t)Replay(DATAOUT, &Edges, &SpanNS, &LatchNS))==(uint8_t)(31u*37u)) && (LatchNS>0));
+  ShiftRegisterDestroy(Register);
+}
+
+
+int main()
+{
+  TestWrite();
+  TestRead();
+  TestWrapped();
+  return(ShiftRegisterTestResult("ShiftRegisterTraceTest"));
+}
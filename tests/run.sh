@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Build and run the host tests of the ShiftRegister library against the simulator (ShiftRegisterHostSimulator.c).
+# Every tests/*Test.c and tests/*Test.cpp is a test program; sources named after a test with a Unit suffix
+# (e.g. tests/ShiftRegisterTemplateTestUnit.cpp) are linked into it as additional translation units.
+# The tests are built with warnings as errors. Set CC/CXX to use other compilers.
+#
+#   sh tests/run.sh
+#
+# Copyright (c) 2024 Maarten Klarenbeek (https://github.com/mjklaren)
+# Distributed under the GPLv3 license
+
+cd "$(dirname "$0")/.." || exit 1
+Build=_test_build
+Flags="-DSHIFTREGISTER_HOST -Ihost -I. -Wall -Wextra -Werror -O1 -g -pthread"
+Failed=0
+Passed=0
+
+mkdir -p "$Build"
+for Source in tests/*Test.c tests/*Test.cpp
+do
+  [ -f "$Source" ] || continue
+  Name=$(basename "${Source%.*}")
+  case "$Source" in
+    *.cpp) Compiler="${CXX:-c++} -std=c++17";;
+    *)     Compiler="${CC:-cc} -std=gnu11";;
+  esac
+  Units=$(ls tests/"$Name"Unit*.c* 2>/dev/null)
+  if ! $Compiler $Flags -o "$Build/$Name" "$Source" $Units -lm
+  then
+    echo "$Name: build failed"
+    Failed=$((Failed+1))
+  elif ! "./$Build/$Name"
+  then
+    Failed=$((Failed+1))
+  else
+    Passed=$((Passed+1))
+  fi
+done
+echo "$Passed tests passed, $Failed failed"
+[ "$Failed" -eq 0 ]